@@ -57,6 +57,35 @@ const mode_t editMenuModes[] = {
 
 const int editMenuSize = sizeof(editMenuItems)/sizeof(editMenuItems[0]);
 
+// Field names of the editing screens
+const char * bioFieldNames[] = {
+    "       Name: ",
+    "Player Name: ",
+    " Base Class: ",
+    " Background: ",
+    "       Race: "
+};
+
+const char * miscFieldNames[] = {
+    "Level: ",
+    "Proficiency Bonus: ",
+    "Skill Bonus: ",
+    "Max HP: ",
+    "Current HP: ",
+    "Temporary HP: "
+};
+
+const char * weapFieldNames[] = {
+    "Name: ",
+    "Attack Bonus: ",
+    "Damage Type: ",
+    "Base Damage: ",
+    "Damage Die: ",
+    "Damage Dice Count: "
+};
+
+#define kMaxFields 6
+
 //===============================<Global State>===============================//
 // Active character data
 charData_t curChar;
@@ -77,6 +106,20 @@ int sel2 = 0;
 bool dispInitialized = false;
 dispData_t dispData;
 
+// Retained widgets of the screens (only those of the shown screen are current)
+mode_t shownMode = quit;    // The screen in the frame buffer (quit for none)
+labelWidget_t titleLabel;
+labelWidget_t statusLabel;
+menuWidget_t menuWidget;
+fieldWidget_t fields[kMaxFields];
+statGridWidget_t statGrid;
+profListWidget_t profList;
+
+// Argument values
+#define kBackendFlag "-B"
+#define kFrameRateFlag "-F"
+#define kRecordFlag "-R"
+
 //=============================<Helper Functions>=============================//
 /**
  * Loads a new current character from a specified file
@@ -132,9 +175,78 @@ int saveChar(const char * fileName) {
 void promptText(const char * prompt) {
     clearBuffer(&dispData);
     addText(&dispData, kBlackPalette, prompt, 0, 0);
-    printBuffer(dispData);
+    printBuffer(&dispData);
 
     getText(2, 0, buf, bufSize);
+
+    // The prompt drew over the screen's widgets, so rebuild it when next shown
+    shownMode = quit;
+}
+
+/**
+ * Switches the frame buffer over to a screen, if it isn't already showing
+ * 
+ * @param screen The mode whose screen to show
+ * 
+ * @return true iff the buffer was cleared (so the screen's widgets must be 
+ *         (re)initialized)
+ */
+bool showScreen(mode_t screen) {
+    if(screen == shownMode) return false;
+
+    clearBuffer(&dispData);
+    shownMode = screen;
+    return true;
+}
+
+/**
+ * Initializes a column of fields, one per line
+ * 
+ * @param names The names of the fields
+ * @param nFields The number of fields
+ * @param row The row of the first field
+ */
+void initFields(const char ** names, int nFields, int row) {
+    for(int i = 0; i < nFields && i < kMaxFields; i++) {
+        initField(&fields[i], names[i], row + i, 0, 0);
+    }
+}
+
+/**
+ * Buffers the changed lines of the first nFields fields
+ * 
+ * @param nFields The number of fields in use
+ */
+void drawFields(int nFields) {
+    for(int i = 0; i < nFields && i < kMaxFields; i++) {
+        drawWidget(&dispData, &fields[i].base);
+    }
+}
+
+/**
+ * Gets the misc property shown on a line of the misc screen
+ * 
+ * @param idx The line of the property
+ * 
+ * @return A pointer to the property (NULL if there is none on that line)
+ */
+int * getMiscRef(int idx) {
+    switch(idx) {
+        case 0:
+            return &curChar.level;
+        case 1:
+            return &curChar.profBonus;
+        case 2:
+            return &curChar.skillBonus;
+        case 3:
+            return &curChar.maxHP;
+        case 4:
+            return &curChar.curHP;
+        case 5:
+            return &curChar.tmpHP;
+        default:
+            return NULL;
+    }
 }
 
 void doMenuUpdate(bool isEdit) {
@@ -175,18 +287,48 @@ int main(int argc, char** argv) {
     int * intRef = NULL;
     char ** strRef = NULL;
 
+    // Parse the display backend, frame rate and recording flags (the other 
+    // argument names a character)
+    FILE* recordFp = NULL;
+    const dispBackend_t * backend = &kCursesBackend;
+    const char * charArg = NULL;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(kBackendFlag, argv[i]) == 0) {
+            if(++i >= argc || (backend = getDispBackend(argv[i])) == NULL) {
+                fprintf(stderr, "*FATAL ERROR* Expected a display backend (curses, ansi or null)\n");
+                return EXIT_FAILURE;
+            }
+        } else if(strcmp(kFrameRateFlag, argv[i]) == 0) {
+            char * end;
+            long fps = (++i < argc) ? strtol(argv[i], &end, 10) : -1;
+            if(fps < 0 || *end != '\0') {
+                fprintf(stderr, "*FATAL ERROR* Expected a frame rate (0 for uncapped)\n");
+                return EXIT_FAILURE;
+            }
+            setFrameRate(fps);
+        } else if(strcmp(kRecordFlag, argv[i]) == 0) {
+            if(recordFp != NULL || ++i >= argc || (recordFp = fopen(argv[i], "wb")) == NULL) {
+                fprintf(stderr, "*FATAL ERROR* Unable to open a recording file\n");
+                return EXIT_FAILURE;
+            }
+            setFrameRecord(recordFp);
+        } else {
+            charArg = argv[i];
+        }
+    }
+
     // Either pre-load a character from args or null-initialize the character
-    if(argc >= 2) {
-        loadChar(argv[1]);
+    if(charArg != NULL) {
+        loadChar(charArg);
     } 
     if (!charLoaded) {
         curChar = mkCharData();
-        if(argc >= 2) {
-            curChar.name = calloc(strlen(argv[1]) + 1, sizeof(char));
+        if(charArg != NULL) {
+            curChar.name = calloc(strlen(charArg) + 1, sizeof(char));
             if(curChar.name == NULL) {
                 fprintf(stderr, "*ERROR* Failed to allocate for provided name\n");
             } else {
-                strcpy(curChar.name, argv[1]);
+                strcpy(curChar.name, charArg);
                 charLoaded = true;
             }
         }
@@ -198,7 +340,7 @@ int main(int argc, char** argv) {
     }
 
     // Initialize the display
-    if(initDisp(&dispData) != 0) {
+    if(initDispBackend(&dispData, backend) != 0) {
         fprintf(stderr, "*FATAL ERROR* Failed to initialize display\n");
         status = EXIT_FAILURE;
         goto charCreatorCleanup;
@@ -218,8 +360,12 @@ int main(int argc, char** argv) {
 
         switch(mode) {
             case menu:  // Main menu
-                // Buffer a print of the menu
-                addMenu(&dispData, kMenuPrompt, menuItems, menuSize, menuSel);
+                // Buffer the lines of the menu which changed
+                if(showScreen(menu)) {
+                    initLabel(&titleLabel, 0, 0, 0);
+                    initMenuWidget(&menuWidget, menuItems, menuSize, 2, 0, 0);
+                    initLabel(&statusLabel, 3 + menuSize, 0, 0);
+                }
                 
                 // Also buffer a print of load status
                 if(!charLoaded) {
@@ -228,9 +374,15 @@ int main(int argc, char** argv) {
                     sprintf(buf, "Character \"%s\" loaded", 
                             (curChar.name == NULL) ? "<NULL>" : curChar.name);
                 }
-                addText(&dispData, kBlackPalette, buf, 3 + menuSize, 0);
 
-                printBuffer(dispData);
+                setLabel(&titleLabel, kBlackPalette, kMenuPrompt);
+                setMenuSel(&menuWidget, menuSel);
+                setLabel(&statusLabel, kBlackPalette, buf);
+                drawWidget(&dispData, &titleLabel.base);
+                drawWidget(&dispData, &menuWidget.base);
+                drawWidget(&dispData, &statusLabel.base);
+
+                if(shouldRender(&dispData)) printBuffer(&dispData);
 
                 doMenuUpdate(false);
                 break;
@@ -241,9 +393,18 @@ int main(int argc, char** argv) {
                     break;
                 }
                 
+                if(showScreen(edit)) {
+                    initLabel(&titleLabel, 0, 0, 0);
+                    initMenuWidget(&menuWidget, editMenuItems, editMenuSize, 2, 0, 0);
+                }
+
                 sprintf(buf, "Editing character \"%s\"", curChar.name);
-                addMenu(&dispData, buf, editMenuItems, editMenuSize, editSel);
-                printBuffer(dispData);
+                setLabel(&titleLabel, kBlackPalette, buf);
+                setMenuSel(&menuWidget, editSel);
+                drawWidget(&dispData, &titleLabel.base);
+                drawWidget(&dispData, &menuWidget.base);
+
+                if(shouldRender(&dispData)) printBuffer(&dispData);
 
                 doMenuUpdate(true);
                 if(menu != edit) {
@@ -297,22 +458,19 @@ int main(int argc, char** argv) {
                 break;
 
             case eBio:
-                // Print the current stat data
-                clearBuffer(&dispData);
-
-                sprintf(buf, "       Name: %s", (curChar.name == NULL) ? "" : curChar.name);
-                addText(&dispData, (sel == 0) ? kWhitePalette : kBlackPalette, buf, 0, 0);
-                sprintf(buf, "Player Name: %s", (curChar.playerName == NULL) ? "" : curChar.playerName);
-                addText(&dispData, (sel == 1) ? kWhitePalette : kBlackPalette, buf, 1, 0);
+                // Print the fields which changed
+                if(showScreen(eBio)) {
+                    initFields(bioFieldNames, 5, 0);
+                }
 
-                sprintf(buf, " Base Class: %s", (curChar.baseClass == NULL) ? "" : curChar.baseClass);
-                addText(&dispData, (sel == 2) ? kWhitePalette : kBlackPalette, buf, 2, 0);
-                sprintf(buf, " Background: %s", (curChar.background == NULL) ? "" : curChar.background);
-                addText(&dispData, (sel == 3) ? kWhitePalette : kBlackPalette, buf, 3, 0);
-                sprintf(buf, "       Race: %s", (curChar.race == NULL) ? "" : curChar.race);
-                addText(&dispData, (sel == 4) ? kWhitePalette : kBlackPalette, buf, 4, 0);
+                setField(&fields[0], curChar.name, sel == 0);
+                setField(&fields[1], curChar.playerName, sel == 1);
+                setField(&fields[2], curChar.baseClass, sel == 2);
+                setField(&fields[3], curChar.background, sel == 3);
+                setField(&fields[4], curChar.race, sel == 4);
+                drawFields(5);
 
-                printBuffer(dispData);
+                if(shouldRender(&dispData)) printBuffer(&dispData);
 
                 // Menu navigation
                 ch = getch();
@@ -378,9 +536,12 @@ int main(int argc, char** argv) {
                 break;
 
             case eStat:
-                clearBuffer(&dispData);
-                addStatSel(&dispData, curChar, 0, 0, false, sel);
-                printBuffer(dispData);
+                if(showScreen(eStat)) {
+                    initStatGrid(&statGrid, 0, 0, false);
+                }
+                setStatGrid(&statGrid, &curChar, sel);
+                drawWidget(&dispData, &statGrid.base);
+                if(shouldRender(&dispData)) printBuffer(&dispData);
 
                 ch = getch();
                 switch(ch) {
@@ -407,9 +568,12 @@ int main(int argc, char** argv) {
                 break;
 
             case eProf:
-                clearBuffer(&dispData);
-                addProfSel(&dispData, curChar, 0, 0, sel);
-                printBuffer(dispData);
+                if(showScreen(eProf)) {
+                    initProfList(&profList, 0, 0, dispData.screenRows);
+                }
+                setProfList(&profList, &curChar, sel);
+                drawWidget(&dispData, &profList.base);
+                if(shouldRender(&dispData)) printBuffer(&dispData);
                 
                 ch = getch();
                 switch(ch) {
@@ -432,35 +596,19 @@ int main(int argc, char** argv) {
                 break;
             
             case eMisc:
-                // Print the misc lines on the screen
-                intRef = NULL;
-                clearBuffer(&dispData);
-                
-                sprintf(buf, "Level: %d", curChar.level);
-                addText(&dispData, (sel == 0) ? kWhitePalette : kBlackPalette, buf, 0, 0);
-                if(sel == 0) intRef = &curChar.level;
-                
-                sprintf(buf, "Proficiency Bonus: %d", curChar.profBonus);
-                addText(&dispData, (sel == 1) ? kWhitePalette : kBlackPalette, buf, 1, 0);
-                if(sel == 1) intRef = &curChar.profBonus;
-
-                sprintf(buf, "Skill Bonus: %d", curChar.skillBonus);
-                addText(&dispData, (sel == 2) ? kWhitePalette : kBlackPalette, buf, 2, 0);
-                if(sel == 2) intRef = &curChar.skillBonus;
-
-                sprintf(buf, "Max HP: %d", curChar.maxHP);
-                addText(&dispData, (sel == 3) ? kWhitePalette : kBlackPalette, buf, 3, 0);
-                if(sel == 3) intRef = &curChar.maxHP;
-
-                sprintf(buf, "Current HP: %d", curChar.curHP);
-                addText(&dispData, (sel == 4) ? kWhitePalette : kBlackPalette, buf, 4, 0);
-                if(sel == 4) intRef = &curChar.curHP;
+                // Print the misc lines which changed
+                if(showScreen(eMisc)) {
+                    initFields(miscFieldNames, 6, 0);
+                }
 
-                sprintf(buf, "Temporary HP: %d", curChar.tmpHP);
-                addText(&dispData, (sel == 5) ? kWhitePalette : kBlackPalette, buf, 5, 0);
-                if(sel == 5) intRef = &curChar.tmpHP;
+                for(int i = 0; i < 6; i++) {
+                    sprintf(buf, "%d", *getMiscRef(i));
+                    setField(&fields[i], buf, sel == i);
+                }
+                drawFields(6);
+                intRef = getMiscRef(sel);
 
-                printBuffer(dispData);
+                if(shouldRender(&dispData)) printBuffer(&dispData);
 
                 // Handle input
                 ch = getch();
@@ -476,11 +624,11 @@ int main(int argc, char** argv) {
                         break;
 
                     case KEY_LEFT:
-                        *intRef -= 1;
+                        if(intRef != NULL) *intRef -= 1;
                         break;
 
                     case KEY_RIGHT:
-                        *intRef += 1;
+                        if(intRef != NULL) *intRef += 1;
                         break;
 
                     case '`':
@@ -494,31 +642,30 @@ int main(int argc, char** argv) {
             case eWeap:
                 weapRef = &curChar.weapons[sel];
 
-                // Update the display
-                clearBuffer(&dispData);
-                
-                sprintf(buf, "Weapon %d/3", sel + 1);
-                addText(&dispData, kBlackPalette, buf, 0, 0);
-
-                sprintf(buf, "Name: %s", weapRef->name);
-                addText(&dispData, (sel2 == 0) ? kWhitePalette : kBlackPalette, buf, 2, 0);
-
-                sprintf(buf, "Attack Bonus: %hhd", weapRef->atkBonus);
-                addText(&dispData, (sel2 == 1) ? kWhitePalette : kBlackPalette, buf, 3, 0);
-
-                sprintf(buf, "Damage Type: %s", weapRef->dmgType);
-                addText(&dispData, (sel2 == 2) ? kWhitePalette : kBlackPalette, buf, 4, 0);
+                // Update the lines of the display which changed
+                if(showScreen(eWeap)) {
+                    initLabel(&titleLabel, 0, 0, 0);
+                    initFields(weapFieldNames, 6, 2);
+                }
 
-                sprintf(buf, "Base Damage: %hhd", weapRef->baseDamage);
-                addText(&dispData, (sel2 == 3) ? kWhitePalette : kBlackPalette, buf, 5, 0);
+                sprintf(buf, "Weapon %d/3", sel + 1);
+                setLabel(&titleLabel, kBlackPalette, buf);
 
-                sprintf(buf, "Damage Die: %hhu", weapRef->dmgDie);
-                addText(&dispData, (sel2 == 4) ? kWhitePalette : kBlackPalette, buf, 6, 0);
+                setField(&fields[0], weapRef->name, sel2 == 0);
+                sprintf(buf, "%hhd", weapRef->atkBonus);
+                setField(&fields[1], buf, sel2 == 1);
+                setField(&fields[2], weapRef->dmgType, sel2 == 2);
+                sprintf(buf, "%hhd", weapRef->baseDamage);
+                setField(&fields[3], buf, sel2 == 3);
+                sprintf(buf, "%hhu", weapRef->dmgDie);
+                setField(&fields[4], buf, sel2 == 4);
+                sprintf(buf, "%hhu", weapRef->nDice);
+                setField(&fields[5], buf, sel2 == 5);
 
-                sprintf(buf, "Damage Dice Count: %hhu", weapRef->nDice);
-                addText(&dispData, (sel2 == 5) ? kWhitePalette : kBlackPalette, buf, 7, 0);
+                drawWidget(&dispData, &titleLabel.base);
+                drawFields(6);
 
-                printBuffer(dispData);
+                if(shouldRender(&dispData)) printBuffer(&dispData);
 
                 ch = getch();
                 switch(ch) {
@@ -609,5 +756,9 @@ charCreatorCleanup:
     if(dispInitialized) {
         closeDisp(dispData);
     }
+    if(recordFp != NULL) {
+        setFrameRecord(NULL);
+        fclose(recordFp);
+    }
     return status;
 }
\ No newline at end of file
@@ -55,12 +55,14 @@ void addStats(dispData_t * dispData, charData_t charData, int row, int col,
     addStatSel(dispData, charData, row, col, doVert, -1);
 }
 
-void addStat(dispData_t * dispData, charData_t charData, int row, int col, 
-                int idx, int sel) {
-    char buf[7];
+/**
+ * Draws a single stat's block (7 rows by 12 columns) with the given value
+ */
+static void drawStatBlock(dispData_t * dispData, int row, int col, int idx, int statVal,
+                            bool selected) {
+    char buf[12];
 
-    short palette = (idx == sel) ? kWhitePalette : kBlackPalette;
-    int statVal = getStat(charData, idx);
+    short palette = (selected) ? kWhitePalette : kBlackPalette;
     int modVal = (statVal/2)-5;
 
     addText(dispData, palette, statStrings[idx], row, col + (12 - strlen(statStrings[idx]))/2);
@@ -72,7 +74,11 @@ void addStat(dispData_t * dispData, charData_t charData, int row, int col,
     addText(dispData, palette, "+----+", row + 5, col + 3);
     sprintf(buf, "%+2d", modVal);
     addText(dispData, kBlackPalette, buf, row + 6, col + 5);
+}
 
+void addStat(dispData_t * dispData, charData_t charData, int row, int col, 
+                int idx, int sel) {
+    drawStatBlock(dispData, row, col, idx, getStat(charData, idx), idx == sel);
 }
 
 /**
@@ -97,6 +103,47 @@ void addStatSel(dispData_t * dispData, charData_t charData, int row, int col,
     }
 }
 
+/**
+ * Redraws one stat of a retained stat block
+ */
+static void drawStatGridItem(dispData_t * dispData, const widget_t * widget, int item) {
+    const statGridWidget_t * grid = (const statGridWidget_t *) widget;
+    int row = widget->row + ((grid->doVert) ? 8 * item : 0);
+    int col = widget->col + ((grid->doVert) ? 0 : 14 * item);
+
+    // Blank the block first, as the modifier may have shrunk
+    for(int y = row; y < row + 7 && y < dispData->screenRows; y++) {
+        drawPair_t * cells = dispRow(dispData, y);
+        for(int x = max(col, 0); x < col + 12 && x < dispData->screenCols; x++) {
+            cells[x] = kEmptyCell;
+        }
+    }
+
+    drawStatBlock(dispData, row, col, item, grid->stats[item], item == grid->sel);
+}
+
+void initStatGrid(statGridWidget_t * grid, int row, int col, bool doVert) {
+    if(grid == NULL) return;
+
+    initWidget(&grid->base, drawStatGridItem, kNStats, row, col, 0);
+    grid->doVert = doVert;
+    grid->sel = -1;
+    memset(grid->stats, 0, sizeof(grid->stats));
+}
+
+void setStatGrid(statGridWidget_t * grid, const charData_t * charData, int sel) {
+    if(grid == NULL || charData == NULL) return;
+
+    for(int i = 0; i < grid->base.nItems; i++) {
+        int statVal = getStat(*charData, i);
+        if(statVal != grid->stats[i] || (i == sel) != (i == grid->sel)) {
+            grid->stats[i] = statVal;
+            invalidateWidgetItem(&grid->base, i);
+        }
+    }
+    grid->sel = sel;
+}
+
 //==============================<Proficiencies>===============================//
 
 /**
@@ -125,4 +172,51 @@ void addProfSel(dispData_t * dispData, charData_t charData, int row, int col,
         addText(dispData, palette, profStrings[mini + i], row + i, col);
     }
 
-}
\ No newline at end of file
+}
+
+/**
+ * Redraws one line of a retained proficiency list
+ */
+static void drawProfListItem(dispData_t * dispData, const widget_t * widget, int item) {
+    const profListWidget_t * list = (const profListWidget_t *) widget;
+    int idx = list->first + item;
+
+    short palette = (list->profs[idx]) ? kWhitePalette : kBlackPalette;
+    if(idx == list->sel) {
+        palette = (palette == kWhitePalette) ? kGreenPalette : kRedPalette;
+    }
+
+    clearWidgetRow(dispData, widget, widget->row + item);
+    addWidgetText(dispData, widget, palette, profStrings[idx], widget->row + item, widget->col);
+}
+
+void initProfList(profListWidget_t * list, int row, int col, int nRows) {
+    if(list == NULL) return;
+
+    initWidget(&list->base, drawProfListItem, max(min(nRows, kNProfs), 0), row, col, 0);
+    list->first = 0;
+    list->sel = -1;
+    memset(list->profs, 0, sizeof(list->profs));
+}
+
+void setProfList(profListWidget_t * list, const charData_t * charData, int sel) {
+    if(list == NULL || charData == NULL) return;
+
+    // Keep the selection in the middle of the list, as far as the ends allow
+    int nLines = list->base.nItems;
+    int first = max(min(sel - nLines / 2, kNProfs - nLines), 0);
+    if(first != list->first) {
+        list->first = first;
+        invalidateWidget(&list->base);
+    }
+
+    for(int line = 0; line < nLines; line++) {
+        int idx = first + line;
+        bool held = getProfIdx(*charData, idx);
+        if(held != list->profs[idx] || (idx == sel) != (idx == list->sel)) {
+            list->profs[idx] = held;
+            invalidateWidgetItem(&list->base, line);
+        }
+    }
+    list->sel = sel;
+}
@@ -7,6 +7,23 @@
 
 #include "charData.h"
 #include "../common/dispBase.h"
+#include "../common/widget.h"
+
+// A retained stat block (one item per stat)
+typedef struct statGridWidget_s {
+    widget_t base;
+    bool doVert;                    // Stats are stacked vertically iff set
+    int sel;                        // The selected stat (<0 for none)
+    int stats[kMaxWidgetItems];     // The value of each stat as drawn
+} statGridWidget_t;
+
+// A retained, scrolling proficiency list (one item per visible line)
+typedef struct profListWidget_s {
+    widget_t base;
+    int first;                      // The proficiency on the top line
+    int sel;                        // The selected proficiency (<0 for none)
+    bool profs[kMaxWidgetItems];    // Whether each proficiency is held, as drawn
+} profListWidget_t;
 
 //==================================<Stats>===================================//
 /**
@@ -35,6 +52,26 @@ void addStats(dispData_t * dispData, charData_t charData, int row, int col,
 void addStatSel(dispData_t * dispData, charData_t charData, int row, int col, 
                     bool doVert, int sel);
 
+/**
+ * Initializes a retained stat block
+ * 
+ * @param grid The stat block to initialize
+ * @param row The top row to display it in
+ * @param col The left column to display it in
+ * @param doVert Arrange stats vertically iff this is true
+ */
+void initStatGrid(statGridWidget_t * grid, int row, int col, bool doVert);
+
+/**
+ * Updates a retained stat block, marking only the stats whose value or 
+ * selection changed to be redrawn (draw it with drawWidget)
+ * 
+ * @param grid The stat block to update
+ * @param charData The character data to display from
+ * @param sel The index of the stat to select (<0 to disable)
+ */
+void setStatGrid(statGridWidget_t * grid, const charData_t * charData, int sel);
+
 
 //==============================<Proficiencies>===============================//
 /**
@@ -50,4 +87,25 @@ void addStatSel(dispData_t * dispData, charData_t charData, int row, int col,
 void addProfSel(dispData_t * dispData, charData_t charData, int row, int col,
                 int sel);
 
+/**
+ * Initializes a retained proficiency list
+ * 
+ * @param list The list to initialize
+ * @param row The top row to display it in
+ * @param col The left column to display it in
+ * @param nRows The number of rows it may fill
+ */
+void initProfList(profListWidget_t * list, int row, int col, int nRows);
+
+/**
+ * Updates a retained proficiency list, scrolling to keep the selection in 
+ * view and marking only the lines which changed to be redrawn (every line if 
+ * it scrolled; draw it with drawWidget)
+ * 
+ * @param list The list to update
+ * @param charData The character data to display from
+ * @param sel The index of the proficiency to select (<0 to disable)
+ */
+void setProfList(profListWidget_t * list, const charData_t * charData, int sel);
+
 #endif
\ No newline at end of file
@@ -1,8 +1,154 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "dispBase.h"
 
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+
+// Set whenever the terminal may no longer match the last frame printed to it
+static bool screenStale = true;
+
+// Measurements of the frame being rendered (see beginFrame)
+static frameStats_t curStats;
+
+// The recording printed frames are written to (see setFrameRecord)
+static FILE* recordFile = NULL;
+static bool recordStarted = false;      // Set once the header is written
+static struct timespec recordStart;     // When the first frame was recorded
+
+//==================================<Helpers>=================================//
+/**
+ * Loads the word of cells starting at the given cell
+ */
+static inline uint64_t loadWord(const drawPair_t * cells) {
+    uint64_t word;
+    memcpy(&word, cells, sizeof(word));
+    return word;
+}
+
+/**
+ * Finds the first cell in [lo, hi) where two rows differ (hi if none)
+ */
+static int firstDiff(const drawPair_t * a, const drawPair_t * b, int lo, int hi) {
+    // Skip over whole matching words, then find the cell within the word
+    while(lo % kCellsPerWord != 0 && lo < hi && a[lo] == b[lo]) ++lo;
+    if(lo % kCellsPerWord == 0) {
+        while(lo + (int) kCellsPerWord <= hi && loadWord(a + lo) == loadWord(b + lo)) {
+            lo += kCellsPerWord;
+        }
+    }
+    while(lo < hi && a[lo] == b[lo]) ++lo;
+    return lo;
+}
+
+/**
+ * Finds one past the last cell in [lo, hi) where two rows differ (lo if none)
+ */
+static int lastDiff(const drawPair_t * a, const drawPair_t * b, int lo, int hi) {
+    while(hi % kCellsPerWord != 0 && hi > lo && a[hi-1] == b[hi-1]) --hi;
+    if(hi % kCellsPerWord == 0) {
+        while(hi - (int) kCellsPerWord >= lo && 
+                loadWord(a + hi - kCellsPerWord) == loadWord(b + hi - kCellsPerWord)) {
+            hi -= kCellsPerWord;
+        }
+    }
+    while(hi > lo && a[hi-1] == b[hi-1]) --hi;
+    return hi;
+}
+
+/**
+ * Writes an unsigned value out as n little-endian bytes
+ */
+static void putLE(FILE* file, uint64_t val, int n) {
+    for(int i = 0; i < n; i++) {
+        putc((val >> (8 * i)) & 0xFF, file);
+    }
+}
+
+/**
+ * Reads an unsigned value of n little-endian bytes (returning <0 at the end of
+ * the file)
+ */
+static int getLE(FILE* file, uint64_t * val, int n) {
+    *val = 0;
+    for(int i = 0; i < n; i++) {
+        int ch = getc(file);
+        if(ch == EOF) return -1;
+        *val |= (uint64_t) ch << (8 * i);
+    }
+    return 0;
+}
+
+/**
+ * Writes the dirty spans of a printed frame out to the recording
+ */
+static void recordFrame(const dispData_t * data, bool cleared) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if(!recordStarted) {
+        fwrite(kRecordMagic, sizeof(char), kRecordMagicLen, recordFile);
+        putLE(recordFile, data->screenRows, 2);
+        putLE(recordFile, data->screenCols, 2);
+        recordStart = now;
+        recordStarted = true;
+    }
+
+    uint32_t nRuns = 0;
+    for(int row = 0; row < data->screenRows; row++) {
+        if(data->dirtyLo[row] < data->dirtyHi[row]) ++nRuns;
+    }
+
+    putLE(recordFile, (uint64_t) (now.tv_sec - recordStart.tv_sec) * 1000000000 + 
+                        (now.tv_nsec - recordStart.tv_nsec), 8);
+    putLE(recordFile, (cleared) ? kRecordCleared : 0, 1);
+    putLE(recordFile, nRuns, 4);
+    for(int row = 0; row < data->screenRows; row++) {
+        int lo = data->dirtyLo[row], hi = data->dirtyHi[row];
+        if(lo >= hi) continue;
+
+        putLE(recordFile, row, 2);
+        putLE(recordFile, lo, 2);
+        putLE(recordFile, hi - lo, 2);
+        const drawPair_t * cells = dispRow(data, row);
+        for(int col = lo; col < hi; col++) {
+            putLE(recordFile, cells[col], 2);
+        }
+    }
+
+    // Keep every frame whole on disk, should the session crash
+    fflush(recordFile);
+}
+
 //=============================<Init and Cleanup>=============================//
+/**
+ * Allocates the frame buffer and damage tracking data (screen size must be set)
+ */
+static int allocBuffers(dispData_t * data) {
+    // Pad the rows out to whole words
+    data->stride = (data->screenCols + kCellsPerWord - 1) / kCellsPerWord * kCellsPerWord;
+
+    size_t nCells = (size_t) data->screenRows * data->stride;
+    data->data = calloc(nCells, sizeof(drawPair_t));
+    data->prev = calloc(nCells, sizeof(drawPair_t));
+    data->dirtyLo = calloc(data->screenRows, sizeof(int));
+    data->dirtyHi = calloc(data->screenRows, sizeof(int));
+    if(data->data == NULL || data->prev == NULL || data->dirtyLo == NULL || 
+            data->dirtyHi == NULL) {
+        return -1;
+    }
+
+    clearBuffer(data);
+    return 0;
+}
 
 int initDisp(dispData_t* data) {
+    return initDispBackend(data, &kCursesBackend);
+}
+
+int initDispBackend(dispData_t* data, const dispBackend_t * backend) {
     // Initialize curses mode
     initscr();
 
@@ -10,6 +156,12 @@ int initDisp(dispData_t* data) {
     noecho();
 
     data->data = NULL;
+    data->prev = NULL;
+    data->dirtyLo = NULL;
+    data->dirtyHi = NULL;
+    data->backend = NULL;
+    data->backendData = NULL;
+    data->termOpen = true;
 
     // Check for color and set up palette pairs
     if(!has_colors()) {
@@ -34,58 +186,304 @@ int initDisp(dispData_t* data) {
     getmaxyx(stdscr, data->screenRows, data->screenCols);
 
     // Alloc the frame buffer
-    data->data = calloc(data->screenRows, sizeof(drawPair_t *));
-    if(data->data == NULL) {
+    if(allocBuffers(data) < 0) {
         closeDisp(*data);
-        fprintf(stderr, "*ERROR* in initDisp: Unable to allocate a frame buffer (rows)\n");
+        fprintf(stderr, "*ERROR* in initDisp: Unable to allocate a frame buffer\n");
         return -1;
     }
 
-    for(int i = 0; i < data->screenRows; i++) {
-        data->data[i] = calloc(data->screenCols, sizeof(drawPair_t));
+    // Start up the output backend
+    if(backend->open(data) < 0) {
+        closeDisp(*data);
+        fprintf(stderr, "*ERROR* in initDisp: Unable to open the %s backend\n", backend->name);
+        return -1;
+    }
+    data->backend = backend;
+    screenStale = true;
 
-        if(data->data[i] == NULL) {
-            closeDisp(*data);
-            fprintf(stderr, "*ERROR* in initDisp: Unable to allocate a frame buffer (cols)\n");
-            return -1;
-        }
+    return 0;
+}
+
+int initDispBuffer(dispData_t* data, int rows, int cols) {
+    if(data == NULL || rows <= 0 || cols <= 0) {
+        return -1;
     }
 
+    data->screenRows = rows;
+    data->screenCols = cols;
+    data->backend = &kNullBackend;
+    data->backendData = NULL;
+    data->termOpen = false;
 
-    // Do final setup and return success
-    clearBuffer(data);
+    if(allocBuffers(data) < 0) {
+        closeDisp(*data);
+        return -1;
+    }
     return 0;
 }
 
+const dispBackend_t * getDispBackend(const char * name) {
+    const dispBackend_t * backends[] = {&kCursesBackend, &kAnsiBackend, &kNullBackend};
+
+    for(size_t i = 0; name != NULL && i < sizeof(backends) / sizeof(backends[0]); i++) {
+        if(strcmp(name, backends[i]->name) == 0) {
+            return backends[i];
+        }
+    }
+    return NULL;
+}
+
 int closeDisp(dispData_t data) {
-    curs_set(1);
-    endwin();
+    // Only the terminal's display owns the input thread (headless buffers, 
+    // such as cached canvases, are closed from any thread)
+    if(data.termOpen) {
+        stopInputThread();
+    }
 
-    if(data.data != NULL) {
-        for(int i = 0; i < data.screenRows; i++) {
-            if(data.data[i] != NULL) {
-                free(data.data[i]);
-                data.data[i] = NULL;
-            }
+    if(data.backend != NULL) {
+        data.backend->close(&data);
+    }
+
+    if(data.termOpen) {
+        curs_set(1);
+        endwin();
+    }
+
+    if(data.data != NULL) free(data.data);
+    if(data.prev != NULL) free(data.prev);
+    if(data.dirtyLo != NULL) free(data.dirtyLo);
+    if(data.dirtyHi != NULL) free(data.dirtyHi);
+
+    return 0;
+}
+
+//================================<Backends>==================================//
+// Curses: each run is converted to a chtype line with the colour pair folded 
+// into every cell, so a run of any palette goes out in one call
+static int cursesOpen(dispData_t * data) {
+    data->backendData = calloc(data->screenCols, sizeof(chtype));
+    return (data->backendData == NULL) ? -1 : 0;
+}
+
+static void cursesClose(dispData_t * data) {
+    if(data->backendData != NULL) free(data->backendData);
+}
+
+static void cursesClear(const dispData_t * data) {
+    (void) data;
+
+    // Keep the cursor where the caller left it (clear sends it home)
+    int row, col;
+    getyx(stdscr, row, col);
+    clear();
+    move(row, col);
+}
+
+static void cursesPutRun(const dispData_t * data, int row, int col, const drawPair_t * cells, int n) {
+    chtype * line = data->backendData;
+    for(int i = 0; i < n; i++) {
+        line[i] = (cells[i] == kEmptyCell) ? (chtype) ' ' :
+                    ((chtype) (unsigned char) drawPairCh(cells[i]) | 
+                        COLOR_PAIR(drawPairPalette(cells[i])));
+    }
+    int curRow, curCol;
+    getyx(stdscr, curRow, curCol);
+    mvwaddchnstr(stdscr, row, col, line, n);
+    move(curRow, curCol);
+    curStats.bytesWritten += n;
+}
+
+static void cursesFlush(const dispData_t * data) {
+    (void) data;
+    refresh();
+}
+
+const dispBackend_t kCursesBackend = {
+    "curses", cursesOpen, cursesClose, cursesClear, cursesPutRun, cursesFlush
+};
+
+// ANSI: the whole frame is built up as escape sequences in one byte buffer and
+// sent with a single write (curses is still used for input and prompts)
+typedef struct ansiOut_s {
+    char * buf;                 // The pending output
+    size_t len, cap;            // Bytes pending and buffer capacity
+    short palette;              // Palette selected at the end of the output
+} ansiOut_t;
+
+#define kAnsiNoPalette -1
+
+static const char * const kAnsiPalettes[] = {
+    "\033[0m",       // Empty cells
+    "\033[37;40m",   // kBlackPalette
+    "\033[30;47m",   // kWhitePalette
+    "\033[30;41m",   // kRedPalette
+    "\033[30;42m",   // kGreenPalette
+    "\033[30;44m",   // kBluePalette
+    "\033[30;43m",   // kYellowPalette
+    "\033[30;45m",   // kMagentaPalette
+    "\033[30;46m"    // kCyanPalette
+};
+
+const char * getAnsiPalette(short palette) {
+    if(palette < 0 || palette > kMaxPalette) palette = kDefPalette;
+    return kAnsiPalettes[palette];
+}
+
+static int ansiReserve(ansiOut_t * out, size_t n) {
+    if(out->len + n <= out->cap) {
+        return 0;
+    }
+
+    size_t cap = out->cap * 2;
+    while(cap < out->len + n) cap *= 2;
+
+    char * buf = realloc(out->buf, cap);
+    if(buf == NULL) {
+        return -1;
+    }
+    out->buf = buf;
+    out->cap = cap;
+    return 0;
+}
+
+static void ansiAppend(ansiOut_t * out, const char * str, size_t n) {
+    if(ansiReserve(out, n) < 0) {
+        return;
+    }
+    memcpy(out->buf + out->len, str, n);
+    out->len += n;
+}
+
+static void ansiMove(ansiOut_t * out, int row, int col) {
+    char seq[32];
+    int n = snprintf(seq, sizeof(seq), "\033[%d;%dH", row + 1, col + 1);
+    ansiAppend(out, seq, n);
+}
+
+static int ansiOpen(dispData_t * data) {
+    // Let curses do its initial clear now, rather than over our first frame
+    refresh();
+
+    ansiOut_t * out = calloc(1, sizeof(ansiOut_t));
+    if(out == NULL) {
+        return -1;
+    }
+
+    // Start with room for a full frame of single byte cells
+    out->cap = (size_t) data->screenRows * (data->screenCols + 16) + 64;
+    out->buf = malloc(out->cap);
+    if(out->buf == NULL) {
+        free(out);
+        return -1;
+    }
+    out->palette = kAnsiNoPalette;
+
+    data->backendData = out;
+    return 0;
+}
+
+static void ansiClose(dispData_t * data) {
+    ansiOut_t * out = data->backendData;
+    if(out == NULL) return;
+
+    free(out->buf);
+    free(out);
+}
+
+static void ansiClear(const dispData_t * data) {
+    ansiOut_t * out = data->backendData;
+
+    ansiAppend(out, "\033[0m\033[2J", 8);
+    out->palette = 0;
+}
+
+static void ansiPutRun(const dispData_t * data, int row, int col, const drawPair_t * cells, int n) {
+    ansiOut_t * out = data->backendData;
+    if(ansiReserve(out, n) < 0) {
+        return;
+    }
+    ansiMove(out, row, col);
+
+    // Only change the colours where the palette changes
+    for(int i = 0; i < n; i++) {
+        short palette = (cells[i] == kEmptyCell) ? 0 : drawPairPalette(cells[i]);
+        if(palette < 0 || palette > kMaxPalette) palette = kDefPalette;
+
+        if(palette != out->palette) {
+            const char * seq = getAnsiPalette(palette);
+            ansiAppend(out, seq, strlen(seq));
+            out->palette = palette;
         }
 
-        free(data.data);
+        char ch = (cells[i] == kEmptyCell) ? ' ' : drawPairCh(cells[i]);
+        ansiAppend(out, &ch, 1);
+    }
+}
+
+static void ansiFlush(const dispData_t * data) {
+    ansiOut_t * out = data->backendData;
+
+    // Leave the terminal the way curses expects to find it
+    int row, col;
+    getyx(curscr, row, col);
+    ansiAppend(out, kAnsiPalettes[0], strlen(kAnsiPalettes[0]));
+    ansiMove(out, row, col);
+    out->palette = kAnsiNoPalette;
+
+    for(size_t sent = 0; sent < out->len; ) {
+        ssize_t ret = write(STDOUT_FILENO, out->buf + sent, out->len - sent);
+        if(ret <= 0) break;
+        sent += ret;
+        curStats.bytesWritten += ret;
     }
+    out->len = 0;
+
+    // Then have curses put the cursor where the caller left it (so that it
+    // keeps track of where the cursor is)
+    int curRow, curCol;
+    getyx(stdscr, curRow, curCol);
+    mvcur(row, col, curRow, curCol);
+    fflush(stdout);
+}
+
+const dispBackend_t kAnsiBackend = {
+    "ansi", ansiOpen, ansiClose, ansiClear, ansiPutRun, ansiFlush
+};
 
+// Null: drops everything
+static int nullOpen(dispData_t * data) {
+    (void) data;
     return 0;
 }
 
+static void nullClose(dispData_t * data) {
+    (void) data;
+}
+
+static void nullDrop(const dispData_t * data) {
+    (void) data;
+}
+
+static void nullPutRun(const dispData_t * data, int row, int col, const drawPair_t * cells, int n) {
+    (void) data; (void) row; (void) col; (void) cells; (void) n;
+}
+
+const dispBackend_t kNullBackend = {
+    "null", nullOpen, nullClose, nullDrop, nullPutRun, nullDrop
+};
+
 //=============================<Buffer Handling>==============================//
 
 void addText(dispData_t * data, short palette, const char * text, int row, int col) {
     if(data == NULL || data->data == NULL || 
-            row < 0 || row > data->screenRows || 
-            col < 0 || col > data->screenCols) {
+            row < 0 || row >= data->screenRows || 
+            col < 0 || col >= data->screenCols) {
         return;
     }
     
+    drawPair_t * cells = dispRow(data, row) + col;
     for(int dCol = 0; col + dCol < data->screenCols && text[dCol]; dCol++) {
-        data->data[row][col + dCol] = (drawPair_t) {palette, text[dCol]};
+        cells[dCol] = mkDrawPair(palette, text[dCol]);
     }
 }
 
@@ -109,38 +507,77 @@ void addBackground(dispData_t * data, short palette) {
         return;
     }
 
-    for(int row = 0; row < data->screenRows; ++row) {
-        for(int col = 0; col < data->screenCols; ++col) {
-            data->data[row][col].ch = ' ';
-            data->data[row][col].palette = palette;
-        }
+    // Fill the whole buffer (padding included) in one pass
+    drawPair_t fill = mkDrawPair(palette, ' ');
+    size_t nCells = (size_t) data->screenRows * data->stride;
+    for(size_t i = 0; i < nCells; ++i) {
+        data->data[i] = fill;
     }
 }
 
-void printBuffer(dispData_t data) {
-    if(data.data == NULL) return;
+void printBuffer(dispData_t * data) {
+    if(data == NULL || data->data == NULL || data->prev == NULL || data->backend == NULL) return;
+    beginStage(kStageFlush);
 
-    // First clear the screen
-    clear();
+    // If the screen has been drawn over, start again from a clear screen (only 
+    // displays on the terminal share it, headless buffers have their own)
+    bool full = data->termOpen && screenStale;
+    if(full) {
+        data->backend->clearScreen(data);
+    }
 
-    // Then loop for each palette (since each requires its own refresh)
-    for(short palette = kMinPalette; palette < kMaxPalette; palette++) {
-        wattron(stdscr, COLOR_PAIR(palette));
+    // Find the span of each row that differs from what is on screen
+    for(int row = 0; row < data->screenRows; row++) {
+        const drawPair_t * cur = dispRow(data, row);
+        const drawPair_t * prev = data->prev + (size_t) row * data->stride;
+        int lo = 0, hi = data->screenCols;
 
-        // Finally itterate through all rows and cols
-        for(int row = 0; row < data.screenRows; row++) {
-            for(int col = 0; col < data.screenCols; col++) {
-                if(data.data[row][col].palette != palette || 
-                        data.data[row][col].ch == '\0') {
-                    continue;
-                }
+        if(full) {
+            while(lo < hi && cur[lo] == kEmptyCell) ++lo;
+            while(hi > lo && cur[hi-1] == kEmptyCell) --hi;
+        } else {
+            lo = firstDiff(cur, prev, lo, hi);
+            hi = lastDiff(cur, prev, lo, hi);
+        }
+
+        data->dirtyLo[row] = lo;
+        data->dirtyHi[row] = hi;
+    }
 
-                mvaddch(row, col, data.data[row][col].ch);
+    // Send each dirty span in a single pass, with one flush a frame
+    for(int row = 0; row < data->screenRows; row++) {
+        if(data->dirtyLo[row] < data->dirtyHi[row]) {
+            curStats.cellsChanged += data->dirtyHi[row] - data->dirtyLo[row];
+            data->backend->putRun(data, row, data->dirtyLo[row], 
+                                    dispRow(data, row) + data->dirtyLo[row], 
+                                    data->dirtyHi[row] - data->dirtyLo[row]);
+        }
+    }
+    data->backend->flush(data);
+    if(recordFile != NULL) {
+        recordFrame(data, full);
+    }
+
+    // Remember what is now on screen
+    if(full) {
+        memcpy(data->prev, data->data, (size_t) data->screenRows * data->stride * sizeof(drawPair_t));
+    } else {
+        for(int row = 0; row < data->screenRows; row++) {
+            size_t start = (size_t) row * data->stride + data->dirtyLo[row];
+            if(data->dirtyLo[row] < data->dirtyHi[row]) {
+                memcpy(data->prev + start, data->data + start,
+                        (data->dirtyHi[row] - data->dirtyLo[row]) * sizeof(drawPair_t));
             }
         }
-        refresh();
-        wattroff(stdscr, COLOR_PAIR(palette));
     }
+    if(data->termOpen) {
+        screenStale = false;
+    }
+    endStage(kStageFlush);
+}
+
+void invalidateDisp() {
+    screenStale = true;
 }
 
 void clearBuffer(dispData_t * data) {
@@ -148,16 +585,13 @@ void clearBuffer(dispData_t * data) {
         return;
     }
 
-    for(int row = 0; row < data->screenRows; row++) {
-        for(int col = 0; col < data->screenCols; col++) {
-            data->data[row][col] = (drawPair_t) {kDefPalette, '\0'};
-        }
-    }
+    memset(data->data, 0, (size_t) data->screenRows * data->stride * sizeof(drawPair_t));
 }
 
 //=============================<Buffer Handling>==============================//
 
 void printText(short palette, const char * text, int row, int col) {
+    invalidateDisp();
     wmove(stdscr, row, col);
     wattron(stdscr, COLOR_PAIR(palette));
     wprintw(stdscr, text, row, col);
@@ -166,16 +600,17 @@ void printText(short palette, const char * text, int row, int col) {
 }
 
 void getText(int row, int col, char* buf, unsigned int nBuf) {
+    invalidateDisp();
     curs_set(1);
-    echo();
 
     wmove(stdscr, row, col);
     wclrtoeol(stdscr);
     wmove(stdscr, row, col);
+    refresh();
 
     unsigned i;
     for(i = 0; i < nBuf - 1; i++) {
-        int ch = wgetch(stdscr);
+        int ch = getKey();
 
         if(ch == KEY_ENTER || ch == '\n') {
             break; 
@@ -189,16 +624,477 @@ void getText(int row, int col, char* buf, unsigned int nBuf) {
                 waddch(stdscr, ' ');
                 wmove(stdscr, row, col + i);
                 refresh();
-
-                // Decrement i again to account for the loop increment
-                --i;
             }
+
+            // Decrement i again to account for the loop increment
+            --i;
         } else {
             buf[i] = ch;
+
+            // Echo the character (keys are read with echo off, as the input 
+            // thread may be taking them)
+            if(ch >= ' ' && ch < 127) {
+                waddch(stdscr, ch);
+                refresh();
+            }
         }
     }
     buf[i] = 0;
 
     curs_set(0);
-    noecho();
-}
\ No newline at end of file
+}
+
+//==================================<Input>===================================//
+// Keys taken by the input thread, waiting to be read. Only the input thread 
+// moves head and only the reading thread moves tail, so neither needs a lock.
+static struct {
+    int keys[kKeyRingSize];
+    size_t head;                // Next slot to write (count of keys written)
+    size_t tail;                // Next slot to read (count of keys read)
+} keyRing;
+
+static bool inputRunning = false;     // Accessed atomically (see isInputRunning)
+static pthread_t inputThread;
+static int doorbell[2] = {-1, -1};  // Rung (written to) after each key is queued
+static int stopPipe[2] = {-1, -1};  // Written to to stop the input thread
+
+// Escape sequences decoded by the input thread (without the leading escape)
+static const struct {
+    const char * seq;
+    int key;
+} kEscapeKeys[] = {
+    {"[A", KEY_UP},     {"OA", KEY_UP},     {"[B", KEY_DOWN},   {"OB", KEY_DOWN},
+    {"[C", KEY_RIGHT},  {"OC", KEY_RIGHT},  {"[D", KEY_LEFT},   {"OD", KEY_LEFT},
+    {"[H", KEY_HOME},   {"OH", KEY_HOME},   {"[1~", KEY_HOME},  {"[7~", KEY_HOME},
+    {"[F", KEY_END},    {"OF", KEY_END},    {"[4~", KEY_END},   {"[8~", KEY_END},
+    {"[2~", KEY_IC},    {"[3~", KEY_DC},    {"[5~", KEY_PPAGE}, {"[6~", KEY_NPAGE},
+    {"OP", KEY_F(1)},   {"[11~", KEY_F(1)}
+};
+
+/**
+ * Queues a key (input thread only), returning false if the ring is full
+ */
+static bool pushKey(int key) {
+    size_t head = __atomic_load_n(&keyRing.head, __ATOMIC_RELAXED);
+    size_t tail = __atomic_load_n(&keyRing.tail, __ATOMIC_ACQUIRE);
+    if(head - tail >= kKeyRingSize) {
+        return false;
+    }
+
+    keyRing.keys[head % kKeyRingSize] = key;
+    __atomic_store_n(&keyRing.head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * Takes the next queued key (reading thread only), returning false if there 
+ * are none
+ */
+static bool popKey(int * key) {
+    size_t tail = __atomic_load_n(&keyRing.tail, __ATOMIC_RELAXED);
+    size_t head = __atomic_load_n(&keyRing.head, __ATOMIC_ACQUIRE);
+    if(head == tail) {
+        return false;
+    }
+
+    *key = keyRing.keys[tail % kKeyRingSize];
+    __atomic_store_n(&keyRing.tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * Checks for queued keys (reading thread only)
+ */
+static bool keysQueued() {
+    return __atomic_load_n(&keyRing.head, __ATOMIC_ACQUIRE) != 
+            __atomic_load_n(&keyRing.tail, __ATOMIC_RELAXED);
+}
+
+/**
+ * Waits up to ms milliseconds (<0 for no limit) for a key to be queued, 
+ * returning true iff one is
+ */
+static bool waitForKey(int ms) {
+    if(keysQueued()) return true;
+
+    struct pollfd fd = {doorbell[0], POLLIN, 0};
+    poll(&fd, 1, ms);
+
+    // Clear the rings answered (keys queued after this ring again)
+    char drain[64];
+    while(read(doorbell[0], drain, sizeof(drain)) > 0);
+
+    return keysQueued();
+}
+
+/**
+ * Queues a key, waiting for room if the reader has fallen a whole ring behind
+ * (input thread only)
+ */
+static void queueKey(int key) {
+    while(!pushKey(key)) {
+        struct timespec delay = {0, 1000000};
+        nanosleep(&delay, NULL);
+    }
+
+    // A full pipe already holds a ring, so a failed write is fine
+    char ring = 0;
+    if(write(doorbell[1], &ring, 1) < 0) return;
+}
+
+/**
+ * Reads a byte from the terminal, waiting up to ms milliseconds (<0 for no
+ * limit) for it or for the thread to be stopped
+ * 
+ * @return The byte, or <0 on timeout, stop or end of input
+ */
+static int readInputByte(int ms) {
+    struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+    if(poll(fds, 2, ms) <= 0 || fds[1].revents != 0) {
+        return -1;
+    }
+
+    unsigned char ch;
+    return (read(STDIN_FILENO, &ch, 1) == 1) ? ch : -2;
+}
+
+/**
+ * Reads keys from the terminal until stopped, decoding escape sequences into
+ * curses key codes
+ */
+static void * inputWorker(void * arg) {
+    (void) arg;
+
+    int ch;
+    while((ch = readInputByte(-1)) >= 0) {
+        if(ch != 27) {
+            queueKey((ch == '\r') ? '\n' : (ch == 127) ? KEY_BACKSPACE : ch);
+            continue;
+        }
+
+        // Gather the rest of the sequence (a lone escape has none)
+        char seq[8];
+        int len = 0;
+        while(len < (int) sizeof(seq) - 1 && (ch = readInputByte(kEscapeDelay)) >= 0) {
+            seq[len++] = ch;
+            if(len == 1 && ch != '[' && ch != 'O') break;       // Alt and a key
+            if(len > 1 && ch >= 0x40 && ch <= 0x7E) break;      // Final byte
+        }
+        seq[len] = '\0';
+
+        int key = -1;
+        for(size_t i = 0; i < sizeof(kEscapeKeys) / sizeof(kEscapeKeys[0]); i++) {
+            if(strcmp(seq, kEscapeKeys[i].seq) == 0) {
+                key = kEscapeKeys[i].key;
+                break;
+            }
+        }
+
+        // Unknown sequences are passed on as they came (as curses does)
+        if(key >= 0) {
+            queueKey(key);
+        } else {
+            queueKey(27);
+            for(int i = 0; i < len; i++) queueKey((unsigned char) seq[i]);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Closes both ends of a pipe
+ */
+static void closePipe(int fds[2]) {
+    for(int i = 0; i < 2; i++) {
+        if(fds[i] >= 0) close(fds[i]);
+        fds[i] = -1;
+    }
+}
+
+/**
+ * Checks whether the input thread is running
+ */
+static bool isInputRunning() {
+    return __atomic_load_n(&inputRunning, __ATOMIC_ACQUIRE);
+}
+
+int startInputThread(dispData_t * data) {
+    if(data == NULL || !data->termOpen) return -1;
+    if(isInputRunning()) return 0;
+
+    if(pipe(doorbell) < 0 || pipe(stopPipe) < 0) {
+        goto startInputThreadFail;
+    }
+    fcntl(doorbell[0], F_SETFL, O_NONBLOCK);
+    fcntl(doorbell[1], F_SETFL, O_NONBLOCK);
+
+    // Keys come a byte at a time, and curses mustn't read or look ahead at them
+    cbreak();
+    typeahead(-1);
+
+    keyRing.head = keyRing.tail = 0;
+    if(pthread_create(&inputThread, NULL, inputWorker, NULL) != 0) {
+        goto startInputThreadFail;
+    }
+    __atomic_store_n(&inputRunning, true, __ATOMIC_RELEASE);
+    return 0;
+
+startInputThreadFail:
+    closePipe(doorbell);
+    closePipe(stopPipe);
+    return -1;
+}
+
+void stopInputThread() {
+    // Only one caller gets to stop the thread and close its pipes
+    if(!__atomic_exchange_n(&inputRunning, false, __ATOMIC_ACQ_REL)) return;
+
+    char stop = 0;
+    if(write(stopPipe[1], &stop, 1) == 1) {
+        pthread_join(inputThread, NULL);
+    } else {
+        pthread_cancel(inputThread);
+        pthread_join(inputThread, NULL);
+    }
+
+    closePipe(doorbell);
+    closePipe(stopPipe);
+}
+
+int getKey() {
+    if(!isInputRunning()) {
+        return wgetch(stdscr);
+    }
+
+    int key;
+    while(!popKey(&key)) {
+        waitForKey(-1);
+    }
+    return key;
+}
+
+int getKeyTimeout(int ms) {
+    if(ms < 0) return getKey();
+
+    if(!isInputRunning()) {
+        wtimeout(stdscr, ms);
+        int ch = wgetch(stdscr);
+        wtimeout(stdscr, -1);
+        return ch;
+    }
+
+    int key;
+    if(popKey(&key) || (waitForKey(ms) && popKey(&key))) {
+        return key;
+    }
+    return ERR;
+}
+
+//===============================<Frame Pacing>===============================//
+static unsigned frameRate = kDefFrameRate;
+static struct timespec lastFrame;       // When the last frame was printed
+
+/**
+ * Gets the milliseconds passed since the given time
+ */
+static long msSince(struct timespec then) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - then.tv_sec) * 1000 + (now.tv_nsec - then.tv_nsec) / 1000000;
+}
+
+void setFrameRate(unsigned fps) {
+    frameRate = fps;
+}
+
+bool inputPending() {
+    if(isInputRunning()) return keysQueued();
+    if(stdscr == NULL) return false;
+
+    // Peek at the next key (putting it back for the caller to read)
+    nodelay(stdscr, TRUE);
+    int ch = wgetch(stdscr);
+    nodelay(stdscr, FALSE);
+    if(ch == ERR) {
+        return false;
+    }
+
+    ungetch(ch);
+    return true;
+}
+
+bool shouldRender(const dispData_t * data) {
+    if(data == NULL || !data->termOpen) return true;
+
+    // Apply any waiting input first (unless it has held the frame off too long)
+    long elapsed = msSince(lastFrame);
+    if(elapsed < kMaxFrameDelay && inputPending()) {
+        return false;
+    }
+
+    // Then wait out the rest of the frame, taking any input which comes first
+    if(frameRate > 0 && elapsed < 1000 / (long) frameRate && isInputRunning()) {
+        if(waitForKey(1000 / frameRate - elapsed)) {
+            return false;
+        }
+    } else if(frameRate > 0 && elapsed < 1000 / (long) frameRate) {
+        wtimeout(stdscr, 1000 / frameRate - elapsed);
+        int ch = wgetch(stdscr);
+        wtimeout(stdscr, -1);
+        if(ch != ERR) {
+            ungetch(ch);
+            return false;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &lastFrame);
+    return true;
+}
+
+//================================<Profiling>=================================//
+static const char * const kStageNames[kNumStages] = {"compose", "fill", "flush"};
+
+static struct timespec stageStart[kNumStages];  // When each stage was begun
+static unsigned long nFrames = 0;               // Frames measured so far
+static FILE* traceFile = NULL;
+
+void beginFrame() {
+    memset(&curStats, 0, sizeof(frameStats_t));
+    curStats.frame = nFrames;
+}
+
+frameStats_t endFrame() {
+    frameStats_t stats = curStats;
+    ++nFrames;
+
+    if(traceFile != NULL) {
+        fprintf(traceFile, "%lu", stats.frame);
+        for(int stage = 0; stage < kNumStages; stage++) {
+            fprintf(traceFile, ",%llu", (unsigned long long) stats.stageNs[stage]);
+        }
+        fprintf(traceFile, ",%u,%u,%lu,%lu\n", stats.tilesDrawn, stats.tilesStamped, 
+                    stats.cellsChanged, stats.bytesWritten);
+    }
+
+    beginFrame();
+    return stats;
+}
+
+void beginStage(renderStage_t stage) {
+    clock_gettime(CLOCK_MONOTONIC, &stageStart[stage]);
+}
+
+void endStage(renderStage_t stage) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    curStats.stageNs[stage] += (uint64_t) (now.tv_sec - stageStart[stage].tv_sec) * 1000000000 + 
+                                (now.tv_nsec - stageStart[stage].tv_nsec);
+}
+
+void countTiles(unsigned drawn, unsigned stamped) {
+    curStats.tilesDrawn += drawn;
+    curStats.tilesStamped += stamped;
+}
+
+int setFrameTrace(FILE* file) {
+    traceFile = file;
+    if(file == NULL) return 0;
+
+    fprintf(file, "frame");
+    for(int stage = 0; stage < kNumStages; stage++) {
+        fprintf(file, ",%s_ns", kStageNames[stage]);
+    }
+    return (fprintf(file, ",tiles_drawn,tiles_stamped,cells_changed,bytes_written\n") < 0) ? -1 : 0;
+}
+
+void addFrameStats(dispData_t * data, const frameStats_t * stats, int row) {
+    if(data == NULL || data->data == NULL || row < 0 || row >= data->screenRows ||
+            stats == NULL) {
+        return;
+    }
+
+    char buf[160];
+    int len = snprintf(buf, sizeof(buf), "frame %lu", stats->frame);
+    for(int stage = 0; stage < kNumStages && len < (int) sizeof(buf); stage++) {
+        len += snprintf(buf + len, sizeof(buf) - len, " | %s %.2fms", kStageNames[stage], 
+                        stats->stageNs[stage] / 1e6);
+    }
+    if(len < (int) sizeof(buf)) {
+        snprintf(buf + len, sizeof(buf) - len, " | %u tiles (%u stamped) | %lu cells | %lu bytes", 
+                    stats->tilesDrawn, stats->tilesStamped, stats->cellsChanged, stats->bytesWritten);
+    }
+
+    // Blank the whole row, so the line reads clearly over the map
+    drawPair_t * cells = dispRow(data, row);
+    for(int col = 0; col < data->screenCols; col++) {
+        cells[col] = mkDrawPair(kBlackPalette, ' ');
+    }
+    addText(data, kBlackPalette, buf, row, 0);
+}
+
+//================================<Recording>=================================//
+void setFrameRecord(FILE* file) {
+    if(recordFile != NULL) fflush(recordFile);
+
+    recordFile = file;
+    recordStarted = false;
+}
+
+int readRecordHeader(FILE* file, int * rows, int * cols) {
+    if(file == NULL || rows == NULL || cols == NULL) return -1;
+
+    char magic[kRecordMagicLen];
+    uint64_t val;
+    if(fread(magic, sizeof(char), kRecordMagicLen, file) != kRecordMagicLen ||
+            memcmp(magic, kRecordMagic, kRecordMagicLen) != 0) {
+        return -1;
+    }
+
+    if(getLE(file, &val, 2) < 0) return -1;
+    *rows = val;
+    if(getLE(file, &val, 2) < 0) return -1;
+    *cols = val;
+
+    return (*rows > 0 && *cols > 0) ? 0 : -1;
+}
+
+int readRecordFrame(FILE* file, dispData_t * data, recordFrame_t * frame) {
+    if(file == NULL || data == NULL || data->data == NULL || frame == NULL) return -1;
+
+    uint64_t val;
+    memset(frame, 0, sizeof(recordFrame_t));
+    if(getLE(file, &val, 8) < 0) {
+        return (feof(file) && !ferror(file)) ? 1 : -1;
+    }
+    frame->timeNs = val;
+
+    if(getLE(file, &val, 1) < 0) return -1;
+    frame->cleared = (val & kRecordCleared) != 0;
+    if(frame->cleared) {
+        clearBuffer(data);
+        invalidateDisp();
+    }
+
+    if(getLE(file, &val, 4) < 0) return -1;
+    frame->nRuns = val;
+
+    for(unsigned long run = 0; run < frame->nRuns; run++) {
+        uint64_t row, col, n;
+        if(getLE(file, &row, 2) < 0 || getLE(file, &col, 2) < 0 || getLE(file, &n, 2) < 0) {
+            return -1;
+        }
+        frame->nCells += n;
+
+        // Keep only the cells landing on the buffer
+        drawPair_t * cells = ((int) row < data->screenRows) ? dispRow(data, row) : NULL;
+        for(uint64_t i = 0; i < n; i++) {
+            if(getLE(file, &val, 2) < 0) return -1;
+            if(cells != NULL && (int) (col + i) < data->screenCols) {
+                cells[col + i] = val;
+            }
+        }
+    }
+
+    return 0;
+}
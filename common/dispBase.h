@@ -3,6 +3,9 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 #include <curses.h>
 
 // Define common palette numbers
@@ -19,19 +22,63 @@
 #define kMinPalette 1
 #define kMaxPalette 8
 
-typedef struct drawPair_s {
-    short palette;
-    char ch;
-} drawPair_t;
+// Length of the longest palette escape sequence (see getAnsiPalette)
+#define kAnsiPaletteLen 8
+
+// A frame buffer cell, packed as the palette (high byte) over the glyph (low 
+// byte). The zero cell is empty (nothing drawn there).
+typedef uint16_t drawPair_t;
+
+#define kEmptyCell ((drawPair_t) 0)
+
+#define mkDrawPair(palette, ch) \
+    ((drawPair_t) (((unsigned) (palette) & 0xFF) << 8 | (unsigned char) (ch)))
+#define drawPairPalette(pair) ((short) ((pair) >> 8))
+#define drawPairCh(pair) ((char) ((pair) & 0xFF))
+
+// Rows of the frame buffer are padded out to a whole number of these cells, so
+// that rows can be compared a machine word at a time
+#define kCellsPerWord (sizeof(uint64_t) / sizeof(drawPair_t))
+
+// Returns a pointer to the first cell of a row in the frame buffer
+#define dispRow(disp, row) ((disp)->data + (size_t) (row) * (disp)->stride)
+
+struct dispBackend_s;
 
 // Define a persistent data structure
 typedef struct dispData_s {
     int screenRows;
     int screenCols;
 
-    drawPair_t ** data;
+    drawPair_t * data;      // The frame buffer (contiguous rows of stride cells)
+    int stride;             // Cells from the start of one row to the next
+
+    // Damage tracking (maintained by printBuffer)
+    drawPair_t * prev;      // The frame as last flushed to screen (same layout)
+    int * dirtyLo;          // First changed column of each row in the last flush
+    int * dirtyHi;          // One past the last changed column of each row
+
+    // Output
+    const struct dispBackend_s * backend;   // Where printed frames are sent
+    void * backendData;     // The backend's own state
+    bool termOpen;          // Set iff curses is running (for input and prompts)
 } dispData_t;
 
+// An output backend for printed frames
+typedef struct dispBackend_s {
+    const char * name;
+
+    int (*open)(dispData_t * data);     // Sets up the backend's state
+    void (*close)(dispData_t * data);   // Frees the backend's state
+    void (*clearScreen)(const dispData_t * data); // Clears the screen
+    void (*putRun)(const dispData_t * data, int row, int col, const drawPair_t * cells, int n);
+    void (*flush)(const dispData_t * data); // Sends everything put since the last flush
+} dispBackend_t;
+
+extern const dispBackend_t kCursesBackend;  // Output through curses (default)
+extern const dispBackend_t kAnsiBackend;    // Raw ANSI escapes, one write a frame
+extern const dispBackend_t kNullBackend;    // Discards all output (benchmarks)
+
 //=============================<Init and Cleanup>=============================//
 /**
  * Core display initialization
@@ -41,6 +88,43 @@ typedef struct dispData_s {
  */
 int initDisp(dispData_t* data);
 
+/**
+ * Core display initialization, sending frames to the given backend
+ * 
+ * @param data A return pointer for a display data struct
+ * @param backend The output backend to use
+ * @return 0 iff display was initialized correctly
+ */
+int initDispBackend(dispData_t* data, const dispBackend_t * backend);
+
+/**
+ * Initializes a display struct with a frame buffer of the given size, without
+ * starting curses (printing goes to the null backend)
+ * 
+ * @param data A return pointer for a display data struct
+ * @param rows The number of rows in the buffer
+ * @param cols The number of columns in the buffer
+ * @return 0 iff the buffer was allocated correctly
+ */
+int initDispBuffer(dispData_t* data, int rows, int cols);
+
+/**
+ * Looks up an output backend by name ("curses", "ansi" or "null")
+ * 
+ * @param name The name of the backend
+ * @return The backend (NULL if there is none by that name)
+ */
+const dispBackend_t * getDispBackend(const char * name);
+
+/**
+ * Gets the ANSI escape sequence which selects a palette's colours (palette 0 
+ * gives the terminal's default colours)
+ * 
+ * @param palette The palette to select
+ * @return The escape sequence (at most kAnsiPaletteLen chars)
+ */
+const char * getAnsiPalette(short palette);
+
 /**
  * Core display close
  * 
@@ -80,11 +164,19 @@ void addMenu(dispData_t * data, const char * prompt, const char ** items, int nI
 void addBackground(dispData_t * data, short palette);
 
 /**
- * Clears the screen and prints out the data stored in the buffer
+ * Prints out the data stored in the buffer (only redrawing the cells which 
+ * have changed since the last print, unless the terminal has been invalidated),
+ * leaving the cursor wherever it was last moved to
  * 
  * @param data The display data struct
  */
-void printBuffer(dispData_t data);
+void printBuffer(dispData_t * data);
+
+/**
+ * Marks the screen as drawn over outside of printBuffer, so that the next 
+ * print redraws the entire buffer (printText and getText do this themselves)
+ */
+void invalidateDisp();
 
 /**
  * Clears out any data already in the buffer
@@ -114,4 +206,206 @@ void printText(short palette, const char * text, int row, int col);
  */
 void getText(int row, int col, char* buf, unsigned int nBuf);
 
+//==================================<Input>===================================//
+// Keys taken by the input thread wait in a ring of this many (a power of 2)
+#define kKeyRingSize 256
+
+// How long the rest of an escape sequence may take to arrive (in ms)
+#define kEscapeDelay 25
+
+/**
+ * Starts a thread taking keys from the terminal as they arrive, so that a slow
+ * frame or a long operation never holds up keystrokes. Keys are queued for 
+ * getKey (which inputPending, shouldRender and getText then read from too).
+ * Decodes the common xterm/VT escape sequences for arrow, paging, home/end, 
+ * insert/delete and F1 keys itself, as curses may only be used from the 
+ * render thread.
+ * 
+ * @param data The display data struct (the terminal must be open)
+ * @return 0 on success, <0 on failure (keys are then read as they are taken)
+ */
+int startInputThread(dispData_t * data);
+
+/**
+ * Stops the input thread, if it is running (closeDisp does so too, on closing the
+ * terminal), dropping any keys still queued
+ */
+void stopInputThread();
+
+/**
+ * Gets the next key, waiting for one if none are queued (reads straight from 
+ * curses unless the input thread is running)
+ * 
+ * @return The key (as getch returns them)
+ */
+int getKey();
+
+/**
+ * Gets the next key, waiting up to ms milliseconds for one (so that a caller 
+ * can keep the screen up to date, e.g. while a job runs in the background)
+ * 
+ * @param ms The longest to wait (<0 for no limit)
+ * 
+ * @return The key (as getch returns them), or ERR if none came in time
+ */
+int getKeyTimeout(int ms);
+
+//================================<Profiling>=================================//
+// Stages of rendering a frame, timed separately
+typedef enum renderStage_e {
+    kStageCompose,      // Composing tiles and sprites (addMap and the like)
+    kStageFill,         // Filling the frame buffer (clearing, text and overlays)
+    kStageFlush,        // Sending the changed cells out (printBuffer)
+    kNumStages
+} renderStage_t;
+
+// Measurements of a single frame
+typedef struct frameStats_s {
+    unsigned long frame;            // Number of the frame (counting from 0)
+    uint64_t stageNs[kNumStages];   // Time spent in each stage (in ns)
+    unsigned tilesDrawn;            // Tiles drawn onto the frame's views
+    unsigned tilesStamped;          // Of those, tiles copied from their stamps
+    unsigned long cellsChanged;     // Cells sent out by printBuffer
+    unsigned long bytesWritten;     // Bytes written to the terminal (for the 
+                                    // curses backend, cells handed to curses)
+} frameStats_t;
+
+//===============================<Frame Pacing>===============================//
+// Default cap on the frames printed each second (see shouldRender)
+#define kDefFrameRate 60
+
+// Longest a frame is put off while input keeps arriving (in ms)
+#define kMaxFrameDelay 250
+
+/**
+ * Sets the cap on the frames printed each second
+ * 
+ * @param fps The most frames to print each second (0 for no cap)
+ */
+void setFrameRate(unsigned fps);
+
+/**
+ * Checks for keys waiting to be read, without taking them
+ * 
+ * @return true iff getch would return at once
+ */
+bool inputPending();
+
+/**
+ * Decides whether to print a frame now, or to apply more input first. Frames 
+ * are put off while there are keys waiting (so a held key is applied in one
+ * batch rather than a frame per key), and until the frame rate allows another.
+ * 
+ * @param data The display data struct
+ * @return true iff the frame should be printed (marking it printed)
+ */
+bool shouldRender(const dispData_t * data);
+
+//================================<Profiling>=================================//
+/**
+ * Starts measuring a frame (dropping anything counted since the last one)
+ */
+void beginFrame();
+
+/**
+ * Finishes measuring a frame, writing it out to the trace file (if one is set)
+ * 
+ * @return The measurements of the frame
+ */
+frameStats_t endFrame();
+
+/**
+ * Starts timing a stage of the frame (stages may be timed more than once a 
+ * frame, adding up)
+ * 
+ * @param stage The stage to time
+ */
+void beginStage(renderStage_t stage);
+
+/**
+ * Stops timing a stage of the frame
+ * 
+ * @param stage The stage being timed
+ */
+void endStage(renderStage_t stage);
+
+/**
+ * Adds to the count of tiles drawn this frame
+ * 
+ * @param drawn The number of tiles drawn
+ * @param stamped The number of those copied from their stamps
+ */
+void countTiles(unsigned drawn, unsigned stamped);
+
+/**
+ * Sets a file to write every frame's measurements out to as CSV, one line a
+ * frame (writing the header line out at once)
+ * 
+ * @param file The file to write to (NULL to stop writing)
+ * @return 0 on success, <0 on failure
+ */
+int setFrameTrace(FILE* file);
+
+/**
+ * Adds a status line showing a frame's measurements to the frame buffer
+ * 
+ * @param data The display data struct
+ * @param stats The measurements to show
+ * @param row The row to show them on
+ */
+void addFrameStats(dispData_t * data, const frameStats_t * stats, int row);
+
+//================================<Recording>=================================//
+/*
+ * A recording holds every printed frame as the runs of cells it changed (the
+ * same runs sent to the backend), so a session can be played back exactly.
+ * Every value is little-endian:
+ *   header: kRecordMagic, u16 screen rows, u16 screen cols
+ *   frame:  u64 time (ns since the first frame), u8 flags (see below), 
+ *           u32 number of runs, then the runs
+ *   run:    u16 row, u16 col, u16 number of cells, then the cells (drawPair_t)
+ */
+#define kRecordMagic "DNDREC1\n"
+#define kRecordMagicLen 8
+
+#define kRecordCleared 0x01     // Frame flag: the screen was cleared first
+
+// A frame read back from a recording
+typedef struct recordFrame_s {
+    uint64_t timeNs;            // When it was printed (ns since the first frame)
+    bool cleared;               // Set iff the screen was cleared first
+    unsigned long nRuns;        // Runs of cells changed
+    unsigned long nCells;       // Cells changed
+} recordFrame_t;
+
+/**
+ * Sets a file to record every printed frame to (the header is written along
+ * with the first frame)
+ * 
+ * @param file The file to write to (NULL to stop recording)
+ */
+void setFrameRecord(FILE* file);
+
+/**
+ * Reads the header of a recording
+ * 
+ * @param file The recording to read
+ * @param rows A return pointer for the rows of the recorded screen
+ * @param cols A return pointer for the columns of the recorded screen
+ * @return 0 on success, <0 on failure (not a recording)
+ */
+int readRecordHeader(FILE* file, int * rows, int * cols);
+
+/**
+ * Reads the next frame of a recording, applying its changes to the frame 
+ * buffer (cells off the buffer are dropped, and a cleared frame clears the 
+ * buffer and invalidates the display first)
+ * 
+ * @param file The recording to read (past the header)
+ * @param data The display data struct
+ * @param frame A return pointer for the frame's details
+ * @return 0 on success, 1 at the end of the recording, <0 on failure
+ */
+int readRecordFrame(FILE* file, dispData_t * data, recordFrame_t * frame);
+
 #endif
\ No newline at end of file
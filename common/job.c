@@ -0,0 +1,172 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "job.h"
+
+#include <string.h>
+#include <time.h>
+
+//==================================<Helpers>=================================//
+/**
+ * Runs a job's operation (the worker thread's entry point)
+ */
+static void * jobWorker(void * arg) {
+    job_t * job = arg;
+    int ret = job->run(job, job->arg);
+
+    pthread_mutex_lock(&job->lock);
+    job->ret = ret;
+    job->state = kJobDone;
+    pthread_cond_broadcast(&job->finished);
+    pthread_mutex_unlock(&job->lock);
+
+    return NULL;
+}
+
+//=============================<Init and Cleanup>=============================//
+int initJob(job_t * job) {
+    if(job == NULL) return -1;
+
+    memset(job, 0, sizeof(job_t));
+    job->state = kJobIdle;
+    if(pthread_mutex_init(&job->lock, NULL) != 0) {
+        return -1;
+    }
+    if(pthread_cond_init(&job->finished, NULL) != 0) {
+        pthread_mutex_destroy(&job->lock);
+        return -1;
+    }
+
+    return 0;
+}
+
+void rmJob(job_t * job) {
+    if(job == NULL) return;
+
+    if(jobActive(job)) {
+        cancelJob(job);
+        finishJob(job);
+    }
+    pthread_cond_destroy(&job->finished);
+    pthread_mutex_destroy(&job->lock);
+}
+
+//==================================<Jobs>====================================//
+int startJob(job_t * job, const char * name, jobFxn_t run, void * arg) {
+    if(job == NULL || run == NULL || jobActive(job)) return -1;
+
+    job->name = (name == NULL) ? "Working" : name;
+    job->run = run;
+    job->arg = arg;
+    job->ret = 0;
+    __atomic_store_n(&job->cancelled, false, __ATOMIC_RELAXED);
+    __atomic_store_n(&job->done, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&job->total, 0, __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&job->lock);
+    job->state = kJobRunning;
+    pthread_mutex_unlock(&job->lock);
+
+    if(pthread_create(&job->thread, NULL, jobWorker, job) != 0) {
+        pthread_mutex_lock(&job->lock);
+        job->state = kJobIdle;
+        pthread_mutex_unlock(&job->lock);
+        return -2;
+    }
+
+    return 0;
+}
+
+bool jobActive(job_t * job) {
+    if(job == NULL) return false;
+
+    pthread_mutex_lock(&job->lock);
+    bool active = (job->state != kJobIdle);
+    pthread_mutex_unlock(&job->lock);
+    return active;
+}
+
+bool waitForJob(job_t * job, int ms) {
+    if(job == NULL) return false;
+
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_sec += ms / 1000;
+    until.tv_nsec += (long) (ms % 1000) * 1000000;
+    if(until.tv_nsec >= 1000000000) {
+        until.tv_sec += 1;
+        until.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&job->lock);
+    while(ms > 0 && job->state == kJobRunning) {
+        if(pthread_cond_timedwait(&job->finished, &job->lock, &until) != 0) break;
+    }
+    bool done = (job->state == kJobDone);
+    pthread_mutex_unlock(&job->lock);
+
+    return done;
+}
+
+int finishJob(job_t * job) {
+    if(!jobActive(job)) return -1;
+
+    pthread_join(job->thread, NULL);
+
+    pthread_mutex_lock(&job->lock);
+    job->state = kJobIdle;
+    pthread_mutex_unlock(&job->lock);
+
+    return job->ret;
+}
+
+void cancelJob(job_t * job) {
+    if(job == NULL) return;
+
+    __atomic_store_n(&job->cancelled, true, __ATOMIC_RELAXED);
+}
+
+bool jobCancelled(job_t * job) {
+    if(job == NULL) return false;
+
+    return __atomic_load_n(&job->cancelled, __ATOMIC_RELAXED);
+}
+
+bool setJobProgress(void * job, long done, long total) {
+    job_t * cur = job;
+    if(cur == NULL) return true;
+
+    __atomic_store_n(&cur->done, done, __ATOMIC_RELAXED);
+    __atomic_store_n(&cur->total, total, __ATOMIC_RELAXED);
+    return !jobCancelled(cur);
+}
+
+//=================================<Display>==================================//
+void addJobStatus(dispData_t * data, job_t * job, const char * hint, int row) {
+    if(data == NULL || data->data == NULL || row < 0 || row >= data->screenRows ||
+            !jobActive(job)) {
+        return;
+    }
+
+    char buf[160];
+    long done = __atomic_load_n(&job->done, __ATOMIC_RELAXED);
+    long total = __atomic_load_n(&job->total, __ATOMIC_RELAXED);
+    int len;
+    if(total > 0) {
+        len = snprintf(buf, sizeof(buf), "%s... %ld%%", job->name, 100 * done / total);
+    } else {
+        len = snprintf(buf, sizeof(buf), "%s... %ld done", job->name, done);
+    }
+
+    if(len < (int) sizeof(buf) && jobCancelled(job)) {
+        snprintf(buf + len, sizeof(buf) - len, " (cancelling)");
+    } else if(len < (int) sizeof(buf) && hint != NULL) {
+        snprintf(buf + len, sizeof(buf) - len, " (%s)", hint);
+    }
+
+    // Blank the whole row, so the line reads clearly over the map
+    drawPair_t * cells = dispRow(data, row);
+    for(int col = 0; col < data->screenCols; col++) {
+        cells[col] = mkDrawPair(kBlackPalette, ' ');
+    }
+    addText(data, kBlackPalette, buf, row, 0);
+}
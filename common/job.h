@@ -0,0 +1,144 @@
+#ifndef _JOB_H_
+#define _JOB_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "dispBase.h"
+
+/*
+ * Jobs run a long operation (loading or saving a large map, ...) on a worker
+ * thread, so that the render thread keeps drawing and taking keys meanwhile.
+ * A job only touches the data it was handed (a snapshot, or a result it builds
+ * for itself), reporting its progress and checking for cancellation as it
+ * goes. Once it is done, the render thread collects it with finishJob and
+ * commits its result to the editor's state in one step, so the editor never
+ * sees an operation half finished.
+ */
+
+// Reports progress through an operation (done of total units, with total <= 0
+// if it isn't known), returning false if the operation should stop early
+typedef bool (*progressFxn_t)(void * arg, long done, long total);
+
+typedef enum jobState_e {
+    kJobIdle,       // Not started, or already collected
+    kJobRunning,
+    kJobDone        // Finished, with its result waiting to be collected
+} jobState_t;
+
+struct job_s;
+typedef int (*jobFxn_t)(struct job_s * job, void * arg);
+
+typedef struct job_s {
+    const char * name;          // What the status line calls the job
+    jobFxn_t run;
+    void * arg;
+    int ret;                    // What run returned (once done)
+
+    // Shared with the worker
+    pthread_t thread;
+    pthread_mutex_t lock;       // Guards state (signalling finished on done)
+    pthread_cond_t finished;
+    jobState_t state;
+    bool cancelled;             // Asks the worker to stop early
+    long done, total;           // Progress last reported
+} job_t;
+
+/**
+ * Initializes an idle job
+ *
+ * @param job The job to initialize
+ *
+ * @return 0 on success, < 0 on failure
+ */
+int initJob(job_t * job);
+
+/**
+ * Cleans up after a job (cancelling and waiting out any still running)
+ *
+ * @param job The job to clean up
+ */
+void rmJob(job_t * job);
+
+/**
+ * Starts running a job on its own thread
+ *
+ * @param job The (idle) job to start
+ * @param name What to call the job in its status line (not copied)
+ * @param run The operation to run (returning 0 on success, < 0 on failure)
+ * @param arg Passed through to run
+ *
+ * @return 0 on success, < 0 on failure
+ *          -1 on null param, or if the job has yet to be collected
+ *          -2 if unable to start the thread
+ */
+int startJob(job_t * job, const char * name, jobFxn_t run, void * arg);
+
+/**
+ * Checks whether a job has been started and not yet collected
+ *
+ * @param job The job to check
+ *
+ * @return true iff the job is running or done
+ */
+bool jobActive(job_t * job);
+
+/**
+ * Waits up to ms milliseconds for a job to finish
+ *
+ * @param job The job to wait on
+ * @param ms The longest to wait (0 to check without waiting)
+ *
+ * @return true iff the job is done
+ */
+bool waitForJob(job_t * job, int ms);
+
+/**
+ * Collects a job, waiting for it to finish if it is still running
+ *
+ * @param job The job to collect (idle afterwards)
+ *
+ * @return What the job's operation returned (-1 if it wasn't started)
+ */
+int finishJob(job_t * job);
+
+/**
+ * Asks a job to stop early (it stops at the next progress report)
+ *
+ * @param job The job to cancel
+ */
+void cancelJob(job_t * job);
+
+/**
+ * Checks whether a job has been asked to stop
+ *
+ * @param job The job to check
+ *
+ * @return true iff cancelJob has been called since the job started
+ */
+bool jobCancelled(job_t * job);
+
+/**
+ * Reports a job's progress (a progressFxn_t, for the worker to pass on)
+ *
+ * @param job The job reporting (as a job_t *)
+ * @param done The units of work done
+ * @param total The units of work in all (<= 0 if unknown)
+ *
+ * @return false iff the job has been cancelled
+ */
+bool setJobProgress(void * job, long done, long total);
+
+/**
+ * Adds a status line showing a job's progress to the frame buffer
+ *
+ * @param data The display data struct
+ * @param job The job to show (nothing is shown unless it is active)
+ * @param hint Shown after the progress (e.g. how to cancel, NULL for none)
+ * @param row The row to show it on
+ */
+void addJobStatus(dispData_t * data, job_t * job, const char * hint, int row);
+
+#endif
@@ -330,5 +330,24 @@ int listFind(list_t list, void* obj) {
     }
 
     if(node == NULL) return -1;
+    return i;
+}
+
+/**
+ * Copies every element of the list into an array (in list order)
+ * 
+ * @param list The list to copy from
+ * @param arr The array to copy into (must hold at least listLen(list) items)
+ * 
+ * @return The number of elements copied
+ */
+unsigned listCopyOut(list_t list, void ** arr) {
+    if(list == NULL || arr == NULL) return 0;
+
+    unsigned i = 0;
+    for(node_t node = list->start; node != NULL; node = node->next) {
+        arr[i++] = node->data;
+    }
+
     return i;
 }
\ No newline at end of file
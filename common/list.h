@@ -139,5 +139,15 @@ unsigned int listLen(list_t list);
  */
 int listFind(list_t list, void* obj);
 
+/**
+ * Copies every element of the list into an array (in list order)
+ * 
+ * @param list The list to copy from
+ * @param arr The array to copy into (must hold at least listLen(list) items)
+ * 
+ * @return The number of elements copied
+ */
+unsigned listCopyOut(list_t list, void ** arr);
+
 
 #endif
\ No newline at end of file
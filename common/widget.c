@@ -0,0 +1,194 @@
+#include "widget.h"
+
+#include <string.h>
+
+#ifndef min
+#define min(a, b) ((a < b) ? a : b)
+#endif
+
+//==================================<Helpers>=================================//
+/**
+ * Copies text into a widget's buffer, returning true iff it changed
+ */
+static bool copyWidgetText(char * dest, const char * text) {
+    if(text == NULL) text = "";
+    if(strncmp(dest, text, kWidgetTextLen - 1) == 0) {
+        return false;
+    }
+
+    strncpy(dest, text, kWidgetTextLen - 1);
+    dest[kWidgetTextLen - 1] = '\0';
+    return true;
+}
+
+/**
+ * Gets the column just past the right edge of a widget (on screen)
+ */
+static int widgetEndCol(const dispData_t * disp, const widget_t * widget) {
+    return (widget->cols <= 0) ? disp->screenCols
+                               : min(widget->col + widget->cols, disp->screenCols);
+}
+
+//=================================<Widgets>==================================//
+void initWidget(widget_t * widget, drawWidgetItem_t drawItem, int nItems, int row, int col,
+                int cols) {
+    if(widget == NULL) return;
+
+    widget->row = row;
+    widget->col = col;
+    widget->cols = cols;
+    widget->nItems = min(nItems, kMaxWidgetItems);
+    widget->drawItem = drawItem;
+    invalidateWidget(widget);
+}
+
+void invalidateWidget(widget_t * widget) {
+    if(widget == NULL) return;
+
+    widget->dirty = (widget->nItems >= kMaxWidgetItems) ? ~(uint64_t) 0
+                                                       : ((uint64_t) 1 << widget->nItems) - 1;
+}
+
+void invalidateWidgetItem(widget_t * widget, int item) {
+    if(widget == NULL || item < 0 || item >= widget->nItems) return;
+
+    widget->dirty |= (uint64_t) 1 << item;
+}
+
+int drawWidget(dispData_t * disp, widget_t * widget) {
+    if(disp == NULL || disp->data == NULL || widget == NULL || widget->drawItem == NULL) {
+        return 0;
+    }
+
+    int nDrawn = 0;
+    for(int item = 0; widget->dirty != 0 && item < widget->nItems; item++) {
+        uint64_t bit = (uint64_t) 1 << item;
+        if(widget->dirty & bit) {
+            widget->drawItem(disp, widget, item);
+            widget->dirty &= ~bit;
+            ++nDrawn;
+        }
+    }
+
+    return nDrawn;
+}
+
+void clearWidgetRow(dispData_t * disp, const widget_t * widget, int row) {
+    if(disp == NULL || disp->data == NULL || widget == NULL || row < 0 ||
+            row >= disp->screenRows || widget->col >= disp->screenCols) {
+        return;
+    }
+
+    int endCol = widgetEndCol(disp, widget);
+    drawPair_t * cells = dispRow(disp, row);
+    for(int col = widget->col; col < endCol; col++) {
+        cells[col] = kEmptyCell;
+    }
+}
+
+void addWidgetText(dispData_t * disp, const widget_t * widget, short palette, const char * text,
+                    int row, int col) {
+    if(disp == NULL || disp->data == NULL || widget == NULL || text == NULL || row < 0 ||
+            row >= disp->screenRows || col < 0) {
+        return;
+    }
+
+    drawPair_t * cells = dispRow(disp, row);
+    int endCol = widgetEndCol(disp, widget);
+    for(int i = 0; col + i < endCol && text[i]; i++) {
+        cells[col + i] = mkDrawPair(palette, text[i]);
+    }
+}
+
+//==================================<Labels>==================================//
+/**
+ * Draws a label's text
+ */
+static void drawLabel(dispData_t * disp, const widget_t * widget, int item) {
+    const labelWidget_t * label = (const labelWidget_t *) widget;
+    (void) item;
+
+    clearWidgetRow(disp, widget, widget->row);
+    addWidgetText(disp, widget, label->palette, label->text, widget->row, widget->col);
+}
+
+void initLabel(labelWidget_t * label, int row, int col, int cols) {
+    if(label == NULL) return;
+
+    initWidget(&label->base, drawLabel, 1, row, col, cols);
+    label->palette = kBlackPalette;
+    label->text[0] = '\0';
+}
+
+void setLabel(labelWidget_t * label, short palette, const char * text) {
+    if(label == NULL) return;
+
+    bool changed = copyWidgetText(label->text, text);
+    if(changed || palette != label->palette) {
+        label->palette = palette;
+        invalidateWidget(&label->base);
+    }
+}
+
+//==================================<Menus>===================================//
+/**
+ * Draws a single line of a menu
+ */
+static void drawMenuItem(dispData_t * disp, const widget_t * widget, int item) {
+    const menuWidget_t * menu = (const menuWidget_t *) widget;
+
+    clearWidgetRow(disp, widget, widget->row + item);
+    addWidgetText(disp, widget, (item == menu->sel) ? kWhitePalette : kBlackPalette,
+                    menu->items[item], widget->row + item, widget->col);
+}
+
+void initMenuWidget(menuWidget_t * menu, const char ** items, int nItems, int row, int col,
+                    int cols) {
+    if(menu == NULL) return;
+
+    initWidget(&menu->base, drawMenuItem, (items == NULL) ? 0 : nItems, row, col, cols);
+    menu->items = items;
+    menu->sel = -1;
+}
+
+void setMenuSel(menuWidget_t * menu, int sel) {
+    if(menu == NULL || sel == menu->sel) return;
+
+    invalidateWidgetItem(&menu->base, menu->sel);
+    invalidateWidgetItem(&menu->base, sel);
+    menu->sel = sel;
+}
+
+//==================================<Fields>==================================//
+/**
+ * Draws a field's name and value
+ */
+static void drawField(dispData_t * disp, const widget_t * widget, int item) {
+    const fieldWidget_t * field = (const fieldWidget_t *) widget;
+    short palette = (field->selected) ? kWhitePalette : kBlackPalette;
+    (void) item;
+
+    clearWidgetRow(disp, widget, widget->row);
+    addWidgetText(disp, widget, palette, field->name, widget->row, widget->col);
+    addWidgetText(disp, widget, palette, field->value, widget->row, 
+                    widget->col + strlen(field->name));
+}
+
+void initField(fieldWidget_t * field, const char * name, int row, int col, int cols) {
+    if(field == NULL) return;
+
+    initWidget(&field->base, drawField, 1, row, col, cols);
+    field->name = (name == NULL) ? "" : name;
+    field->value[0] = '\0';
+    field->selected = false;
+}
+
+void setField(fieldWidget_t * field, const char * value, bool selected) {
+    if(field == NULL) return;
+
+    bool changed = copyWidgetText(field->value, value);
+    if(changed || selected != field->selected) {
+        field->selected = selected;
+        invalidateWidget(&field->base);
+    }
+}
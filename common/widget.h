@@ -0,0 +1,183 @@
+#ifndef _WIDGET_H_
+#define _WIDGET_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dispBase.h"
+
+/*
+ * Widgets are retained pieces of a screen. Each one owns a rectangle of the
+ * frame buffer split into items (the lines of a menu, the blocks of a stat
+ * grid, ...) and remembers the state it last drew, so setting its state only
+ * marks the items that actually changed, and drawing it only redraws those.
+ * Text is clipped to the widget's width, so widgets side by side never draw
+ * over each other.
+ * After clearing the buffer (e.g. on switching screens), invalidate every
+ * widget on the new screen so that they are drawn in full.
+ */
+
+#define kMaxWidgetItems 64      // Items are tracked in a 64 bit mask
+#define kWidgetTextLen 128      // Longest text held by labels and fields
+
+struct widget_s;
+typedef void (*drawWidgetItem_t)(dispData_t * disp, const struct widget_s * widget, int item);
+
+typedef struct widget_s {
+    int row, col;               // Top-left corner on screen
+    int cols;                   // Width (<= 0 to reach the right of the screen)
+    int nItems;
+    uint64_t dirty;             // Items to redraw (bit i for item i)
+    drawWidgetItem_t drawItem;  // Draws (over) a single item
+} widget_t;
+
+// A single line of text
+typedef struct labelWidget_s {
+    widget_t base;
+    short palette;
+    char text[kWidgetTextLen];
+} labelWidget_t;
+
+// A list of items, one per line, with one selected
+typedef struct menuWidget_s {
+    widget_t base;
+    const char ** items;
+    int sel;
+} menuWidget_t;
+
+// A named value on a single line (highlighted while selected)
+typedef struct fieldWidget_s {
+    widget_t base;
+    const char * name;
+    char value[kWidgetTextLen];
+    bool selected;
+} fieldWidget_t;
+
+//=================================<Widgets>==================================//
+/**
+ * Initializes a widget (with every item dirty)
+ *
+ * @param widget The widget to initialize
+ * @param drawItem The function drawing its items
+ * @param nItems The number of items in it (at most kMaxWidgetItems)
+ * @param row The top row of the widget
+ * @param col The left column of the widget
+ * @param cols The width of the widget (<= 0 to reach the right of the screen)
+ */
+void initWidget(widget_t * widget, drawWidgetItem_t drawItem, int nItems, int row, int col,
+                int cols);
+
+/**
+ * Marks every item of a widget to be redrawn
+ *
+ * @param widget The widget to invalidate
+ */
+void invalidateWidget(widget_t * widget);
+
+/**
+ * Marks a single item of a widget to be redrawn
+ *
+ * @param widget The widget holding the item
+ * @param item The index of the item (ignored if out of range)
+ */
+void invalidateWidgetItem(widget_t * widget, int item);
+
+/**
+ * Buffers the items of a widget which have changed since it was last drawn
+ *
+ * @param disp The display data struct
+ * @param widget The widget to draw
+ *
+ * @return The number of items drawn
+ */
+int drawWidget(dispData_t * disp, widget_t * widget);
+
+/**
+ * Blanks out one row of a widget (for items to draw over)
+ *
+ * @param disp The display data struct
+ * @param widget The widget being drawn
+ * @param row The screen row to blank
+ */
+void clearWidgetRow(dispData_t * disp, const widget_t * widget, int row);
+
+/**
+ * Adds text to a row of a widget, clipped to its right edge (so that it never
+ * spills over a neighbouring widget)
+ *
+ * @param disp The display data struct
+ * @param widget The widget being drawn
+ * @param palette The palette to draw the text in
+ * @param text The text to add
+ * @param row The screen row to add it on
+ * @param col The screen column to start it at
+ */
+void addWidgetText(dispData_t * disp, const widget_t * widget, short palette, const char * text,
+                    int row, int col);
+
+//==================================<Labels>==================================//
+/**
+ * Initializes an empty label
+ *
+ * @param label The label to initialize
+ * @param row The row of the label
+ * @param col The left column of the label
+ * @param cols The width of the label (<= 0 to reach the right of the screen)
+ */
+void initLabel(labelWidget_t * label, int row, int col, int cols);
+
+/**
+ * Sets the text of a label (marking it dirty only if it changed)
+ *
+ * @param label The label to set
+ * @param palette The palette to draw the text in
+ * @param text The new text (truncated to kWidgetTextLen - 1 chars)
+ */
+void setLabel(labelWidget_t * label, short palette, const char * text);
+
+//==================================<Menus>===================================//
+/**
+ * Initializes a menu, drawing its items one per line
+ *
+ * @param menu The menu to initialize
+ * @param items The items of the menu (not copied, so must outlive it)
+ * @param nItems The number of items (at most kMaxWidgetItems)
+ * @param row The row of the first item
+ * @param col The left column of the menu
+ * @param cols The width of the menu (<= 0 to reach the right of the screen)
+ */
+void initMenuWidget(menuWidget_t * menu, const char ** items, int nItems, int row, int col,
+                    int cols);
+
+/**
+ * Selects an item of a menu (marking only the previous and new selection dirty)
+ *
+ * @param menu The menu to select in
+ * @param sel The index of the item to select (<0 for none)
+ */
+void setMenuSel(menuWidget_t * menu, int sel);
+
+//==================================<Fields>==================================//
+/**
+ * Initializes a field with an empty value
+ *
+ * @param field The field to initialize
+ * @param name The name shown before the value (not copied)
+ * @param row The row of the field
+ * @param col The left column of the field
+ * @param cols The width of the field (<= 0 to reach the right of the screen)
+ */
+void initField(fieldWidget_t * field, const char * name, int row, int col, int cols);
+
+/**
+ * Sets the value of a field (marking it dirty only if it changed)
+ *
+ * @param field The field to set
+ * @param value The new value (NULL for none, truncated to kWidgetTextLen - 1 chars)
+ * @param selected Highlight the field iff this is true
+ */
+void setField(fieldWidget_t * field, const char * value, bool selected);
+
+#endif
@@ -5,6 +5,7 @@
 
 #include <ncurses.h>
 #include "mapDisp.h"
+#include "mapPyramid.h"
 
 #include "sprite.h"
 #include "tile.h"
@@ -25,11 +26,21 @@ int main(int argc, char** argv) {
 
     //============================<Main Code>=============================//
     if(argc < 2) {
-        printf("Usage: %s <map file>\n\n", argv[0]);
+        printf("Usage: %s <map file> [p | c | ppm | png [s] | o [level]]\n", argv[0]);
+        printf("    p: Print in page sized sections\n");
+        printf("    c: Print in colour (ANSI escapes)\n");
+        printf("    ppm, png: Write an image (s for one colour per cell, no glyphs)\n");
+        printf("    o: Print an overview, a char per 2^level x 2^level tiles (default 0)\n\n");
         goto main_cleanup;
     }
     
-    bool doPages = argc > 2;
+    bool doColor = argc > 2 && strcmp(argv[2], "c") == 0;
+    bool doPPM = argc > 2 && strcmp(argv[2], "ppm") == 0;
+    bool doPNG = argc > 2 && strcmp(argv[2], "png") == 0;
+    bool doGlyphs = !(argc > 3 && strcmp(argv[3], "s") == 0);
+    bool doOverview = argc > 2 && strcmp(argv[2], "o") == 0;
+    int level = (argc > 3) ? atoi(argv[3]) : 0;
+    bool doPages = argc > 2 && !doColor && !doPPM && !doPNG && !doOverview;
 
     
     // Load in the tile data
@@ -58,9 +69,26 @@ int main(int argc, char** argv) {
 
     // Print the map to stdout
     if(doPages) {
-        mapToSections(data, map, stdout, 80, 64, true);
+        mapToSections(&data, &map, stdout, 80, 64, true);
+    } else if(doColor) {
+        mapToAnsiFile(&data, &map, stdout);
+    } else if(doOverview) {
+        mapPyramid_t pyramid;
+        initMapPyramid(&pyramid);
+        if(buildMapPyramid(&pyramid, &map) < 0 || overviewToFile(&pyramid, &map, level, stdout) < 0) {
+            fprintf(stderr, "*FATAL ERROR* Failed to write out the overview (%d levels)\n", 
+                        pyramid.nLevels);
+            rmMapPyramid(pyramid);
+            goto main_cleanup;
+        }
+        rmMapPyramid(pyramid);
+    } else if(doPPM || doPNG) {
+        if(mapToImage(&data, &map, stdout, doPNG ? kRasterPNG : kRasterPPM, doGlyphs) < 0) {
+            fprintf(stderr, "*FATAL ERROR* Failed to write out the image\n");
+            goto main_cleanup;
+        }
     } else {
-        mapToFile(data, map, stdout);
+        mapToFile(&data, &map, stdout);
     }
 
     status = EXIT_SUCCESS;
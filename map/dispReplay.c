@@ -0,0 +1,153 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include <ncurses.h>
+#include "../common/dispBase.h"
+
+// Define argument values
+#define kBackendFlag "-B"
+#define kFastFlag "-f"
+
+#define kQuitKey 'q'
+
+/**
+ * Gets the nanoseconds passed since the given time
+ */
+uint64_t nsSince(struct timespec then) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) (now.tv_sec - then.tv_sec) * 1000000000 + (now.tv_nsec - then.tv_nsec);
+}
+
+/**
+ * Waits until a frame is due (taking keys on a terminal meanwhile)
+ *
+ * @param disp The display data struct
+ * @param start When the replay started
+ * @param timeNs When the frame is due (ns after the start)
+ *
+ * @return true iff the quit key was pressed while waiting
+ */
+bool waitForFrame(dispData_t * disp, struct timespec start, uint64_t timeNs) {
+    uint64_t elapsed = nsSince(start);
+    while(elapsed < timeNs) {
+        uint64_t wait = timeNs - elapsed;
+        if(disp->termOpen) {
+            wtimeout(stdscr, (int) ((wait + 999999) / 1000000));
+            int ch = wgetch(stdscr);
+            wtimeout(stdscr, -1);
+            if(ch == kQuitKey) return true;
+        } else {
+            struct timespec delay = {wait / 1000000000, wait % 1000000000};
+            nanosleep(&delay, NULL);
+        }
+        elapsed = nsSince(start);
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    //============================<Core State>============================//
+    int status = EXIT_FAILURE;
+
+    FILE* fp = NULL;
+    const char * fileName = NULL;
+    const dispBackend_t * backend = &kCursesBackend;
+    bool fast = false;
+
+    dispData_t disp;
+    bool dispOpen = false;
+
+    //============================<Main Code>=============================//
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(kBackendFlag, argv[i]) == 0) {
+            if(++i >= argc || (backend = getDispBackend(argv[i])) == NULL) {
+                fprintf(stderr, "*FATAL ERROR* Expected a display backend (curses, ansi or null)\n");
+                goto main_cleanup;
+            }
+        } else if(strcmp(kFastFlag, argv[i]) == 0) {
+            fast = true;
+        } else {
+            fileName = argv[i];
+        }
+    }
+
+    if(fileName == NULL) {
+        printf("Usage: %s <recording> [%s <curses|ansi|null>] [%s]\n", argv[0], kBackendFlag,
+                    kFastFlag);
+        printf("    %s: Play frames back as fast as possible, rather than at recorded speed\n",
+                    kFastFlag);
+        printf("    With the null backend, frames are replayed without a terminal (with %s, \n",
+                    kFastFlag);
+        printf("    a rendering benchmark)\n");
+        printf("    On a terminal, %c stops the replay, and any key exits once it ends\n\n", kQuitKey);
+        goto main_cleanup;
+    }
+
+    // Open the recording
+    int rows, cols;
+    fp = fopen(fileName, "rb");
+    if(fp == NULL || readRecordHeader(fp, &rows, &cols) < 0) {
+        fprintf(stderr, "*FATAL ERROR* Unable to read a recording from \"%s\"\n", fileName);
+        goto main_cleanup;
+    }
+
+    // Replay onto the terminal, or headless at the recorded size
+    int ret = (backend == &kNullBackend) ? initDispBuffer(&disp, rows, cols)
+                                         : initDispBackend(&disp, backend);
+    if(ret != 0) {
+        fprintf(stderr, "*FATAL ERROR* Failed to initialize the display\n");
+        goto main_cleanup;
+    }
+    dispOpen = true;
+
+    // Play back every frame
+    recordFrame_t frame;
+    bool quit = false;
+    unsigned long nFrames = 0, nCells = 0;
+    uint64_t recordedNs = 0;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while((ret = readRecordFrame(fp, &disp, &frame)) == 0) {
+        if(!fast && waitForFrame(&disp, start, frame.timeNs)) {
+            quit = true;
+            break;
+        }
+
+        printBuffer(&disp);
+        ++nFrames;
+        nCells += frame.nCells;
+        recordedNs = frame.timeNs;
+    }
+    uint64_t replayNs = nsSince(start);
+
+    // Leave the last frame up until a key is pressed
+    if(disp.termOpen && !quit) {
+        getch();
+    }
+
+    closeDisp(disp);
+    dispOpen = false;
+
+    if(ret < 0) {
+        fprintf(stderr, "*ERROR* The recording is truncated after frame %lu\n", nFrames);
+    }
+
+    double replaySec = replayNs / 1e9;
+    printf("Replayed %lu frames (%lu cells) in %.3fs: %.1f frames/s (recorded over %.3fs)\n",
+                nFrames, nCells, replaySec, (replaySec > 0) ? nFrames / replaySec : 0,
+                recordedNs / 1e9);
+    status = (ret < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+
+main_cleanup:
+    if(dispOpen) closeDisp(disp);
+    if(fp != NULL) fclose(fp);
+
+    return status;
+}
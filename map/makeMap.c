@@ -5,10 +5,14 @@
 
 #include <ncurses.h>
 #include "mapDisp.h"
+#include "mapPyramid.h"
 
 #include "sprite.h"
+#include "spriteLib.h"
+#include "spritePicker.h"
 #include "tile.h"
 #include "map.h"
+#include "../common/job.h"
 
 //================================<Misc Data>=================================//
 // Define default values
@@ -17,11 +21,16 @@
 
 // Define argument values
 #define kMapFileFlag "-m"
+#define kBackendFlag "-B"
+#define kFrameRateFlag "-F"
+#define kTraceFlag "-P"
+#define kRecordFlag "-R"
 #define kUsageFlag "-?"
 
 //===============================<Menu Helpers>===============================//
 typedef enum mode_e {
-    menu, quit, new, load, save, nav, file, loadSprite, saveSprite, purgeSprites
+    menu, quit, new, load, save, nav, file, loadSprite, saveSprite, linkLib, 
+    purgeSprites
 } mode_t;
 
 const char * menuItems[] = {
@@ -32,8 +41,9 @@ const char * menuItems[] = {
     "5. Make Printable",
     "6. Load Sprite List",
     "7. Save Sprite List",
-    "8. Purge Sprites",
-    "9. Quit"
+    "8. Link Sprite Library",
+    "9. Purge Sprites",
+    "0. Quit"
 };
 
 mode_t menuModes[] = {
@@ -44,14 +54,99 @@ mode_t menuModes[] = {
     file,
     loadSprite,
     saveSprite,
+    linkLib,
     purgeSprites,
     quit
 };
 
 const int menuSize = sizeof(menuItems) / sizeof(menuItems[0]);
 
+//===============================<Zoom Levels>================================//
+// Tile sizes to zoom between in the edit screen ({width, height}, smallest first)
+const int tileSizes[][2] = {
+    {kCompactTileWidth, kCompactTileHeight},
+    {kTileWidth, kTileHeight},
+    {kLargeTileWidth, kLargeTileHeight}
+};
+
+const int nTileSizes = sizeof(tileSizes) / sizeof(tileSizes[0]);
+#define kDefZoom 1
+
+// Zooming out past the smallest tiles shows the map's overview, where zoom -1 
+// is level 0 of the map pyramid (a char per tile), -2 is level 1 and so on
+#define overviewLevel(zoom) (-(zoom) - 1)
+
+//==============================<Background Jobs>=============================//
+// Loading and saving maps, loading sprites and filling rooms run as jobs (see
+// job.h), one at a time, while the editor keeps drawing and editing. Each job
+// works on its own data below, which is committed to the editor when it ends
+typedef enum jobKind_e {
+    noJob, loadJob, saveJob, spriteJob, floodJob
+} jobKind_t;
+
+#define kJobPollDelay 100   // Screen updates while a job runs (in ms)
+#define kJobGraceDelay 50   // Wait for a job before leaving it in the background (in ms)
+#define kCancelKey 'x'
+#define kCancelHint "'x' to cancel"
+#define kJobBusyError "*ERROR* Wait for the running job to finish ('x' cancels it)"
+
+// A map being loaded (the job reads its tiles and builds its overview, then 
+// its sprite list is read on commit, as interning sprites isn't thread safe)
+typedef struct loadArgs_s {
+    FILE * fp;
+    map_t map;
+    mapPyramid_t pyramid;
+} loadArgs_t;
+
+// A map being saved (the job writes a snapshot of its tiles to a temporary 
+// file, then its sprite list is written and the file moved into place on 
+// commit, so a failed or cancelled save leaves the old file intact)
+typedef struct saveArgs_s {
+    FILE * fp;
+    map_t map;
+    int * remap;                // Where each sprite goes in the file
+    int nSprites;
+    char path[128];
+    char tmpPath[136];
+} saveArgs_t;
+
+// A sprite list being loaded (the job reads the sprites, which are interned 
+// and added to the sprite list on commit)
+typedef struct spriteArgs_s {
+    FILE * fp;
+    long size;
+    sprite_t * sprites;
+    int nSprites, capacity;
+} spriteArgs_t;
+
+// A room being filled (the job floods a snapshot of the map's walls, then the
+// filled tiles are painted on commit)
+typedef struct floodArgs_s {
+    unsigned char * cells;  // Flood flags for each tile (row major)
+    int nRows, nCols;
+    int x, y;
+    short palette;
+    int bounds[4];          // The tiles filled ({x0, y0, x1, y1})
+} floodArgs_t;
+
+// Flood flags for a tile
+#define kFloodOpen 0x01     // Not empty
+#define kFloodUp 0x02       // Walls on each side
+#define kFloodDown 0x04
+#define kFloodLeft 0x08
+#define kFloodRight 0x10
+#define kFloodFilled 0x20
+#define kFloodReport 4096   // Tiles filled between progress reports
+
+static job_t job;
+static jobKind_t jobKind = noJob;
+static loadArgs_t loadArgs;
+static saveArgs_t saveArgs;
+static spriteArgs_t spriteArgs;
+static floodArgs_t floodArgs;
+
 //============================<Helper Definitions>============================//
-#define printError(msg) clear();printText(kRedPalette, msg, 0, 0); getch()
+#define printError(msg) clear();printText(kRedPalette, msg, 0, 0); getKey()
 
 #ifndef min
 #define min(a, b) ((a < b) ? a : b)
@@ -61,29 +156,71 @@ const int menuSize = sizeof(menuItems) / sizeof(menuItems[0]);
 #define max(a, b) ((a > b) ? a : b)
 #endif
 
-void floodRoom(map_t * map, int x, int y);
+int startMapJob(jobKind_t kind, const char * name, jobFxn_t run, void * arg);
+
+void dropJob();
+
+int startLoadJob(FILE * fp);
+
+int startSaveJob(const map_t * map, list_t sprites, const char * path);
+
+int startSpriteJob(FILE * fp);
+
+int startFloodJob(const map_t * map, int x, int y);
+
+bool isFloodEdit(int ch);
+
+void spritesChanged(tileData_t * data, spritePicker_t * picker);
 
 void printHelp(mode_t mode);
 
 FILE* promptFile(bool openRead);
 
+void promptPath(char * buf, int nBuf);
+
 //================================<Main Code>=================================//
 int main(int argc, char** argv) {
     int status = EXIT_FAILURE;
 
     int ret, ch;
     int x = 0, y = 0;
+    int zoom = kDefZoom;
     char buf[80];
+    char tagBuf[80] = "";
+    const unsigned * tagged;
 
     FILE * fp;
 
     bool mapLoaded = false;
     map_t map;
 
+    mapPyramid_t pyramid;
+    initMapPyramid(&pyramid);
+    int bounds[4];
+
+    // Split screen viewports (the focused one follows x, y and zoom)
+    bool split = false;
+    viewport_t ports[2];
+    int portZoom[2];
+    int focus = 0;
+    bool editHeld = false;      // Last key was an edit held off by a running fill
+
+    // Render profiling (shown over the bottom row, and traced to file)
+    bool showStats = false;
+    frameStats_t stats;
+    memset(&stats, 0, sizeof(frameStats_t));
+    FILE * traceFp = NULL;
+    FILE * recordFp = NULL;     // Recording of every printed frame
+
     bool dispOpen = false;
+    bool jobReady = false;
+    const dispBackend_t * backend = &kCursesBackend;
     bool tilesLoaded = false;
     tileData_t data;
 
+    spritePicker_t picker;
+    initSpritePicker(&picker);
+
     //==========================<Initialization>==========================//
     // Load the tile data
     if(loadTileData(&data)) {
@@ -92,10 +229,18 @@ int main(int argc, char** argv) {
     }
     tilesLoaded = true;
 
+    // Prepare for background jobs
+    if(initJob(&job) < 0) {
+        fprintf(stderr, "*FATAL ERROR* Failed to set up background jobs\n");
+        goto main_cleanup;
+    }
+    jobReady = true;
+
     // Parse the Arguments 
     for(int i = 1; i < argc; i++) {
         if(strcmp(kUsageFlag, argv[i]) == 0) {  // Argument to print usage msg
-            printf("Usage: %s [%s <Map File>]\n", argv[0], kMapFileFlag);
+            printf("Usage: %s [%s <Map File>] [%s <curses|ansi|null>] [%s <Max FPS>] [%s <CSV File>] [%s <Recording>]\n", 
+                        argv[0], kMapFileFlag, kBackendFlag, kFrameRateFlag, kTraceFlag, kRecordFlag);
             status = EXIT_SUCCESS;
             goto main_cleanup;
         } else if (strcmp(kMapFileFlag, argv[i]) == 0) { // Argument to pre-load map
@@ -128,6 +273,33 @@ int main(int argc, char** argv) {
 
             // Mark the map as loaded
             mapLoaded = true;
+            spritesChanged(&data, &picker);
+            buildMapPyramid(&pyramid, &map);
+        } else if (strcmp(kBackendFlag, argv[i]) == 0) { // Argument to pick the display backend
+            if(++i >= argc || (backend = getDispBackend(argv[i])) == NULL) {
+                fprintf(stderr, "*FATAL ERROR* Expected a display backend (curses, ansi or null)\n");
+                goto main_cleanup;
+            }
+        } else if (strcmp(kFrameRateFlag, argv[i]) == 0) { // Argument to cap the frame rate
+            char * end;
+            long fps = (++i < argc) ? strtol(argv[i], &end, 10) : -1;
+            if(fps < 0 || *end != '\0') {
+                fprintf(stderr, "*FATAL ERROR* Expected a frame rate (0 for uncapped)\n");
+                goto main_cleanup;
+            }
+            setFrameRate(fps);
+        } else if (strcmp(kTraceFlag, argv[i]) == 0) { // Argument to trace each frame to CSV
+            if(traceFp != NULL || ++i >= argc || (traceFp = fopen(argv[i], "w")) == NULL) {
+                fprintf(stderr, "*FATAL ERROR* Unable to open a frame trace file\n");
+                goto main_cleanup;
+            }
+            setFrameTrace(traceFp);
+        } else if (strcmp(kRecordFlag, argv[i]) == 0) { // Argument to record each frame (see dispReplay)
+            if(recordFp != NULL || ++i >= argc || (recordFp = fopen(argv[i], "wb")) == NULL) {
+                fprintf(stderr, "*FATAL ERROR* Unable to open a recording file\n");
+                goto main_cleanup;
+            }
+            setFrameRecord(recordFp);
         } else {
             fprintf(stderr, "*FATAL ERROR* Unkown argument \"%s\"\n", argv[i]);
             goto main_cleanup;
@@ -135,12 +307,17 @@ int main(int argc, char** argv) {
     }
 
     // Initialize the display
-    if(initDisp(&data.dispData) != 0) {
+    if(initDispBackend(&data.dispData, backend) != 0) {
         fprintf(stderr, "*FATAL ERROR* Failed to initialize the display\n");
         goto main_cleanup;
     }
     dispOpen = true;
 
+    // Take keys on their own thread, so that slow frames and long operations 
+    // (saving, flood fills) never hold up typing (keys are read as they are 
+    // needed if the thread can't start)
+    startInputThread(&data.dispData);
+
     // Set the initial mode and navigation
     mode_t mode = menu, prevMode = mode;
 
@@ -148,7 +325,122 @@ int main(int argc, char** argv) {
         mode = nav;
     }
     //============================<Main Loop>=============================//
-    while(mode != quit) {
+    // (Quitting waits for any running job, so a save in progress isn't lost)
+    while(mode != quit || jobKind != noJob) {
+        // Commit the result of a finished background job
+        if(jobKind != noJob && waitForJob(&job, 0)) {
+            jobKind_t kind = jobKind;
+            jobKind = noJob;
+            ret = finishJob(&job);
+
+            switch(kind) {
+                case loadJob: {
+                    // Read the sprite list, and swap the new map in for the old
+                    list_t sprites = NULL;
+                    if(ret == 0 && (ret = loadMapSpriteList(&sprites, loadArgs.fp)) < 0) {
+                        rmMap(loadArgs.map);
+                        rmMapPyramid(loadArgs.pyramid);
+                    }
+                    fclose(loadArgs.fp);
+
+                    if(ret < 0) {
+                        if(ret != -5) {
+                            printError("*ERROR* Unable to read map from file");
+                        }
+                        break;
+                    }
+
+                    if(mapLoaded) rmMap(map);
+                    if(data.spriteList != NULL) rmList(data.spriteList, freeSpriteEntry);
+                    rmMapPyramid(pyramid);
+                    map = loadArgs.map;
+                    pyramid = loadArgs.pyramid;
+                    data.spriteList = sprites;
+                    mapLoaded = true;
+                    spritesChanged(&data, &picker);
+
+                    // Keep any views of the old map on the new one
+                    for(int i = 0; split && i < 2; i++) {
+                        ports[i].x = min(ports[i].x, map.nCols - 1);
+                        ports[i].y = min(ports[i].y, map.nRows - 1);
+                    }
+                    if(mode == nav) {
+                        x = min(x, map.nCols - 1);
+                        y = min(y, map.nRows - 1);
+                    }
+                    break;
+                }
+
+                case saveJob:
+                    // Finish the file and move it into place
+                    if(ret == 0) {
+                        ret = writeMapSpriteList(data.spriteList, saveArgs.remap, 
+                                                    saveArgs.nSprites, saveArgs.fp);
+                    }
+                    if(fclose(saveArgs.fp) != 0 && ret == 0) {
+                        ret = -2;
+                    }
+                    if(ret == 0 && rename(saveArgs.tmpPath, saveArgs.path) != 0) {
+                        ret = -2;
+                    }
+                    if(ret < 0) {
+                        remove(saveArgs.tmpPath);
+                    }
+                    rmMap(saveArgs.map);
+                    if(saveArgs.remap != NULL) free(saveArgs.remap);
+
+                    if(ret < 0 && ret != -5) {
+                        printError("*ERROR* Unable to write map to file");
+                    }
+                    break;
+
+                case spriteJob:
+                    // Add the sprites read to the list (none if cancelled)
+                    fclose(spriteArgs.fp);
+                    for(int i = 0; i < spriteArgs.nSprites; i++) {
+                        if(ret < 0) {
+                            rmSprite(spriteArgs.sprites[i]);
+                            continue;
+                        }
+
+                        sprite_t * entry = internSprite(spriteArgs.sprites[i]);
+                        if(entry == NULL || listAppend(data.spriteList, entry) < 0) {
+                            if(entry != NULL) freeSpriteEntry(entry);
+                            ret = -3;
+                        }
+                    }
+                    if(spriteArgs.sprites != NULL) free(spriteArgs.sprites);
+                    spritesChanged(&data, &picker);
+
+                    if(ret < 0 && ret != -5) {
+                        printError("*ERROR* Failed to load sprites from list");
+                    }
+                    break;
+
+                case floodJob:
+                    // Paint the filled tiles (unless the map has been replaced, 
+                    // edits changing the room are held off while it fills)
+                    if(ret == 0 && mapLoaded && map.nRows == floodArgs.nRows && 
+                            map.nCols == floodArgs.nCols) {
+                        int * fill = floodArgs.bounds;
+                        for(int row = fill[1]; row <= fill[3]; row++) {
+                            for(int col = fill[0]; col <= fill[2]; col++) {
+                                if((floodArgs.cells[row * map.nCols + col] & kFloodFilled) && 
+                                        !map.data[row][col].isEmpty) {
+                                    map.data[row][col].bgPalette = floodArgs.palette;
+                                }
+                            }
+                        }
+                        updateMapPyramid(&pyramid, &map, fill[0], fill[1], fill[2], fill[3]);
+                    }
+                    free(floodArgs.cells);
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
         // If the mode has changed, update the cursor coords to their default values
         if(prevMode != mode) {
             switch(mode) {
@@ -173,25 +465,28 @@ int main(int argc, char** argv) {
         switch(mode) {
             //======================<Main Menu>=======================//
             case menu:
-                // Print the menu text
-                addMenu(&data.dispData, "Make Map", menuItems, menuSize, y);
-                addText(&data.dispData, kBlackPalette, (mapLoaded) ? "A map is loaded" : "No map loaded", menuSize+3, 0);
-                if(data.spriteList == NULL) {
-                    addText(&data.dispData, kBlackPalette, "No sprite list loaded", menuSize+4, 0);
-                } else {
-                    sprintf(buf, "%d sprites in list", listLen(data.spriteList));
-                    addText(&data.dispData, kBlackPalette, buf, menuSize+4, 0);
+                // Print the menu text (once any waiting keys are applied)
+                if(shouldRender(&data.dispData)) {
+                    addMenu(&data.dispData, "Make Map", menuItems, menuSize, y);
+                    addText(&data.dispData, kBlackPalette, (mapLoaded) ? "A map is loaded" : "No map loaded", menuSize+3, 0);
+                    if(data.spriteList == NULL) {
+                        addText(&data.dispData, kBlackPalette, "No sprite list loaded", menuSize+4, 0);
+                    } else {
+                        sprintf(buf, "%d sprites in list", listLen(data.spriteList));
+                        addText(&data.dispData, kBlackPalette, buf, menuSize+4, 0);
+                    }
+                    addJobStatus(&data.dispData, &job, kCancelHint, menuSize+6);
+                    printBuffer(&data.dispData);
+                    curs_set(0);
                 }
-                printBuffer(data.dispData);
-                curs_set(0);
 
-                // Get the next input
-                ch = getch();
+                // Get the next input (updating the job's progress meanwhile)
+                ch = getKeyTimeout((jobKind != noJob) ? kJobPollDelay : -1);
 
-                // If the input is a valid menu option, take it
-                if(ch > '0' && ch <= '0' + menuSize) {
+                // If the input is a valid menu option, take it ('0' is the tenth)
+                if(ch >= '0' && ch <= '9' && (ch - '1' + 10) % 10 < menuSize) {
                     y = 0;
-                    mode = menuModes[ch - '1'];
+                    mode = menuModes[(ch - '1' + 10) % 10];
                     break;
                 }
 
@@ -217,6 +512,12 @@ int main(int argc, char** argv) {
                         mode = menuModes[y];
                         break;
                     
+                    // Cancel the background job
+                    case kCancelKey:
+                    case 'X':
+                        cancelJob(&job);
+                        break;
+
                     // Quit with '`' or '~'
                     case '`':
                     case '~':
@@ -237,7 +538,7 @@ int main(int argc, char** argv) {
                 curs_set(0);
 
                 // Get and act on input
-                ch = getch();
+                ch = getKey();
                 switch(ch) {
                     // Arrow keys modify size
                     case KEY_UP:
@@ -263,6 +564,11 @@ int main(int argc, char** argv) {
                     // This case handles when dimensions are confirmed
                     case KEY_ENTER:
                     case '\n':
+                        if(jobKind != noJob) {
+                            printError(kJobBusyError);
+                            break;
+                        }
+
                         if(mapLoaded) {
                             rmMap(map);
                             mapLoaded = false;
@@ -273,6 +579,7 @@ int main(int argc, char** argv) {
                             mode = menu;
                         } else {
                             mapLoaded = true;
+                            buildMapPyramid(&pyramid, &map);
                             mode = nav;
                         }
                         break;
@@ -281,6 +588,13 @@ int main(int argc, char** argv) {
 
             //========================<Load Map>=========================//
             case load:
+                // Wait out any job already running
+                if(jobKind != noJob) {
+                    printError(kJobBusyError);
+                    mode = menu;
+                    break;
+                }
+
                 // Prompt the user for the map file
                 fp = promptFile(true);
                 if(fp == NULL) {
@@ -289,24 +603,12 @@ int main(int argc, char** argv) {
                     break;
                 }
 
-                // If a map or sprite list are already loaded, free them
-                if(mapLoaded) {
-                    rmMap(map);
-                    mapLoaded = false;
-                }
-
-                if(data.spriteList != NULL) {
-                    rmList(data.spriteList, freeSpriteEntry);
-                    data.spriteList = NULL;
-                }
-
-                // Actually load the map
-                if(loadMap(&map, &data.spriteList, fp) < 0) {
-                    printError("*ERROR* Unable to read map from file");
-                } else {
-                    mapLoaded = true;
+                // Load the map in the background (the map and sprite list 
+                // loaded are replaced once it has loaded)
+                if(startLoadJob(fp) < 0) {
+                    fclose(fp);
+                    printError("*ERROR* Unable to start loading the map");
                 }
-                fclose(fp);
 
                 mode = menu;
                 break;
@@ -319,19 +621,22 @@ int main(int argc, char** argv) {
                     break;
                 }
 
-                // Prompt the user for a (writable) file
-                fp = promptFile(false);
-                if(fp == NULL) {
-                    printError("*ERROR* Unable to open map file");
+                // Wait out any job already running
+                if(jobKind != noJob) {
+                    printError(kJobBusyError);
                     mode = menu;
                     break;
                 }
 
-                // Attempt to writhe the map to file and close it
-                if(writeMap(map, data.spriteList, fp) < 0) {
-                    printError("*ERROR* Unable to write map to file");
+                // Prompt the user for a file, and save a snapshot of the map 
+                // to it in the background
+                promptPath(buf, sizeof(buf));
+                ret = startSaveJob(&map, data.spriteList, buf);
+                if(ret == -2) {
+                    printError("*ERROR* Unable to open map file");
+                } else if(ret < 0) {
+                    printError("*ERROR* Unable to start saving the map");
                 }
-                fclose(fp);
 
                 mode = menu;
                 break;
@@ -344,16 +649,87 @@ int main(int argc, char** argv) {
                     break;
                 }
 
-                // Add the map to the buffer and print
-                clearBuffer(&data.dispData);
-                addMap(&data, map, x, y);
-                clear();
-                printBuffer(data.dispData);
-                setCursor(data, map, x, y);
-                curs_set(1);
+                // Drop back to the tiles if the overview is unavailable
+                if(zoom < 0 && overviewLevel(zoom) >= pyramid.nLevels) {
+                    zoom = 0;
+                }
+
+                // Add the map (or its overview, or both viewports) to the buffer 
+                // and print (once any waiting keys are applied)
+                if(shouldRender(&data.dispData)) {
+                    beginFrame();
+                    beginStage(kStageFill);
+                    clearBuffer(&data.dispData);
+                    endStage(kStageFill);
+
+                    beginStage(kStageCompose);
+                    if(split) {
+                        int half = data.dispData.screenCols / 2;
+                        placeViewport(&ports[0], 0, 0, data.dispData.screenRows, half);
+                        placeViewport(&ports[1], 0, half + 1, data.dispData.screenRows, 
+                                        data.dispData.screenCols - half - 1);
+                        ports[focus].x = x;
+                        ports[focus].y = y;
+
+                        addViewport(&data, &ports[0], &map);
+                        addViewport(&data, &ports[1], &map);
+                        for(int row = 0; row < data.dispData.screenRows; row++) {
+                            addText(&data.dispData, kBlackPalette, "|", row, half);
+                        }
+                    } else if(zoom < 0) {
+                        addMapOverview(&data.dispData, &pyramid, &map, overviewLevel(zoom), x, y);
+                    } else {
+                        addMap(&data, &map, x, y);
+                    }
+                    endStage(kStageCompose);
+
+                    // Show the last frame's measurements and the job's progress 
+                    // (along the bottom, the job lowest)
+                    int statusRow = data.dispData.screenRows - 1;
+                    if(jobKind != noJob) {
+                        addJobStatus(&data.dispData, &job, kCancelHint, statusRow--);
+                    }
+                    if(editHeld && jobKind == floodJob) {
+                        addText(&data.dispData, kRedPalette, kJobBusyError, statusRow--, 0);
+                    }
+                    if(showStats) {
+                        beginStage(kStageFill);
+                        addFrameStats(&data.dispData, &stats, statusRow);
+                        endStage(kStageFill);
+                    }
+
+                    // Place the cursor before printing, so it goes out with the frame
+                    if(split) {
+                        setViewportCursor(&ports[focus], &map);
+                    } else if(zoom < 0) {
+                        setOverviewCursor(&data.dispData, &pyramid, overviewLevel(zoom), x, y);
+                    } else {
+                        setCursor(&data, &map, x, y);
+                    }
+                    curs_set(1);
+                    printBuffer(&data.dispData);
+                    stats = endFrame();
+                }
+
+                // The cursor moves a cell of the overview at a time
+                int step = (zoom < 0) ? 1 << overviewLevel(zoom) : 1;
+
+                // Get and act on input (noting the tiles which may be edited)
+                bounds[0] = x - 1;
+                bounds[1] = y - 1;
+                bounds[2] = x + 1;
+                bounds[3] = y + 1;
+                ch = getKeyTimeout((jobKind != noJob) ? kJobPollDelay : -1);
+
+                // Hold off edits the room being filled would paint over (saying 
+                // so until the next key taken)
+                if(jobKind == floodJob && isFloodEdit(ch)) {
+                    ch = ERR;
+                    editHeld = true;
+                } else if(ch != ERR) {
+                    editHeld = false;
+                }
 
-                // Get and act on input
-                ch = getch();
                 switch(ch) {
                     // Change modes
                     case KEY_HOME:
@@ -377,16 +753,16 @@ int main(int argc, char** argv) {
                     
                     // Cursor Control with arrows
                     case KEY_UP:
-                        y = max(y-1, 0);
+                        y = max(y-step, 0);
                         break;
                     case KEY_DOWN:
-                        y = min(y+1, map.nRows-1);
+                        y = min(y+step, map.nRows-1);
                         break;
                     case KEY_LEFT:
-                        x = max(x-1, 0);
+                        x = max(x-step, 0);
                         break;
                     case KEY_RIGHT:
-                        x = min(x+1, map.nCols-1);
+                        x = min(x+step, map.nCols-1);
                         break;
                     
                     // Set walls on current cell with WASD
@@ -442,7 +818,14 @@ int main(int argc, char** argv) {
                     
                     case 'p':   // Fill the current room w/ the current palette
                     case 'P':
-                        floodRoom(&map, x, y);
+                        if(jobKind == noJob) {  // (painted in once filled)
+                            startFloodJob(&map, x, y);
+                        }
+                        break;
+
+                    case kCancelKey:    // Cancel the background job
+                    case 'X':
+                        cancelJob(&job);
                         break;
 
                     // Sprite setting
@@ -457,12 +840,130 @@ int main(int argc, char** argv) {
                             break;
                         }
                         ch = max(getSpriteIdx(map.data[y][x]), -1);
-                        setSpriteIdx(data, &map.data[y][x], (ch + 1) % ret);
+                        setSpriteIdx(&data, &map.data[y][x], (ch + 1) % ret);
+                        break;
+
+                    case 'n':   // Place a sprite by name
+                    case 'N':
+                        clear();
+                        printText(kBlackPalette, "Enter the sprite name", 0, 0);
+                        getText(2, 0, buf, sizeof(buf));
+
+                        if((ret = findSpriteByName(&data.spriteIndex, buf)) < 0) {
+                            printError("*ERROR* No sprite by that name");
+                            break;
+                        }
+                        setSpriteIdx(&data, &map.data[y][x], ret);
+                        break;
+
+                    case 't':   // Next sprite with a tag
+                    case 'T':
+                        clear();
+                        printText(kBlackPalette, "Enter the sprite tag (blank for the last tag)", 0, 0);
+                        getText(2, 0, buf, sizeof(buf));
+                        if(buf[0] != '\0') {
+                            strcpy(tagBuf, buf);
+                        }
+
+                        if((ret = findSpritesByTag(&data.spriteIndex, tagBuf, &tagged)) == 0) {
+                            printError("*ERROR* No sprites with that tag");
+                            break;
+                        }
+
+                        // Take the first tagged sprite after the current one
+                        ch = getSpriteIdx(map.data[y][x]);
+                        int next = 0;
+                        while(next < ret && (int) tagged[next] <= ch) ++next;
+                        setSpriteIdx(&data, &map.data[y][x], tagged[next % ret]);
+                        break;
+
+                    case 'b':   // Browse the loaded sprites
+                    case 'B':
+                        picker.sel = max(getSpriteIdx(map.data[y][x]), 0);
+                        if((ret = pickSprite(&data.dispData, &picker, &data.spriteIndex)) >= 0) {
+                            setSpriteIdx(&data, &map.data[y][x], ret);
+                        }
+                        break;
+
+                    // View Controls
+                    case '+':   // Zoom in (larger tiles)
+                    case '=':
+                        if(split) {     // Only the focused viewport zooms
+                            if(zoom + 1 < nTileSizes && resizeViewport(&ports[focus], 
+                                    tileSizes[zoom + 1][0], tileSizes[zoom + 1][1]) == 0) {
+                                portZoom[focus] = ++zoom;
+                            }
+                        } else if(zoom < 0) {  // Overview levels need no resizing
+                            ++zoom;
+                        } else if(zoom + 1 < nTileSizes && resizeTileData(&data, 
+                                tileSizes[zoom + 1][0], tileSizes[zoom + 1][1]) == 0) {
+                            ++zoom;
+                        }
+                        break;
+
+                    case '-':   // Zoom out (smaller tiles, then the overview)
+                    case '_':
+                        if(split) {     // Viewports have no overview
+                            if(zoom > 0 && resizeViewport(&ports[focus], 
+                                    tileSizes[zoom - 1][0], tileSizes[zoom - 1][1]) == 0) {
+                                portZoom[focus] = --zoom;
+                            }
+                        } else if(zoom <= 0) {
+                            if(overviewLevel(zoom - 1) < pyramid.nLevels) --zoom;
+                        } else if(resizeTileData(&data, 
+                                tileSizes[zoom - 1][0], tileSizes[zoom - 1][1]) == 0) {
+                            --zoom;
+                        }
+                        break;
+
+                    case '|':   // Split the screen into two viewports (or join it)
+                        if(split) {
+                            // The full screen view takes the focused viewport's zoom
+                            if(resizeTileData(&data, tileSizes[zoom][0], tileSizes[zoom][1]) < 0) {
+                                break;
+                            }
+                            rmViewport(ports[0]);
+                            rmViewport(ports[1]);
+                            split = false;
+                            break;
+                        }
+
+                        zoom = max(zoom, 0);
+                        if(initViewport(&ports[0], tileSizes[zoom][0], tileSizes[zoom][1]) < 0) {
+                            break;
+                        }
+                        if(initViewport(&ports[1], tileSizes[zoom][0], tileSizes[zoom][1]) < 0) {
+                            rmViewport(ports[0]);
+                            break;
+                        }
+                        for(int i = 0; i < 2; i++) {
+                            ports[i].x = x;
+                            ports[i].y = y;
+                            portZoom[i] = zoom;
+                        }
+                        focus = 0;
+                        split = true;
+                        break;
+
+                    case '\t':  // Switch focus to the other viewport
+                        if(!split) break;
+
+                        ports[focus].x = x;
+                        ports[focus].y = y;
+                        focus = !focus;
+                        x = ports[focus].x;
+                        y = ports[focus].y;
+                        zoom = portZoom[focus];
+                        break;
+
+                    case 'f':   // Toggle the render profile
+                    case 'F':
+                        showStats = !showStats;
                         break;
 
                     case 'g':   // Character sprite
                     case 'G':
-                        setCharSprite(&map.data[y][x], getch(), kDefPalette);
+                        setCharSprite(&map.data[y][x], getKey(), kDefPalette);
                         break;
 
                     // Misc Controls
@@ -471,6 +972,9 @@ int main(int argc, char** argv) {
                         printHelp(mode);
                         break;
                 }
+
+                // Bring the overview up to date with any edits
+                updateMapPyramid(&pyramid, &map, bounds[0], bounds[1], bounds[2], bounds[3]);
                 break;
 
             //================<Output to printable files>================//
@@ -484,7 +988,7 @@ int main(int argc, char** argv) {
                 // Prompt the user for the inclusion of sprites
                 clear();
                 printText(kBlackPalette, "Include sprites [Y/n]? ", 0, 0);
-                ch = getch();
+                ch = getKey();
 
                 // Prompt the user for a (writeable) filename
                 fp = promptFile(false);
@@ -495,7 +999,7 @@ int main(int argc, char** argv) {
                 }
 
                 // Attempt to output the file in printable sections
-                ret = mapToSections(data, map, fp, 80, 64, !(ch == 'N' || ch == 'n'));
+                ret = mapToSections(&data, &map, fp, 80, 64, !(ch == 'N' || ch == 'n'));
                 if(ret < 0) {
                     sprintf(buf, "*ERROR* Failed to write out to file (%d)", ret);
                     printError(buf);
@@ -508,6 +1012,13 @@ int main(int argc, char** argv) {
 
             //======================<Load Sprites>=======================//
             case loadSprite:
+                // Wait out any job already running
+                if(jobKind != noJob) {
+                    printError(kJobBusyError);
+                    mode = menu;
+                    break;
+                }
+
                 // Ensure that there is a sprite list
                 if(data.spriteList == NULL) {
                     if((data.spriteList = mkList()) == NULL) {
@@ -524,14 +1035,12 @@ int main(int argc, char** argv) {
                     break;
                 }
 
-                // Load sprites into the list
-                if(loadSpriteList(fp, &data.spriteList) < 0) {
-                    printError("*ERROR* Failed to load sprites from list");
+                // Load sprites into the list in the background
+                if(startSpriteJob(fp) < 0) {
+                    fclose(fp);
+                    printError("*ERROR* Failed to start loading sprites");
                 }
 
-                // Close the file
-                fclose(fp);
-
                 // Quit back to the main menu
                 mode = menu;
                 break;
@@ -563,18 +1072,87 @@ int main(int argc, char** argv) {
                 mode = menu;
                 break;
             
+            //===================<Link Sprite Library>===================//
+            case linkLib:
+                // Wait out any job already running
+                if(jobKind != noJob) {
+                    printError(kJobBusyError);
+                    mode = menu;
+                    break;
+                }
+
+                // Ensure that there is a sprite list
+                if(data.spriteList == NULL) {
+                    if((data.spriteList = mkList()) == NULL) {
+                        printError("*ERROR* Failed to create a new sprite list");
+                        mode = menu;
+                        break;
+                    }
+                }
+
+                // Prompt for and open the library (sprites load on first use)
+                clear();
+                printText(kBlackPalette, "Enter the sprite library path", 0, 0);
+                getText(2, 0, buf, sizeof(buf));
+
+                spriteLib_t lib = openSpriteLib(buf);
+                if(lib == NULL) {
+                    printError("*ERROR* Failed to open sprite library");
+                    mode = menu;
+                    break;
+                }
+
+                if(linkSpriteLib(lib, data.spriteList) < 0) {
+                    printError("*ERROR* Failed to link sprite library");
+                }
+                closeSpriteLib(lib);
+                spritesChanged(&data, &picker);
+
+                mode = menu;
+                break;
+
             //====================<Purge Sprite List>====================//
             case purgeSprites:
+                // Wait out any job already running
+                if(jobKind != noJob) {
+                    printError(kJobBusyError);
+                    mode = menu;
+                    break;
+                }
+
                 if(data.spriteList == NULL) {
                     break;
                 }
 
                 rmList(data.spriteList, freeSpriteEntry);
                 data.spriteList = NULL;
+                spritesChanged(&data, &picker);
 
                 mode = menu;
                 break;
 
+            //=====================<Quit (Waiting)>=====================//
+            case quit:
+                // A fill would only paint a map about to be thrown away
+                if(jobKind == floodJob) {
+                    cancelJob(&job);
+                }
+
+                // Show the job's progress until it finishes and is committed
+                if(shouldRender(&data.dispData)) {
+                    clearBuffer(&data.dispData);
+                    addText(&data.dispData, kBlackPalette, "Finishing the running job before quitting", 0, 0);
+                    addJobStatus(&data.dispData, &job, kCancelHint, 2);
+                    printBuffer(&data.dispData);
+                    curs_set(0);
+                }
+
+                ch = getKeyTimeout(kJobPollDelay);
+                if(ch == kCancelKey || ch == 'X') {
+                    cancelJob(&job);
+                }
+                break;
+
             //=========================<Default>=========================//
             default:    // All other modes should simply quit
                 mode = quit;
@@ -584,90 +1162,335 @@ int main(int argc, char** argv) {
     
     status = EXIT_SUCCESS;
 main_cleanup:
-    // Cleanup and exit successfully
+    // Cleanup and exit (dropping any unfinished job, on failure)
+    if(jobReady) {
+        dropJob();
+        rmJob(&job);
+    }
     if(dispOpen) closeDisp(data.dispData);
     if(tilesLoaded) rmTileData(data);
+    if(split) {
+        rmViewport(ports[0]);
+        rmViewport(ports[1]);
+    }
+    rmSpritePicker(picker);
+    if(traceFp != NULL) {
+        setFrameTrace(NULL);
+        fclose(traceFp);
+    }
+    if(recordFp != NULL) {
+        setFrameRecord(NULL);
+        fclose(recordFp);
+    }
+    rmMapPyramid(pyramid);
     if(mapLoaded) rmMap(map);
 
     return status;
 }
 
-//===========================<Color Flood Helpers>============================//
-void floodRoomRec(map_t * map, bool** visited, short palette, int x, int y) {
-    // Caller checks position for wall detection
-    if(visited[y][x] || map->data[y][x].isEmpty) { 
-        return;
+//================================<Job Helpers>===============================//
+/**
+ * Starts a background job working on its args above (leaving it in the 
+ * background only if it doesn't finish at once)
+ */
+int startMapJob(jobKind_t kind, const char * name, jobFxn_t run, void * arg) {
+    if(jobKind != noJob || startJob(&job, name, run, arg) < 0) {
+        return -1;
+    }
+
+    jobKind = kind;
+    waitForJob(&job, kJobGraceDelay);
+    return 0;
+}
+
+void dropJob() {
+    if(jobKind == noJob) return;
+
+    cancelJob(&job);
+    int ret = finishJob(&job);
+
+    switch(jobKind) {
+        case loadJob:
+            if(ret == 0) {
+                rmMap(loadArgs.map);
+                rmMapPyramid(loadArgs.pyramid);
+            }
+            fclose(loadArgs.fp);
+            break;
+        case saveJob:
+            fclose(saveArgs.fp);
+            remove(saveArgs.tmpPath);
+            rmMap(saveArgs.map);
+            if(saveArgs.remap != NULL) free(saveArgs.remap);
+            break;
+        case spriteJob:
+            fclose(spriteArgs.fp);
+            for(int i = 0; i < spriteArgs.nSprites; i++) {
+                rmSprite(spriteArgs.sprites[i]);
+            }
+            if(spriteArgs.sprites != NULL) free(spriteArgs.sprites);
+            break;
+        case floodJob:
+            free(floodArgs.cells);
+            break;
+        default:
+            break;
+    }
+    jobKind = noJob;
+}
+
+//=============================<Load and Save Jobs>===========================//
+/**
+ * Reads a map's tiles and builds its overview (a job)
+ */
+int runLoadJob(job_t * job, void * arg) {
+    loadArgs_t * load = arg;
+
+    int ret = loadMapTiles(&load->map, load->fp, setJobProgress, job);
+    if(ret < 0) {
+        return ret;
+    }
+
+    initMapPyramid(&load->pyramid);
+    buildMapPyramid(&load->pyramid, &load->map);
+    return 0;
+}
+
+int startLoadJob(FILE * fp) {
+    loadArgs.fp = fp;
+    return startMapJob(loadJob, "Loading map", runLoadJob, &loadArgs);
+}
+
+/**
+ * Writes a snapshot of a map's tiles (a job), leaving out the library sprites 
+ * none of them use
+ */
+int runSaveJob(job_t * job, void * arg) {
+    saveArgs_t * save = arg;
+
+    fillMapSpriteRemap(&save->map, save->remap, save->nSprites);
+    return writeMapTiles(&save->map, save->remap, save->nSprites, save->fp, setJobProgress, job);
+}
+
+int startSaveJob(const map_t * map, list_t sprites, const char * path) {
+    snprintf(saveArgs.path, sizeof(saveArgs.path), "%s", path);
+    snprintf(saveArgs.tmpPath, sizeof(saveArgs.tmpPath), "%s.part", path);
+    if((saveArgs.fp = fopen(saveArgs.tmpPath, "w")) == NULL) {
+        return -2;
     }
 
-    // Mark this cell as visited and update its palette
-    visited[y][x] = true;
-    map->data[y][x].bgPalette = palette;
+    if(mkMapSpriteRemap(sprites, &saveArgs.remap, &saveArgs.nSprites) < 0) {
+        fclose(saveArgs.fp);
+        remove(saveArgs.tmpPath);
+        return -1;
+    }
+    if(copyMap(map, &saveArgs.map) < 0) {
+        fclose(saveArgs.fp);
+        remove(saveArgs.tmpPath);
+        if(saveArgs.remap != NULL) free(saveArgs.remap);
+        return -1;
+    }
 
-    // Call recursively to all adjacent cells not blocked by walls
-    // Cell above
-    if(y > 0 && !(map->data[y][x].uWall || map->data[y-1][x].dWall)) {
-        floodRoomRec(map, visited, palette, x, y-1);
+    if(startMapJob(saveJob, "Saving map", runSaveJob, &saveArgs) < 0) {
+        fclose(saveArgs.fp);
+        remove(saveArgs.tmpPath);
+        rmMap(saveArgs.map);
+        if(saveArgs.remap != NULL) free(saveArgs.remap);
+        return -1;
     }
-    // Cell below
-    if(y+1 < map->nRows && !(map->data[y][x].dWall || map->data[y+1][x].uWall)) {
-        floodRoomRec(map, visited, palette, x, y+1);
+
+    return 0;
+}
+
+/**
+ * Reads every sprite in a sprite list file (a job)
+ */
+int runSpriteJob(job_t * job, void * arg) {
+    spriteArgs_t * load = arg;
+
+    sprite_t sprite;
+    while((sprite = readSprite(load->fp)).data != NULL) {
+        if(load->nSprites == load->capacity) {
+            int capacity = max(2 * load->capacity, 16);
+            sprite_t * sprites = realloc(load->sprites, capacity * sizeof(sprite_t));
+            if(sprites == NULL) {
+                rmSprite(sprite);
+                return -3;
+            }
+            load->sprites = sprites;
+            load->capacity = capacity;
+        }
+        load->sprites[load->nSprites++] = sprite;
+
+        if(!setJobProgress(job, ftell(load->fp), load->size)) {
+            return -5;
+        }
+    }
+
+    return 0;
+}
+
+int startSpriteJob(FILE * fp) {
+    spriteArgs.fp = fp;
+    spriteArgs.sprites = NULL;
+    spriteArgs.nSprites = 0;
+    spriteArgs.capacity = 0;
+
+    // Note the file's size, to measure progress through it
+    spriteArgs.size = 0;
+    if(fseek(fp, 0, SEEK_END) == 0) {
+        spriteArgs.size = ftell(fp);
     }
-    // Cell left
-    if(x > 0 && !(map->data[y][x].lWall || map->data[y][x-1].rWall)) {
-        floodRoomRec(map, visited, palette, x-1, y);
+    rewind(fp);
+
+    return startMapJob(spriteJob, "Loading sprites", runSpriteJob, &spriteArgs);
+}
+
+//===========================<Color Flood Helpers>============================//
+/**
+ * Queues a tile to fill from its neighbour, unless a wall (on either side) 
+ * stands between them or it is empty or already filled
+ */
+static void pushFloodCell(unsigned char * cells, int * stack, int * nStack, int from, int to,
+                            unsigned char fromWall, unsigned char toWall) {
+    if((cells[from] & fromWall) || (cells[to] & toWall) || !(cells[to] & kFloodOpen) || 
+            (cells[to] & kFloodFilled)) {
+        return;
     }
-    // Cell right
-    if(x+1 < map->nCols && !(map->data[y][x].rWall || map->data[y][x+1].lWall)) {
-        floodRoomRec(map, visited, palette, x+1, y);
+
+    cells[to] |= kFloodFilled;
+    stack[(*nStack)++] = to;
+}
+
+/**
+ * Floods the room around a tile of a map's snapshot (a job)
+ */
+int runFloodJob(job_t * job, void * arg) {
+    floodArgs_t * fill = arg;
+    unsigned char * cells = fill->cells;
+    int nRows = fill->nRows, nCols = fill->nCols;
+
+    // Every tile is queued at most once
+    int * stack = malloc((size_t) nRows * nCols * sizeof(int));
+    if(stack == NULL) {
+        return -3;
     }
 
+    int nStack = 0;
+    long nFilled = 0;
+    cells[fill->y * nCols + fill->x] |= kFloodFilled;
+    stack[nStack++] = fill->y * nCols + fill->x;
+
+    while(nStack > 0) {
+        int cell = stack[--nStack];
+        int x = cell % nCols, y = cell / nCols;
+
+        fill->bounds[0] = min(fill->bounds[0], x);
+        fill->bounds[1] = min(fill->bounds[1], y);
+        fill->bounds[2] = max(fill->bounds[2], x);
+        fill->bounds[3] = max(fill->bounds[3], y);
+
+        if(++nFilled % kFloodReport == 0 && !setJobProgress(job, nFilled, 0)) {
+            free(stack);
+            return -5;
+        }
+
+        // Move on to all adjacent tiles not blocked by walls
+        if(y > 0) {
+            pushFloodCell(cells, stack, &nStack, cell, cell - nCols, kFloodUp, kFloodDown);
+        }
+        if(y + 1 < nRows) {
+            pushFloodCell(cells, stack, &nStack, cell, cell + nCols, kFloodDown, kFloodUp);
+        }
+        if(x > 0) {
+            pushFloodCell(cells, stack, &nStack, cell, cell - 1, kFloodLeft, kFloodRight);
+        }
+        if(x + 1 < nCols) {
+            pushFloodCell(cells, stack, &nStack, cell, cell + 1, kFloodRight, kFloodLeft);
+        }
+    }
 
+    free(stack);
+    return 0;
 }
 
-void floodRoom(map_t * map, int x, int y) {
+int startFloodJob(const map_t * map, int x, int y) {
     // First of all, ensure that the map exists and that the first square is enabled
     if(map == NULL || y < 0 || y >= map->nRows || x < 0 || x >= map->nCols || 
             map->data[y][x].isEmpty) {
-        return;
+        return -1;
     }
 
-    // First allocated a visited array
-    bool ** visited = calloc(map->nRows, sizeof(bool *));
-    if(visited == NULL) {
-        return;
+    // Snapshot the map's walls for the job
+    floodArgs.cells = malloc((size_t) map->nRows * map->nCols);
+    if(floodArgs.cells == NULL) {
+        return -1;
     }
 
-    for(int i = 0; i < map->nRows; i++) {
-        visited[i] = calloc(map->nCols, sizeof(bool));
-        if(visited[i] == NULL) goto floodRoomCleanup;
+    for(int row = 0; row < map->nRows; row++) {
+        unsigned char * cells = floodArgs.cells + (size_t) row * map->nCols;
+        for(int col = 0; col < map->nCols; col++) {
+            tile_t tile = map->data[row][col];
+            cells[col] = (tile.isEmpty ? 0 : kFloodOpen) | (tile.uWall ? kFloodUp : 0) | 
+                         (tile.dWall ? kFloodDown : 0) | (tile.lWall ? kFloodLeft : 0) | 
+                         (tile.rWall ? kFloodRight : 0);
+        }
     }
 
-    // Next grab the palette and begin the flood process
-    short palette = map->data[y][x].bgPalette;
-    floodRoomRec(map, visited, palette, x, y);
+    // Fill with the palette of the selected tile
+    floodArgs.nRows = map->nRows;
+    floodArgs.nCols = map->nCols;
+    floodArgs.x = x;
+    floodArgs.y = y;
+    floodArgs.palette = map->data[y][x].bgPalette;
+    floodArgs.bounds[0] = floodArgs.bounds[2] = x;
+    floodArgs.bounds[1] = floodArgs.bounds[3] = y;
+
+    if(startMapJob(floodJob, "Filling room", runFloodJob, &floodArgs) < 0) {
+        free(floodArgs.cells);
+        return -1;
+    }
 
+    return 0;
+}
 
-floodRoomCleanup:
-    if(visited != NULL) {
-        for(int i = 0; i < map->nRows; i++) {
-            if(visited[i] != NULL) free(visited[i]);
-        }
-        free(visited);
+bool isFloodEdit(int ch) {
+    switch(ch) {
+        case KEY_ENTER: case '\n': case 'e':               // Tile set/unset
+        case KEY_DC: case 27: case 'q': case 'Q':
+        case 'w': case 'W': case 'a': case 'A':             // Walls
+        case 's': case 'S': case 'd': case 'D':
+        case 'c': case 'C': case 'p': case 'P':             // Palettes
+            return true;
+        default:
+            return false;
     }
 }
 
+//==============================<Sprite Helpers>==============================//
+void spritesChanged(tileData_t * data, spritePicker_t * picker) {
+    // Re-index the list, and drop thumbnails and tiles drawn from sprites that 
+    // may have moved
+    refreshSpriteIndex(data);
+    clearPickerCache(picker);
+    invalidateMapView(data);
+}
+
 //===============================<File Helper>================================//
 FILE* promptFile(bool openRead) {
     char buf[128];
-
-    clear();
-    printText(kBlackPalette, "Enter the file path", 0, 0);
-    getText(2, 0, buf, 128);
+    promptPath(buf, sizeof(buf));
 
     FILE* fp = fopen(buf, (openRead) ? "r" : "w");
     return fp;
 }
 
+void promptPath(char * buf, int nBuf) {
+    clear();
+    printText(kBlackPalette, "Enter the file path", 0, 0);
+    getText(2, 0, buf, nBuf);
+}
+
 //===============================<Misc Helpers>===============================//
 #define helpPrinter(msg, row) printText(kBlackPalette, msg, row, 0)
 
@@ -686,11 +1509,15 @@ void printHelp(mode_t mode) {
             helpPrinter("Edit map will allow you to edit the loaded map", 8);
             helpPrinter("Make Printable will generate a map to be printed as plaintext", 9);
             helpPrinter("Load Sprite list will load a file into the active sprite list", 10);
-            helpPrinter("Quit... quits (real original, I know)", 10);
+            helpPrinter("Link Sprite Library will reference a library's sprites without copying them", 11);
+            helpPrinter("Quit... quits (real original, I know), once any running job is done", 12);
+
+            helpPrinter("Loading, saving and loading sprites carry on in the background, with their", 14);
+            helpPrinter("progress shown below the menu. 'x' cancels them", 15);
 
-            helpPrinter("Worth noting, attempting to backspace in text entry currently results in", 12);
-            helpPrinter("corruption. Instead, the delete key currently fills its role", 13);
-            newRow = 15;
+            helpPrinter("Worth noting, attempting to backspace in text entry currently results in", 17);
+            helpPrinter("corruption. Instead, the delete key currently fills its role", 18);
+            newRow = 20;
             break;
         case nav:
             helpPrinter("Use the Arrow keys to select a tile to modify", 2);
@@ -701,15 +1528,25 @@ void printHelp(mode_t mode) {
             helpPrinter("'c' cycles the color palette of the tile ", 7);
             helpPrinter("'v' cycles the color palette of the tile's sprite", 8);
             helpPrinter("'r' cycles to the next loaded sprite", 9);
-            helpPrinter("'g' places a char sprite of your chosing", 10);
-            helpPrinter("'z' removes any sprite from the selected cell", 11);
-            helpPrinter("'p' fills the selected room with the current color", 13);
-            newRow = 15;
+            helpPrinter("'n' places the loaded sprite with the given name", 10);
+            helpPrinter("'t' cycles to the next loaded sprite with the given tag", 11);
+            helpPrinter("'b' browses all loaded sprites to pick one", 12);
+            helpPrinter("'g' places a char sprite of your chosing", 13);
+            helpPrinter("'z' removes any sprite from the selected cell", 14);
+            helpPrinter("'p' fills the selected room with the current color (walls, tiles and colors", 15);
+            helpPrinter("    can't be edited until it is filled)", 16);
+            helpPrinter("'+' and '-' zoom the view in and out (out past the smallest tiles", 17);
+            helpPrinter("    to an overview of the map, one char per tile and smaller)", 18);
+            helpPrinter("'|' splits the screen into two views of the map (or joins it), and", 19);
+            helpPrinter("    Tab switches between them (each keeps its own place and zoom)", 20);
+            helpPrinter("'f' shows the time and work taken to render each frame", 21);
+            helpPrinter("'x' cancels the job running in the background (shown along the bottom)", 22);
+            newRow = 24;
             break;
         default:
             newRow = 2;
     }
     printText(kBlackPalette, "Press enter to continue...", newRow, 0);
-    getch();
+    getKey();
 
 }
\ No newline at end of file
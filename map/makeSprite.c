@@ -1,11 +1,14 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include <curses.h>
 #include "mapDisp.h"
 
 #include "sprite.h"
+#include "spriteLib.h"
+#include "spritePicker.h"
 
 #include "wallSprites.h"
 
@@ -13,20 +16,22 @@
 #include "../common/dispBase.h"
 
 //==============================<Menu Handling>===============================//
-typedef enum mode_e {menu, sel, new, edit, save, load, quit} mode_t;
+typedef enum mode_e {menu, sel, new, edit, save, saveLib, load, quit} mode_t;
 
 const char * menuItems[] = {
     "1. Select a sprite to edit",
     "2. Create a new sprite",
     "3. Save the sprite list to file",
-    "4. Load a sprite file into the current list",
-    "5. Exit Program"
+    "4. Save the sprite list as a sprite library",
+    "5. Load a sprite file into the current list",
+    "6. Exit Program"
 };
 
 const mode_t menuModes[] = {
     sel,
     new,
     save,
+    saveLib,
     load,
     quit
 };
@@ -37,6 +42,10 @@ const unsigned char menuSize = sizeof(menuModes) / sizeof(menuModes[0]);
 #define kDefSpriteWidth     kTileWidth-1
 #define kDefSpriteHeight    kTileHeight-1
 
+#define kBackendFlag "-B"
+#define kFrameRateFlag "-F"
+#define kRecordFlag "-R"
+
 //===========================<Helper Declarations>============================//
 
 #ifndef min
@@ -62,6 +71,7 @@ int main(int argc, char** argv) {
 
     dispData_t dispData;        // Display Data store
     bool dispOpen = false;      // Set to true only between disp open and close
+    const dispBackend_t * backend = &kCursesBackend;    // Display output backend
 
     list_t list = NULL;         // A list to store all sprites
     bool listLoaded = false;    // Set true iff the list is loaded & not cleaned
@@ -72,14 +82,53 @@ int main(int argc, char** argv) {
     bool bgLoaded = false;      // Set true iff bg is loaded & not cleaned
     bool useBg = false;          // A flag set to render the bg tile in sel and edit modes
 
+    spriteIndex_t index;        // An index over the list for the sprite picker
+    spritePicker_t picker;      // The sprite picker (and its thumbnail cache)
+    bool indexStale = true;     // Set whenever the list changes under the index
+    initSpriteIndex(&index);
+    initSpritePicker(&picker);
+
     sprite_t * entry = NULL;    // A variable to hold a single sprite from heap
     bool entryUnlisted = false; // Set to true iff the entry is not in the list
 
     FILE* fp = NULL;
     bool fileOpen = false;
 
+    FILE* recordFp = NULL;      // Recording of every printed frame
+
     //=========================<Argument Parsing>=========================//
     for(int i = 1; i < argc; ++i) {
+        // Pick the display backend
+        if(strcmp(kBackendFlag, argv[i]) == 0) {
+            if(++i >= argc || (backend = getDispBackend(argv[i])) == NULL) {
+                fprintf(stderr, "*FATAL ERROR* Expected a display backend (curses, ansi or null)\n");
+                goto main_cleanup;
+            }
+            continue;
+        }
+
+        // Cap the frame rate
+        if(strcmp(kFrameRateFlag, argv[i]) == 0) {
+            char * end;
+            long fps = (++i < argc) ? strtol(argv[i], &end, 10) : -1;
+            if(fps < 0 || *end != '\0') {
+                fprintf(stderr, "*FATAL ERROR* Expected a frame rate (0 for uncapped)\n");
+                goto main_cleanup;
+            }
+            setFrameRate(fps);
+            continue;
+        }
+
+        // Record every printed frame (see dispReplay)
+        if(strcmp(kRecordFlag, argv[i]) == 0) {
+            if(recordFp != NULL || ++i >= argc || (recordFp = fopen(argv[i], "wb")) == NULL) {
+                fprintf(stderr, "*FATAL ERROR* Unable to open a recording file\n");
+                goto main_cleanup;
+            }
+            setFrameRecord(recordFp);
+            continue;
+        }
+
         // Ensure that there is a sprite list
         if(!listLoaded) {
             list = mkList();
@@ -135,7 +184,7 @@ int main(int argc, char** argv) {
     }
 
     // Initialize the display
-    if((ret = initDisp(&dispData)) < 0) {
+    if((ret = initDispBackend(&dispData, backend)) < 0) {
         fprintf(stderr, "*Fatal Error* Failed to initialize the display (%d)\n", ret);
         goto main_cleanup;
     }
@@ -181,12 +230,14 @@ int main(int argc, char** argv) {
         switch(mode) {
             //=======================<Main Menu>======================//
             case menu:
-                // Display the menu
-                clearBuffer(&dispData);
-                addMenu(&dispData, "MakeSprite", menuItems, menuSize, y);
-                sprintf(buf, "%d sprites in the list", (list == NULL) ? 0 : listLen(list));
-                addText(&dispData, kBlackPalette, buf, menuSize + 3, 0);
-                printBuffer(dispData);
+                // Display the menu (once any waiting keys are applied)
+                if(shouldRender(&dispData)) {
+                    clearBuffer(&dispData);
+                    addMenu(&dispData, "MakeSprite", menuItems, menuSize, y);
+                    sprintf(buf, "%d sprites in the list", (list == NULL) ? 0 : listLen(list));
+                    addText(&dispData, kBlackPalette, buf, menuSize + 3, 0);
+                    printBuffer(&dispData);
+                }
 
                 // Get the next input
                 ch = getch();
@@ -232,27 +283,32 @@ int main(int argc, char** argv) {
                 }
 
                 // Get the currently selected entry
-                entry = listGet(list, x);
+                entry = getListSprite(list, x);
                 if(entry == NULL) {
                     printError("*ERROR* Unable to grab the selected list entry");
                     mode = menu;
                     break;
                 }
 
-                // Print the currently selected sprite
-                clearBuffer(&dispData);
-                addText(&dispData, kBlackPalette, "Use arrow keys to select a sprite", 0, 0);
+                // Print the currently selected sprite (once any waiting keys are applied)
+                if(shouldRender(&dispData)) {
+                    clearBuffer(&dispData);
+                    addText(&dispData, kBlackPalette, "Use arrow keys to select a sprite", 0, 0);
 
-                sprintf(buf, "%d/%d", x + 1, ret);
-                addText(&dispData, kBlackPalette, buf, dispData.screenRows-1, 0);
+                    sprintf(buf, "%d/%d", x + 1, ret);
+                    addText(&dispData, kBlackPalette, buf, dispData.screenRows-1, 0);
+                    if(entry->name != NULL) {
+                        addText(&dispData, kBlackPalette, entry->name, dispData.screenRows-2, 0);
+                    }
 
-                if(useBg) {
-                    addSpriteCenter(&dispData, &bg, bg);
-                }
-                addSpriteCenter(&dispData, entry, bg);
+                    if(useBg) {
+                        addSpriteCenter(&dispData, &bg, bg);
+                    }
+                    addSpriteCenter(&dispData, entry, bg);
 
-                printBuffer(dispData);
-                curs_set(0);
+                    printBuffer(&dispData);
+                    curs_set(0);
+                }
 
                 // Handle inputs
                 ch = getch();
@@ -268,6 +324,13 @@ int main(int argc, char** argv) {
                     // Sprite manipulation
                     case KEY_ENTER:     // Select the sprite for edit
                     case '\n':
+                        // Take a private copy so edits don't leak into shared sprites
+                        entry = unshareSpriteEntry(list, x);
+                        if(entry == NULL) {
+                            printError("*ERROR* Unable to copy the selected sprite for edit");
+                            mode = menu;
+                            break;
+                        }
                         mode = edit;
                         break;
                     
@@ -280,6 +343,7 @@ int main(int argc, char** argv) {
                             freeSpriteEntry(entry);
                             entry = NULL;
                         }
+                        indexStale = true;
 
                         ch = listLen(list);
                         if(ch == 0) {
@@ -298,6 +362,22 @@ int main(int argc, char** argv) {
                     case '\t':
                         useBg = !useBg;
                         break;
+                    case 'b':           // Browse the whole list
+                    case 'B':
+                        if(indexStale) {
+                            if(buildSpriteIndex(&index, list) < 0) {
+                                printError("*ERROR* Unable to index the sprite list");
+                                break;
+                            }
+                            clearPickerCache(&picker);
+                            indexStale = false;
+                        }
+
+                        picker.sel = x;
+                        if((ch = pickSprite(&dispData, &picker, &index)) >= 0) {
+                            x = ch;
+                        }
+                        break;
                     case '?':
                     case KEY_F(1):
                         printHelp(mode);
@@ -307,20 +387,23 @@ int main(int argc, char** argv) {
 
             //=================<Create a New Sprite>==================//
             case new:
-                // Add a block with the same size as the sprite to the display
-                clearBuffer(&dispData);
-                addText(&dispData, kBlackPalette, "Use arrow keys to resize, enter to confirm", 0, 0);
-
-                for(int dRow = 0; dRow < y; ++dRow) {
-                    int row = (dispData.screenRows/2 - y/2) + dRow;
-                    for(int dCol = 0; dCol < x; ++dCol) {
-                        int col = (dispData.screenCols/2 - x/2) + dCol;
-                        addText(&dispData, kWhitePalette, " ", row, col);
+                // Add a block with the same size as the sprite to the display (once any
+                // waiting keys are applied)
+                if(shouldRender(&dispData)) {
+                    clearBuffer(&dispData);
+                    addText(&dispData, kBlackPalette, "Use arrow keys to resize, enter to confirm", 0, 0);
+
+                    for(int dRow = 0; dRow < y; ++dRow) {
+                        int row = (dispData.screenRows/2 - y/2) + dRow;
+                        for(int dCol = 0; dCol < x; ++dCol) {
+                            int col = (dispData.screenCols/2 - x/2) + dCol;
+                            addText(&dispData, kWhitePalette, " ", row, col);
+                        }
                     }
-                }
 
-                printBuffer(dispData);
-                curs_set(0);
+                    printBuffer(&dispData);
+                    curs_set(0);
+                }
 
                 // Handle input
                 ch = getch();
@@ -407,16 +490,19 @@ int main(int argc, char** argv) {
                 mode = menu;
                 break;
             }
+            indexStale = true;
 
-            // Draw the edit screen
-            clearBuffer(&dispData);
-            if(useBg) {
-                addSpriteCenter(&dispData, &bg, bg);
+            // Draw the edit screen (once any waiting keys are applied)
+            if(shouldRender(&dispData)) {
+                clearBuffer(&dispData);
+                if(useBg) {
+                    addSpriteCenter(&dispData, &bg, bg);
+                }
+                addSpriteCenter(&dispData, entry, bg);
+                move((dispData.screenRows/2-bg.height/2+entry->yOff) + y,
+                        (dispData.screenCols/2-bg.width/2+entry->xOff) + x);
+                printBuffer(&dispData);
             }
-            addSpriteCenter(&dispData, entry, bg);
-            printBuffer(dispData);
-            move((dispData.screenRows/2-bg.height/2+entry->yOff) + y,
-                    (dispData.screenCols/2-bg.width/2+entry->xOff) + x);
 
             // Get and act on input
             ch = getch();
@@ -467,6 +553,24 @@ int main(int argc, char** argv) {
                     ++entry->xOff;
                     break;
 
+                // Label Inputs
+                case KEY_F(3):
+                    clear();
+                    printText(kBlackPalette, "Enter the sprite name (blank to remove)", 0, 0);
+                    getText(2, 0, buf, sizeof(buf));
+                    if(setSpriteName(entry, buf) < 0) {
+                        printError("*ERROR* Failed to name the sprite");
+                    }
+                    break;
+                case KEY_F(4):
+                    clear();
+                    printText(kBlackPalette, "Enter the sprite tags, space separated (blank to remove)", 0, 0);
+                    getText(2, 0, buf, sizeof(buf));
+                    if(setSpriteTags(entry, buf) < 0) {
+                        printError("*ERROR* Failed to tag the sprite");
+                    }
+                    break;
+
                 // Misc Inputs
                 case KEY_F(1):
                     printHelp(mode);
@@ -518,6 +622,34 @@ int main(int argc, char** argv) {
                 mode = menu;
                 break;
             
+            //=====================<Save Library>=====================//
+            case saveLib:
+                // Make sure the list is open
+                if(!listLoaded) {
+                    mode = menu;
+                    break;
+                }
+
+                // Open the library file
+                fp = promptFile(false, "Enter a name for the library file");
+                if(fp == NULL) {
+                    printError("*ERROR* Unable to open file for save");
+                    mode = menu;
+                    break;
+                }
+                fileOpen = true;
+
+                // Write the sprites out with an offset index for lazy loading
+                if(writeSpriteLib(fp, list) < 0) {
+                    printError("*ERROR* Failed to save the sprite library");
+                }
+                fclose(fp);
+                fileOpen = false;
+
+                // Return to the main menu
+                mode = menu;
+                break;
+
             //======================<Load Sheet>======================//
             case load:
                 // If there is no current list, create one
@@ -544,6 +676,7 @@ int main(int argc, char** argv) {
                 if(loadSpriteList(fp, &list) < 0) {
                     printError("*ERROR* Failed to load sprites from file");
                 }
+                indexStale = true;
                 fclose(fp);
                 fileOpen = false;
 
@@ -573,9 +706,15 @@ main_cleanup:
     if(bgLoaded) {
         rmSprite(bg);
     }
+    rmSpriteIndex(index);
+    rmSpritePicker(picker);
     if(fileOpen) {
         fclose(fp);
     }
+    if(recordFp != NULL) {
+        setFrameRecord(NULL);
+        fclose(recordFp);
+    }
     return status;
 }
 
@@ -621,8 +760,9 @@ void printHelp(mode_t mode) {
             helpPrinter("Use the enter key to select a sprite to edit", 4);
             helpPrinter("Use delete or backspace to delete a sprite", 5);
             helpPrinter("Use tab to toggle a background tile", 6);
+            helpPrinter("Use 'b' to browse the whole list", 7);
 
-            newRow = 8;
+            newRow = 9;
             break;
         
         case edit:
@@ -637,9 +777,12 @@ void printHelp(mode_t mode) {
             helpPrinter("Use Home and End to change y offset", 10);
             helpPrinter("Use Delete and PgDn to change x offset", 11);
 
-            helpPrinter("Use the F2 key or enter to return to the menu", 13);
+            helpPrinter("Use the F3 key to name the sprite", 13);
+            helpPrinter("Use the F4 key to tag the sprite", 14);
+
+            helpPrinter("Use the F2 key or enter to return to the menu", 16);
 
-            newRow = 15;
+            newRow = 18;
             break;
         
         default:
@@ -653,7 +796,7 @@ void printHelp(mode_t mode) {
 
 
 void addSpriteCenter(dispData_t * data, sprite_t * sprite, sprite_t bg) {
-    addSprite(data, *sprite, 0, 
+    addSprite(data, sprite, 0, 
                 data->screenRows/2 - bg.height/2,
                 data->screenCols/2 - bg.width/2);
 }
\ No newline at end of file
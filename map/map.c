@@ -1,8 +1,14 @@
 #include "map.h"
 
+#include <ctype.h>
+#include <string.h>
+
+#include "spriteLib.h"
 
 //===========================<Helper Declarations>============================//
 void freeTiles(tile_t** tiles, int nRows);
+int writeMapSprites(list_t sprites, const int * remap, int nSprites, FILE* fp);
+int loadMapSprites(list_t sprites, FILE* fp);
 
 #ifndef min
 #define min(a, b) ((a < b) ? a : b)
@@ -47,6 +53,20 @@ void rmMap(map_t map) {
     freeTiles(map.data, map.nRows);
 }
 
+int copyMap(const map_t * map, map_t * copy) {
+    if(map == NULL || copy == NULL) return -1;
+
+    if(mkMap(map->nRows, map->nCols, copy) < 0) {
+        return -1;
+    }
+
+    for(int row = 0; row < map->nRows; row++) {
+        memcpy(copy->data[row], map->data[row], map->nCols * sizeof(tile_t));
+    }
+
+    return 0;
+}
+
 void freeTiles(tile_t** tiles, int nRows) {
     if(tiles == NULL) return;
 
@@ -60,36 +80,123 @@ void freeTiles(tile_t** tiles, int nRows) {
 //==============================<Serialization>===============================//
 
 int writeMap(map_t map, list_t sprites, FILE* fp) {
-    if(fp == NULL) return -1;
+    int * remap, nSprites;
+    if(mkMapSpriteRemap(sprites, &remap, &nSprites) < 0) return -3;
+    fillMapSpriteRemap(&map, remap, nSprites);
 
-    fprintf(fp, "%d %d\n", map.nRows, map.nCols);
+    int ret = writeMapTiles(&map, remap, nSprites, fp, NULL, NULL);
+    if(ret == 0) {
+        ret = writeMapSpriteList(sprites, remap, nSprites, fp);
+    }
 
-    int len = 0;
-    if(sprites != NULL) {
-        len = listLen(sprites);
+    if(remap != NULL) free(remap);
+    return ret;
+}
+
+int mkMapSpriteRemap(list_t sprites, int ** remap, int * nSprites) {
+    if(remap == NULL || nSprites == NULL) return -1;
+
+    *remap = NULL;
+    *nSprites = (sprites != NULL) ? listLen(sprites) : 0;
+    if(*nSprites == 0) return 0;
+
+    sprite_t ** entries = calloc(*nSprites, sizeof(sprite_t *));
+    *remap = calloc(*nSprites, sizeof(int));
+    if(entries == NULL || *remap == NULL) {
+        if(entries != NULL) free(entries);
+        if(*remap != NULL) free(*remap);
+        *remap = NULL;
+        return -3;
+    }
+
+    // Library sprites are left out until a tile is found using them
+    listCopyOut(sprites, (void **) entries);
+    for(int i = 0; i < *nSprites; i++) {
+        bool isLib = (getSpriteEntrySource(entries[i], NULL, NULL) == &kLibSpriteSource);
+        (*remap)[i] = isLib ? kDropSprite : 0;
+    }
+
+    free(entries);
+    return 0;
+}
+
+void fillMapSpriteRemap(const map_t * map, int * remap, int nSprites) {
+    if(map == NULL || remap == NULL) return;
+
+    for(int row = 0; row < map->nRows; row++) {
+        for(int col = 0; col < map->nCols; col++) {
+            int sprite = map->data[row][col].sprite;
+            if(sprite >= 0 && sprite < nSprites) {
+                remap[sprite] = 0;
+            }
+        }
     }
 
-    for(int row = 0; row < map.nRows; row++) {
-        for(int col = 0; col < map.nCols; col++) {
-            tile_t tile = map.data[row][col];
-            if(tile.sprite >= len) {    // Cull any illegal sprites
+    // Number the sprites kept in the order they are written
+    int next = 0;
+    for(int i = 0; i < nSprites; i++) {
+        if(remap[i] != kDropSprite) {
+            remap[i] = next++;
+        }
+    }
+}
+
+int writeMapTiles(const map_t * map, const int * remap, int nSprites, FILE* fp, 
+                    progressFxn_t progress, void * arg) {
+    if(map == NULL || fp == NULL) return -1;
+
+    fprintf(fp, "%d %d\n", map->nRows, map->nCols);
+
+    for(int row = 0; row < map->nRows; row++) {
+        for(int col = 0; col < map->nCols; col++) {
+            tile_t tile = map->data[row][col];
+            if(tile.sprite >= nSprites) {   // Cull any illegal sprites
                 tile.sprite = kNoSprite;
+            } else if(tile.sprite >= 0 && remap != NULL) {
+                tile.sprite = remap[tile.sprite];
             }
 
             if(writeTile(tile, fp) < 0) return -2;
         }
+
+        if(progress != NULL && !progress(arg, row + 1, map->nRows)) {
+            return -5;
+        }
     }
 
+    return 0;
+}
+
+int writeMapSpriteList(list_t sprites, const int * remap, int nSprites, FILE* fp) {
+    if(fp == NULL) return -1;
+
     if(sprites != NULL) {
-        if(saveSpriteList(fp, sprites) < 0) return -2;
+        if(writeMapSprites(sprites, remap, nSprites, fp) < 0) return -2;
     }
-    
+
     return 0;
 }
 
 int loadMap(map_t* map, list_t * sprites, FILE* fp) {
     if(fp == NULL || map == NULL || sprites == NULL) return -1;
 
+    int ret = loadMapTiles(map, fp, NULL, NULL);
+    if(ret < 0) {
+        *sprites = NULL;
+        return ret;
+    }
+
+    if((ret = loadMapSpriteList(sprites, fp)) < 0) {
+        rmMap(*map);
+        return ret;
+    }
+
+    return 0;
+}
+
+int loadMapTiles(map_t * map, FILE* fp, progressFxn_t progress, void * arg) {
+    if(fp == NULL || map == NULL) return -1;
+
     int rows, cols;
     int ret = fscanf(fp, "%d %d", &rows, &cols);
 
@@ -99,29 +206,184 @@ int loadMap(map_t* map, list_t * sprites, FILE* fp) {
         return -3;
     }
 
-    if((*sprites = mkList()) == NULL) {
-        rmMap(*map);
-        return -3;
-    }
-
     for(int row = 0; row < rows; row++) {
         for(int col = 0; col < cols; col++) {
             ret = readTile(&map->data[row][col], fp);
             if(ret < 0) {
                 rmMap(*map);
-                rmList(*sprites, freeSpriteEntry);
-                *sprites = NULL;
                 return -2;
             }
         }
+
+        if(progress != NULL && !progress(arg, row + 1, rows)) {
+            rmMap(*map);
+            return -5;
+        }
     }
 
-    if(loadSpriteList(fp, sprites) < 0) {
-        rmMap(*map);
+    return 0;
+}
+
+int loadMapSpriteList(list_t * sprites, FILE* fp) {
+    if(fp == NULL || sprites == NULL) return -1;
+
+    int ret;
+    if((*sprites = mkList()) == NULL) {
+        return -3;
+    }
+
+    if((ret = loadMapSprites(*sprites, fp)) < 0) {
         rmList(*sprites, freeSpriteEntry);
         *sprites = NULL;
-        return -2;
+        return ret;
+    }
+
+    return 0;
+}
+
+//============================<Sprite Sections>===============================//
+/**
+ * Writes a map's sprite list, referencing library sprites instead of copying
+ * 
+ * @param sprites The sprite list to write out
+ * @param remap Where each of the first nSprites goes in the file (see 
+ *              mkMapSpriteRemap, NULL to keep them all)
+ * @param nSprites The length of remap (library sprites added to the list since 
+ *                 are left out, as no tile written can use them)
+ * @param fp The file to write to
+ * 
+ * @return 0 on success, < 0 on failure
+ */
+int writeMapSprites(list_t sprites, const int * remap, int nSprites, FILE* fp) {
+    spriteLib_t curLib = NULL;
+    unsigned len = listLen(sprites);
+
+    sprite_t ** entries = calloc(len + 1, sizeof(sprite_t *));
+    if(entries == NULL) {
+        return -1;
+    }
+    listCopyOut(sprites, (void **) entries);
+
+    for(unsigned i = 0; i < len; i++) {
+        sprite_t * entry = entries[i];
+
+        void * src;
+        unsigned idx;
+        bool isLib = (getSpriteEntrySource(entry, &src, &idx) == &kLibSpriteSource);
+        if((remap != NULL && (int) i < nSprites && remap[i] == kDropSprite) || 
+                (isLib && (int) i >= nSprites)) {
+            continue;
+        }
+
+        if(isLib) {
+            // Name the library once for each run of sprites referencing it
+            if(src != curLib) {
+                curLib = src;
+                fprintf(fp, "@lib %016lx %s\n", getSpriteLibHash(curLib), 
+                            getSpriteLibPath(curLib));
+            }
+            fprintf(fp, "@ %u\n", idx);
+            continue;
+        }
+
+        // Everything else is written inline
+        entry = resolveSpriteEntry(entry);
+        if(entry == NULL || writeSprite(fp, *entry) < 0) {
+            continue;
+        }
     }
 
+    free(entries);
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * Reads a map's sprite list (inline sprites and library references)
+ * 
+ * @param sprites The sprite list to append to
+ * @param fp The file to read from
+ * 
+ * @return 0 on success, -2 on a malformed list, -3 on allocation failure, -4 
+ *         if a referenced library is missing or has changed
+ */
+int loadMapSprites(list_t sprites, FILE* fp) {
+    spriteLib_t lib = NULL;
+    char buf[256];
+    int ret = 0, ch;
+
+    while(true) {
+        // Skip to the start of the next record
+        while((ch = fgetc(fp)) != EOF && isspace(ch));
+        if(ch == EOF) {
+            break;
+        }
+
+        // Inline sprite (the list ends at the first unreadable sprite)
+        if(ch != '@') {
+            ungetc(ch, fp);
+
+            sprite_t sprite = readSprite(fp);
+            if(sprite.data == NULL) {
+                break;
+            }
+
+            sprite_t * entry = internSprite(sprite);
+            if(entry == NULL) {
+                ret = -3;
+                break;
+            }
+            if(listAppend(sprites, entry) < 0) {
+                freeSpriteEntry(entry);
+                ret = -3;
+                break;
+            }
+            continue;
+        }
+
+        // Library directive ("@lib <hash> <path>")
+        if(fscanf(fp, "%15s", buf) != 1) {
+            ret = -2;
+            break;
+        }
+
+        if(strcmp(buf, "lib") == 0) {
+            unsigned long hash;
+            if(fscanf(fp, "%lx ", &hash) != 1 || fgets(buf, sizeof(buf), fp) == NULL) {
+                ret = -2;
+                break;
+            }
+            buf[strcspn(buf, "\r\n")] = '\0';
+
+            closeSpriteLib(lib);
+            lib = openSpriteLib(buf);
+            if(lib == NULL || getSpriteLibHash(lib) != hash) {
+                ret = -4;
+                break;
+            }
+            continue;
+        }
+
+        // Library sprite reference ("@ <index>"), loaded on first use
+        char * end;
+        unsigned long idx = strtoul(buf, &end, 10);
+        if(lib == NULL || *end != '\0' || idx >= spriteLibLen(lib)) {
+            ret = -2;
+            break;
+        }
+
+        sprite_t * entry = mkLazySpriteEntry(&kLibSpriteSource, retainSpriteLib(lib), idx);
+        if(entry == NULL) {
+            closeSpriteLib(lib);
+            ret = -3;
+            break;
+        }
+        if(listAppend(sprites, entry) < 0) {
+            freeSpriteEntry(entry);
+            ret = -3;
+            break;
+        }
+    }
+
+    closeSpriteLib(lib);
+    return ret;
+}
@@ -4,6 +4,10 @@
 #include <stdlib.h>
 
 #include "tile.h"
+#include "../common/job.h"
+
+// Marks a sprite left out of a map file (in a sprite remap table)
+#define kDropSprite -1
 
 //=============================<Type Definitions>=============================//
 typedef struct map_s {
@@ -43,10 +47,22 @@ int initMap(tile_t ** data, int nRows, int nCols, map_t * map);
  */
 void rmMap(map_t map);
 
+/**
+ * Allocates a copy of a map's tiles (e.g. a snapshot for a job to work on)
+ * 
+ * @param map The map to copy
+ * @param copy A return pointer for the copy
+ * 
+ * @return 0 on success, < 0 on failure
+ */
+int copyMap(const map_t * map, map_t * copy);
+
 //==============================<Serialization>===============================//
 
 /**
- * Write a map out to file
+ * Write a map out to file (sprites linked from a sprite library are written as
+ * references to the library rather than copied into the map, and only if a 
+ * tile uses them)
  * 
  * @param map The map to write to file
  * @param sprites The sprite list used with this map
@@ -56,6 +72,66 @@ void rmMap(map_t map);
  */
 int writeMap(map_t map, list_t sprites, FILE* fp);
 
+/**
+ * Starts the table of where each sprite of a map's list goes in its file, with
+ * the sprites linked from a library left out (as kDropSprite) until 
+ * fillMapSpriteRemap finds a tile using them
+ * 
+ * @param sprites The sprite list used with the map (NULL for none)
+ * @param remap A return pointer for the table (NULL if the list is empty)
+ * @param nSprites A return pointer for the length of the table
+ * 
+ * @return 0 on success, < 0 on failure
+ *          -1 on null param,
+ *          -3 if unable to allocate the table
+ */
+int mkMapSpriteRemap(list_t sprites, int ** remap, int * nSprites);
+
+/**
+ * Finishes a table from mkMapSpriteRemap, keeping the library sprites used by
+ * the map's tiles and numbering the sprites kept in order (this touches 
+ * nothing but the map and the table, so may run off the render thread)
+ * 
+ * @param map The map to be written
+ * @param remap The table to finish
+ * @param nSprites The length of the table
+ */
+void fillMapSpriteRemap(const map_t * map, int * remap, int nSprites);
+
+/**
+ * Writes the first part of a map file, its dimensions and tiles (this touches 
+ * nothing but the map, so may run on a snapshot of it off the render thread)
+ * 
+ * @param map The map to write to file
+ * @param remap Where each sprite goes in the file (from fillMapSpriteRemap, 
+ *              NULL to keep the sprites where they are)
+ * @param nSprites The length of the sprite list written after (sprites on 
+ *                 tiles past the end of it are dropped)
+ * @param fp The file to write out to
+ * @param progress Told the rows written after each row (NULL for none), 
+ *                 stopping the write early if it returns false
+ * @param arg Passed through to progress
+ * 
+ * @return 0 on success, < 0 on failure
+ *          -1 on null param,
+ *          -2 on failure to write to file,
+ *          -5 if stopped early by progress
+ */
+int writeMapTiles(const map_t * map, const int * remap, int nSprites, FILE* fp, 
+                    progressFxn_t progress, void * arg);
+
+/**
+ * Writes the rest of a map file (after writeMapTiles), its sprite list
+ * 
+ * @param sprites The sprite list used with the map (NULL for none)
+ * @param remap The table the tiles were written with (NULL to keep every sprite)
+ * @param nSprites The length of the table
+ * @param fp The file to write out to
+ * 
+ * @return 0 on success, < 0 on failure
+ */
+int writeMapSpriteList(list_t sprites, const int * remap, int nSprites, FILE* fp);
+
 /**
  * Load a map from a file
  * 
@@ -66,8 +142,37 @@ int writeMap(map_t map, list_t sprites, FILE* fp);
  * @return 0 on success, < 0 on failure
  *          -1 on null param, 
  *          -2 on failure to read from file,
- *          -3 if unable to allocate the new map or sprite list
+ *          -3 if unable to allocate the new map or sprite list,
+ *          -4 if a referenced sprite library is missing or has changed
  */
 int loadMap(map_t* map, list_t * sprites, FILE* fp);
 
+/**
+ * Loads the first part of a map file, its dimensions and tiles (this touches 
+ * nothing but the new map, so may run off the render thread)
+ * 
+ * @param map A return pointer for the map read from file
+ * @param fp The file to read from
+ * @param progress Told the rows read after each row (NULL for none), stopping 
+ *                 the load early if it returns false
+ * @param arg Passed through to progress
+ * 
+ * @return 0 on success, < 0 on failure (with nothing left allocated)
+ *          -1 on null param,
+ *          -2 on failure to read from file,
+ *          -3 if unable to allocate the new map,
+ *          -5 if stopped early by progress
+ */
+int loadMapTiles(map_t * map, FILE* fp, progressFxn_t progress, void * arg);
+
+/**
+ * Loads the rest of a map file (after loadMapTiles), its sprite list
+ * 
+ * @param sprites A return pointer for the sprite list used in the map
+ * @param fp The file to read from
+ * 
+ * @return 0 on success, < 0 on failure (as loadMap)
+ */
+int loadMapSpriteList(list_t * sprites, FILE* fp);
+
 #endif
\ No newline at end of file
@@ -1,5 +1,10 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "mapDisp.h"
 
+#include <pthread.h>
+#include <unistd.h>
+
 #ifndef min
 #define min(a, b) ((a < b) ? a : b)
 #endif
@@ -31,13 +36,9 @@ int getScreenRowCol(tileData_t * data, int scrX, int scrY, int x, int y, int * c
         return -1;    // Nothing to draw above or left of screen
     }
 
-    // First calculate the screen position of the tile
-    unsigned char tileWidth = data->tileBase.width;
-    unsigned char tileHeight = data->tileBase.height;
-
     // Calculate the character position of the tile (and ensure it is onscreen)
-    *col = dX * tileWidth;
-    *row = dY * tileHeight;
+    *col = dX * data->tileWidth;
+    *row = dY * data->tileHeight;
     if(*col >= data->dispData.screenCols || *row >= data->dispData.screenRows) {
         return -1;
     }
@@ -45,38 +46,161 @@ int getScreenRowCol(tileData_t * data, int scrX, int scrY, int x, int y, int * c
     return 0;
 }
 
+//===============================<Tile Blitters>==============================//
+typedef void (*tileBlit_t)(dispData_t * disp, const sprite_t * sprite, short palette, 
+                            int row, int col);
+
+/*
+ * Repeat a statement S(i, a) for i = 0 .. n-1, so that the preprocessor can 
+ * unroll loops of a fixed length. Rows and columns have their own macros, as a
+ * macro can't be expanded again within itself (n is at most the largest tile)
+ */
+#define unrollRows1(S, a) S(0, a)
+#define unrollRows2(S, a) unrollRows1(S, a) S(1, a)
+#define unrollRows3(S, a) unrollRows2(S, a) S(2, a)
+#define unrollRows4(S, a) unrollRows3(S, a) S(3, a)
+#define unrollRows5(S, a) unrollRows4(S, a) S(4, a)
+#define unrollRows6(S, a) unrollRows5(S, a) S(5, a)
+#define unrollRows7(S, a) unrollRows6(S, a) S(6, a)
+#define unrollCols1(S, a) S(0, a)
+#define unrollCols2(S, a) unrollCols1(S, a) S(1, a)
+#define unrollCols3(S, a) unrollCols2(S, a) S(2, a)
+#define unrollCols4(S, a) unrollCols3(S, a) S(3, a)
+#define unrollCols5(S, a) unrollCols4(S, a) S(4, a)
+#define unrollCols6(S, a) unrollCols5(S, a) S(5, a)
+#define unrollCols7(S, a) unrollCols6(S, a) S(6, a)
+#define unrollCols8(S, a) unrollCols7(S, a) S(7, a)
+#define unrollCols9(S, a) unrollCols8(S, a) S(8, a)
+#define unrollCols10(S, a) unrollCols9(S, a) S(9, a)
+#define unrollCols11(S, a) unrollCols10(S, a) S(10, a)
+#define unrollCols12(S, a) unrollCols11(S, a) S(11, a)
+#define unrollCols13(S, a) unrollCols12(S, a) S(12, a)
+#define unrollCols14(S, a) unrollCols13(S, a) S(13, a)
+#define unrollCols15(S, a) unrollCols14(S, a) S(14, a)
+
+// One cell (dCol) of a row of a tile, with src and dst set up by blitTileRow
+#define blitTileCell(dCol, unused) \
+    if(src[dCol] != '\0') dst[dCol] = mkDrawPair(palette, src[dCol]);
+
+// One row (dRow) of a tile W cells wide
+#define blitTileRow(dRow, W) { \
+    drawPair_t * dst = dispRow(disp, row + dRow) + col; \
+    const char * src = sprite->data[dRow]; \
+    unrollCols##W(blitTileCell, 0) \
+}
+
+/*
+ * Defines a blitter for tile sized sprites of a fixed size, which lie entirely
+ * on screen (no clipping or offsets). With the bounds fixed at compile time, 
+ * the copy is written out cell by cell, with no loops left to run.
+ */
+#define tileBlitName(W, H) tileBlitNameImpl(W, H)
+#define tileBlitNameImpl(W, H) blitTile##W##x##H
+
+#define defineTileBlit(W, H) defineTileBlitImpl(W, H)
+#define defineTileBlitImpl(W, H) \
+static void blitTile##W##x##H(dispData_t * disp, const sprite_t * sprite, short palette, \
+                                int row, int col) { \
+    unrollRows##H(blitTileRow, W) \
+}
+
+defineTileBlit(kCompactTileWidth, kCompactTileHeight)
+defineTileBlit(kTileWidth, kTileHeight)
+defineTileBlit(kLargeTileWidth, kLargeTileHeight)
+
+/*
+ * Blits an unclipped tile sized sprite of any size
+ */
+static void blitTileGeneric(dispData_t * disp, const sprite_t * sprite, short palette,
+                                int row, int col) {
+    for(int dRow = 0; dRow < sprite->height; dRow++) {
+        drawPair_t * dst = dispRow(disp, row + dRow) + col;
+        const char * src = sprite->data[dRow];
+        for(int dCol = 0; dCol < sprite->width; dCol++) {
+            if(src[dCol] != '\0') dst[dCol] = mkDrawPair(palette, src[dCol]);
+        }
+    }
+}
+
+/**
+ * Picks the blitter for tiles of the given size
+ */
+static tileBlit_t getTileBlit(int width, int height) {
+    if(width == kCompactTileWidth && height == kCompactTileHeight) {
+        return tileBlitName(kCompactTileWidth, kCompactTileHeight);
+    } else if(width == kTileWidth && height == kTileHeight) {
+        return tileBlitName(kTileWidth, kTileHeight);
+    } else if(width == kLargeTileWidth && height == kLargeTileHeight) {
+        return tileBlitName(kLargeTileWidth, kLargeTileHeight);
+    }
+
+    return blitTileGeneric;
+}
+
+/**
+ * Buffers a tile sized sprite, falling back on addSprite wherever it would 
+ * need to be clipped or offset
+ */
+static void addTileLayer(const tileData_t * data, dispData_t * disp, const sprite_t * sprite, 
+                            short palette, int row, int col) {
+    if(disp->data == NULL || sprite->data == NULL) return;
+
+    if(sprite->width != data->tileWidth || sprite->height != data->tileHeight ||
+            sprite->xOff != 0 || sprite->yOff != 0 || row < 0 || col < 0 ||
+            row + sprite->height > disp->screenRows || col + sprite->width > disp->screenCols) {
+        addSprite(disp, sprite, palette, row, col);
+        return;
+    }
+
+    if(palette == 0) palette = sprite->defPalette;
+    getTileBlit(sprite->width, sprite->height)(disp, sprite, palette, row, col);
+}
+
 //==============================<Sprite Display>==============================//
-void addSprite(dispData_t * data, sprite_t sprite, short palette, int screenRow, int screenCol) {
-    if(data == NULL || data->data == NULL || sprite.data == NULL) return;
-    if(palette == 0) palette = sprite.defPalette; 
+/**
+ * Buffers a sprite, stamping the given glyph into the middle of it (unless the
+ * glyph is '\0'), so that the shared character sprite is never written to
+ */
+static void drawSprite(dispData_t * data, const sprite_t * sprite, short palette, char glyph,
+                        int screenRow, int screenCol) {
+    if(data == NULL || data->data == NULL || sprite->data == NULL) return;
+    if(palette == 0) palette = sprite->defPalette; 
 
     // Ensure the sprite is not entirely off screen
-    screenRow = screenRow + sprite.yOff;
-    screenCol = screenCol + sprite.xOff;
-    if (screenRow + sprite.height <= 0 || screenCol + sprite.width <= 0 ||
+    screenRow = screenRow + sprite->yOff;
+    screenCol = screenCol + sprite->xOff;
+    if (screenRow + sprite->height <= 0 || screenCol + sprite->width <= 0 ||
             screenRow >= data->screenRows || screenCol >= data->screenCols) {
         return;
     }
 
     // Buffer each character from the sprite
-    for(int dRow = 0; dRow < sprite.height; dRow++) {
+    for(int dRow = 0; dRow < sprite->height; dRow++) {
         int row = screenRow + dRow;
         if(row < 0 || row >= data->screenRows) continue;
 
-        for(int dCol = 0; dCol < sprite.width; dCol++) {
+        for(int dCol = 0; dCol < sprite->width; dCol++) {
             int col = screenCol + dCol;
             if(col < 0 || col >= data->screenCols) continue;
 
-            char ch = sprite.data[dRow][dCol];
-            if(ch == '\0') {
-                continue;
-            } else {
-                data->data[row][col] = (drawPair_t) {palette, sprite.data[dRow][dCol]};
+            char ch = sprite->data[dRow][dCol];
+            if(glyph != '\0' && dRow == sprite->height/2 && dCol == sprite->width/2) {
+                ch = glyph;
+            }
+
+            if(ch != '\0') {
+                dispRow(data, row)[col] = mkDrawPair(palette, ch);
             }
         }
     }
 }
 
+void addSprite(dispData_t * data, const sprite_t * sprite, short palette, int screenRow, int screenCol) {
+    if(sprite == NULL) return;
+
+    drawSprite(data, sprite, palette, '\0', screenRow, screenCol);
+}
+
 //===============================<Tile Display>===============================//
 
 void addTileBase(tileData_t * data, tile_t tile, int scrX, int scrY, int x, int y) {
@@ -90,25 +214,17 @@ void addTileBase(tileData_t * data, tile_t tile, int scrX, int scrY, int x, int
 
     // If the tile is empty, draw the empty tile and be done with it
     if(tile.isEmpty) {
-        addSprite(&data->dispData, data->emptyBase, 0, row, col);
+        addTileLayer(data, &data->dispData, &data->emptyBase, 0, row, col);
         return;
     }
 
     // Determine correct palette (override or tile), and buffer sprite
     short palette = (tile.bgOverride != 0) ? tile.bgOverride : tile.bgPalette;
-    addSprite(&data->dispData, data->tileBase, palette, row, col);
+    addTileLayer(data, &data->dispData, &data->tileBase, palette, row, col);
 }
 
 #define getWallSprite(dir)\
-    switch(tile.dir##Wall) {\
-        case 0:\
-            break;\
-        case 1: \
-            sprite = data->dir##Wall;\
-            break;\
-        default:\
-            sprite = data->dir##Door;\
-    }
+    ((tile.dir##Wall == 0) ? NULL : (tile.dir##Wall == 1) ? &data->dir##Wall : &data->dir##Door)
 
 void addTileWalls(tileData_t * data, tile_t tile, int scrX, int scrY, int x, int y) {
     if(data == NULL) return;
@@ -119,24 +235,66 @@ void addTileWalls(tileData_t * data, tile_t tile, int scrX, int scrY, int x, int
         return;
     }
 
-    sprite_t sprite = kEmptySprite;
-    getWallSprite(l);
-    addSprite(&data->dispData, sprite, 0, row, col);
-    getWallSprite(r);
-    addSprite(&data->dispData, sprite, 0, row, col);
-    getWallSprite(u);
-    addSprite(&data->dispData, sprite, 0, row, col);
-    getWallSprite(d);
-    addSprite(&data->dispData, sprite, 0, row, col);
+    addSprite(&data->dispData, getWallSprite(l), 0, row, col);
+    addSprite(&data->dispData, getWallSprite(r), 0, row, col);
+    addSprite(&data->dispData, getWallSprite(u), 0, row, col);
+    addSprite(&data->dispData, getWallSprite(d), 0, row, col);
 
 }
 
-void addTileSprite(tileData_t * data, tile_t tile, int scrX, int scrY, int x, int y) {
-    if(data == NULL) return;
-    
+/**
+ * Finds the sprite layer of a tile, along with the palette to draw it in and 
+ * the glyph to stamp into it (for character sprites, '\0' otherwise)
+ * 
+ * @return The sprite to draw (NULL if the tile has none)
+ */
+static const sprite_t * getTileSpriteLayer(const tileData_t * data, tile_t tile, short * palette, 
+                                            char * glyph) {
     // Ensure that a sprite is specified (and that the list contains it)
     if(tile.sprite == kNoSprite || (tile.sprite >= 0 && (data->spriteList == NULL || 
             (unsigned int) tile.sprite >= listLen(data->spriteList)))) {
+        return NULL;
+    }
+
+    const sprite_t * sprite;
+    *glyph = '\0';
+    if(tile.sprite < 0) {   // Decode the character sprite
+        if(data->charSprite.data == NULL) return NULL;
+
+        sprite = &data->charSprite;
+        *glyph = getCharSpriteChar(tile.sprite);
+        if(*glyph == '\0') {
+            *glyph = ' ';
+        }
+    } else {    // Get the proper list sprite
+        sprite = getTileSprite(data, tile.sprite);
+        if(sprite == NULL) return NULL;
+    }
+
+    // Determine correct palette (override or tile), falling back on the sprite's
+    // own (character sprites included, whose coded palette is not drawn)
+    *palette = (tile.spriteOverride != 0) ? tile.spriteOverride : tile.spritePalette;
+    if(*palette == 0) *palette = sprite->defPalette;
+
+    return sprite;
+}
+
+/**
+ * Returns true if a sprite lies entirely within the bounds of a tile
+ */
+static bool spriteInTile(const tileData_t * data, const sprite_t * sprite) {
+    return sprite->xOff >= 0 && sprite->yOff >= 0 && 
+            sprite->xOff + sprite->width <= data->tileWidth && 
+            sprite->yOff + sprite->height <= data->tileHeight;
+}
+
+void addTileSprite(tileData_t * data, tile_t tile, int scrX, int scrY, int x, int y) {
+    if(data == NULL) return;
+
+    short palette;
+    char glyph;
+    const sprite_t * sprite = getTileSpriteLayer(data, tile, &palette, &glyph);
+    if(sprite == NULL) {
         return;
     }
     
@@ -146,230 +304,1194 @@ void addTileSprite(tileData_t * data, tile_t tile, int scrX, int scrY, int x, in
         return;
     }
 
-    // Get the sprite to draw
-    sprite_t sprite;
-    if(tile.sprite < 0) {   // Decode the character sprite
-        if(data->charSprite.data == NULL) return;
+    drawSprite(&data->dispData, sprite, palette, glyph, row, col);
+}
+
+void getScreenTileDim(const tileData_t * data, int * width, int * height) {
+    if(data == NULL) return;
+
+    if(width != NULL) *width = data->dispData.screenCols / data->tileWidth;
+    if(height != NULL) *height = data->dispData.screenRows / data->tileHeight;
+}
+
+//===============================<Tile Compositor>============================//
+// Four walls and a sprite (the base is handled on its own)
+#define kTileLayers 5
+
+/**
+ * Draws every layer of a tile into the given buffer in a single pass. Each row is resolved from the
+ * top layer down, with a mask of the cells already drawn, so that base and wall
+ * cells hidden under the sprite are never written. Walls are assumed to lie 
+ * within the tile (as mkTileSprites builds them), and the tile must start on
+ * screen.
+ * 
+ * @return false if the tile's sprite spills out of the tile (in which case it
+ *         is left for the caller to draw over the neighbouring tiles)
+ */
+static bool compositeTile(const tileData_t * data, dispData_t * disp, tile_t tile, int row, int col) {
+    const sprite_t * layers[kTileLayers];
+    short palettes[kTileLayers];
+    int nLayers = 0;
+
+    // Sprite layer
+    char glyph = '\0';
+    bool inTile = true;
+    const sprite_t * sprite = getTileSpriteLayer(data, tile, &palettes[0], &glyph);
+    if(sprite != NULL) {
+        inTile = spriteInTile(data, sprite);
+        if(inTile) layers[nLayers++] = sprite;
+    }
 
-        sprite = data->charSprite;
-        
-        char ch = getCharSpriteChar(tile.sprite);
-        if(ch == '\0') {
-            ch = ' ';
+    // Wall layers (in reverse of the order the layered path draws them)
+    const sprite_t * walls[] = {
+        (tile.dWall == 0) ? NULL : (tile.dWall == 1) ? &data->dWall : &data->dDoor,
+        (tile.uWall == 0) ? NULL : (tile.uWall == 1) ? &data->uWall : &data->uDoor,
+        (tile.rWall == 0) ? NULL : (tile.rWall == 1) ? &data->rWall : &data->rDoor,
+        (tile.lWall == 0) ? NULL : (tile.lWall == 1) ? &data->lWall : &data->lDoor
+    };
+    for(int i = 0; i < 4; i++) {
+        if(walls[i] != NULL && walls[i]->data != NULL) {
+            layers[nLayers] = walls[i];
+            palettes[nLayers++] = walls[i]->defPalette;
         }
-        
-        short palette = getCharSpritePalette(tile.sprite);
-        if (palette<kMinPalette || palette>kMaxPalette) palette = kDefPalette;
+    }
 
-        sprite.data[1][1] = ch;
-        sprite.defPalette = palette;
+    // Base layer
+    const sprite_t * base = tile.isEmpty ? &data->emptyBase : &data->tileBase;
+    short basePalette = tile.isEmpty ? 0 : 
+                        (tile.bgOverride != 0) ? tile.bgOverride : tile.bgPalette;
 
-        sprite = data->charSprite;
-    } else {    // Get the proper list sprite
-        sprite = *(sprite_t *) listGet(data->spriteList, tile.sprite);
+    // A bare tile can go straight to the blitters
+    if(nLayers == 0) {
+        addTileLayer(data, disp, base, basePalette, row, col);
+        return inTile;
     }
+    if(basePalette == 0) basePalette = base->defPalette;
 
-    // Determine correct palette (override or tile), and buffer sprite
-    short palette = (tile.spriteOverride != 0) ? tile.spriteOverride : tile.spritePalette;
-    addSprite(&data->dispData, sprite, palette, row, col);
+    int nRows = min(data->tileHeight, disp->screenRows - row);
+    int nCols = min(data->tileWidth, disp->screenCols - col);
+    for(int dRow = 0; dRow < nRows; dRow++) {
+        drawPair_t * dst = dispRow(disp, row + dRow) + col;
+        uint64_t drawn = 0;
+
+        for(int i = 0; i < nLayers; i++) {
+            const sprite_t * layer = layers[i];
+            int srcRow = dRow - layer->yOff;
+            if(srcRow < 0 || srcRow >= layer->height) continue;
+
+            const char * src = layer->data[srcRow] - layer->xOff;
+            int hi = min(layer->xOff + layer->width, nCols);
+            for(int dCol = max(layer->xOff, 0); dCol < hi; dCol++) {
+                char ch = src[dCol];
+                if(layer == sprite && glyph != '\0' && srcRow == layer->height/2 &&
+                        dCol - layer->xOff == layer->width/2) {
+                    ch = glyph;
+                }
+
+                if(ch != '\0' && !(drawn & (1ULL << dCol))) {
+                    dst[dCol] = mkDrawPair(palettes[i], ch);
+                    drawn |= 1ULL << dCol;
+                }
+            }
+        }
+
+        // Fill in whatever the layers above left showing of the base
+        const char * src = base->data[dRow];
+        for(int dCol = 0; dCol < nCols; dCol++) {
+            if(src[dCol] != '\0' && !(drawn & (1ULL << dCol))) {
+                dst[dCol] = mkDrawPair(basePalette, src[dCol]);
+            }
+        }
+    }
+
+    return inTile;
 }
 
-void getScreenTileDim(tileData_t data, int * width, int * height) {
-    if(width != NULL) *width = data.dispData.screenCols / data.emptyBase.width;
-    if(height != NULL) *height = data.dispData.screenRows / data.emptyBase.height;
+/**
+ * Rounds a division down (rather than towards zero)
+ */
+static int floorDiv(int a, int b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
 }
 
-//===============================<Map Display>================================//
+/**
+ * Returns true if two tiles would be drawn the same
+ */
+static bool sameTile(tile_t a, tile_t b) {
+    return a.sprite == b.sprite && a.bgPalette == b.bgPalette && 
+            a.bgOverride == b.bgOverride && a.spritePalette == b.spritePalette && 
+            a.spriteOverride == b.spriteOverride && a.lWall == b.lWall && 
+            a.rWall == b.rWall && a.uWall == b.uWall && a.dWall == b.dWall && 
+            a.isEmpty == b.isEmpty;
+}
 
-int addMap(tileData_t * data, map_t map, int x, int y) {
-    // Determine the position of the screen
-    int width, height;  // Width and height of the screen in tiles
-    getScreenTileDim(*data, &width, &height);
+//================================<Tile Stamps>===============================//
+/**
+ * Hashes everything which affects how a tile is drawn
+ */
+static unsigned hashTile(tile_t tile, int width, int height) {
+    int fields[] = {tile.sprite, tile.bgPalette, tile.bgOverride, tile.spritePalette, 
+                    tile.spriteOverride, tile.isEmpty, width, height,
+                    tile.lWall | tile.rWall << 2 | tile.uWall << 4 | tile.dWall << 6};
 
-    // X & Y coords of the top-left tile (try to center, but stop at map edge)
-    int scrX = max(min(x - width/2, map.nCols-width), 0);
-    int scrY = max(min(y - height/2, map.nRows-height), 0);
-    
-    // Draw all tiles on the screen
-    for(int dRow = 0; dRow < height && dRow + scrY < map.nRows; dRow++) {
-        int row = dRow + scrY;
-        for(int dCol = 0; dCol < width && dCol + scrX < map.nCols; dCol++) {
-            int col = dCol + scrX;
-            addTileBase(data, map.data[row][col], scrX, scrY, col, row);
+    uint32_t hash = 2166136261u;
+    for(unsigned i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        hash = (hash ^ (uint32_t) fields[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Finds the stamp of a tile, or the empty slot it would go in
+ */
+static tileStamp_t * findStamp(tileStamps_t * stamps, tile_t tile, int width, int height) {
+    unsigned slot = hashTile(tile, width, height) & (kTileStampSlots - 1);
+    while(true) {
+        tileStamp_t * stamp = &stamps->slots[slot];
+        if(stamp->tileWidth == 0 || (stamp->tileWidth == width && 
+                stamp->tileHeight == height && sameTile(stamp->tile, tile))) {
+            return stamp;
+        }
+        slot = (slot + 1) & (kTileStampSlots - 1);
+    }
+}
+
+/**
+ * Empties a table of stamps (keeping the space allocated for them)
+ */
+static void clearStamps(tileStamps_t * stamps) {
+    if(stamps->slots != NULL) {
+        for(unsigned i = 0; i < kTileStampSlots; i++) {
+            stamps->slots[i].tileWidth = stamps->slots[i].tileHeight = 0;
+        }
+    }
+    stamps->nUsed = 0;
+}
+
+/**
+ * Makes room in a table of stamps for tiles of the given number of cells (which
+ * empties the table if its slots must grow)
+ * 
+ * @return 0 on success, <0 on failure
+ */
+static int reserveStamps(tileStamps_t * stamps, unsigned nCells) {
+    if(stamps->slots == NULL) {
+        stamps->slots = calloc(kTileStampSlots, sizeof(tileStamp_t));
+        stamps->nUsed = 0;
+        if(stamps->slots == NULL) return -1;
+    }
+
+    if(stamps->slotCells < nCells) {
+        drawPair_t * cells = realloc(stamps->cells, 
+                                        (size_t) kTileStampSlots * nCells * sizeof(drawPair_t));
+        if(cells == NULL) return -1;
+
+        clearStamps(stamps);
+        stamps->cells = cells;
+        stamps->slotCells = nCells;
+    }
+
+    return 0;
+}
+
+/**
+ * Draws a tile from its stamp if it has one, otherwise composing it (and 
+ * stamping it for next time, if it was drawn whole)
+ * 
+ * @return false if the tile's sprite spills out of the tile (see compositeTile)
+ */
+static bool stampTile(const tileData_t * data, tileStamps_t * stamps, dispData_t * disp, tile_t tile, 
+                        int row, int col) {
+    if(stamps == NULL) {
+        return compositeTile(data, disp, tile, row, col);
+    }
+
+    int width = data->tileWidth, height = data->tileHeight;
+    if(reserveStamps(stamps, width * height) < 0) {
+        countTiles(1, 0);
+        return compositeTile(data, disp, tile, row, col);
+    }
+
+    tileStamp_t * stamp = findStamp(stamps, tile, width, height);
+    drawPair_t * cells = stamps->cells + (stamp - stamps->slots) * stamps->slotCells;
+    if(stamp->tileWidth != 0) {
+        int nRows = min(height, disp->screenRows - row);
+        int nCols = min(width, disp->screenCols - col);
+        for(int dRow = 0; dRow < nRows; dRow++) {
+            memcpy(dispRow(disp, row + dRow) + col, cells + dRow * width, 
+                    nCols * sizeof(drawPair_t));
+        }
+        countTiles(1, 1);
+        return true;
+    }
+
+    // (Only views draw with stamps, so only their tiles are counted)
+    countTiles(1, 0);
+
+    // Only tiles which lie whole on the canvas (sprite included) are stamped
+    bool inTile = compositeTile(data, disp, tile, row, col);
+    if(!inTile || row + height > disp->screenRows || col + width > disp->screenCols) {
+        return inTile;
+    }
+
+    // Start over once the table fills up, to keep the probes short
+    if(stamps->nUsed >= kTileStampSlots * 3 / 4) {
+        clearStamps(stamps);
+        stamp = findStamp(stamps, tile, width, height);
+        cells = stamps->cells + (stamp - stamps->slots) * stamps->slotCells;
+    }
+
+    for(int dRow = 0; dRow < height; dRow++) {
+        memcpy(cells + dRow * width, dispRow(disp, row + dRow) + col, 
+                width * sizeof(drawPair_t));
+    }
+    stamp->tile = tile;
+    stamp->tileWidth = width;
+    stamp->tileHeight = height;
+    stamps->nUsed++;
+    return true;
+}
+
+//===============================<Map Rendering>==============================//
+/**
+ * Renders a rectangle of tiles (see renderMapRect), drawing tiles from their 
+ * stamps where possible (if stamps is not NULL)
+ */
+static int renderTiles(tileData_t * data, tileStamps_t * stamps, dispData_t * canvas, const map_t * map,
+                        int startRow, int startCol, int nRows, int nCols, bool doSprites) {
+    if(data == NULL || canvas == NULL || canvas->data == NULL) return -1;
+
+    // Only render the tiles which are on the map and (at least partly) on canvas
+    nRows = min(min(nRows, map->nRows - startRow), 
+                (canvas->screenRows + data->tileHeight - 1) / data->tileHeight);
+    nCols = min(min(nCols, map->nCols - startCol), 
+                (canvas->screenCols + data->tileWidth - 1) / data->tileWidth);
+    if(startRow < 0 || startCol < 0 || nRows <= 0 || nCols <= 0) {
+        return 0;
+    }
+
+    // Make room to note every tile whose sprite spills out of it
+    if(data->overflowCap < (unsigned) (nRows * nCols)) {
+        int * overflow = realloc(data->overflow, nRows * nCols * sizeof(int));
+        if(overflow == NULL) {
+            return -1;
+        }
+        data->overflow = overflow;
+        data->overflowCap = nRows * nCols;
+    }
+
+    // Draw every tile in one pass, putting off sprites which spill over
+    unsigned nOverflow = 0;
+    for(int dRow = 0; dRow < nRows; dRow++) {
+        for(int dCol = 0; dCol < nCols; dCol++) {
+            tile_t tile = map->data[dRow + startRow][dCol + startCol];
+            if(!doSprites) tile.sprite = kNoSprite;
+
+            if(!stampTile(data, stamps, canvas, tile, dRow * data->tileHeight, 
+                    dCol * data->tileWidth)) {
+                data->overflow[nOverflow++] = dRow * nCols + dCol;
+            }
+        }
+    }
+
+    // Then draw the spilling sprites over their neighbours
+    for(unsigned i = 0; i < nOverflow; i++) {
+        int dRow = data->overflow[i] / nCols, dCol = data->overflow[i] % nCols;
+
+        short palette;
+        char glyph;
+        const sprite_t * sprite = getTileSpriteLayer(data, 
+                                    map->data[dRow + startRow][dCol + startCol], &palette, &glyph);
+        drawSprite(canvas, sprite, palette, glyph, 
+                    dRow * data->tileHeight, dCol * data->tileWidth);
+
+        // Sprites of later tiles went on top of this one in layer order, so 
+        // redraw those it spilled onto
+        int top = dRow * data->tileHeight + sprite->yOff;
+        int left = dCol * data->tileWidth + sprite->xOff;
+        int lastRow = min(floorDiv(top + sprite->height - 1, data->tileHeight), nRows - 1);
+        int lastCol = min(floorDiv(left + sprite->width - 1, data->tileWidth), nCols - 1);
+
+        for(int row = max(floorDiv(top, data->tileHeight), 0); row <= lastRow; row++) {
+            for(int col = max(floorDiv(left, data->tileWidth), 0); col <= lastCol; col++) {
+                if(row * nCols + col <= data->overflow[i]) continue;
+
+                const sprite_t * above = getTileSpriteLayer(data, 
+                                            map->data[row + startRow][col + startCol], &palette, &glyph);
+                if(above != NULL && spriteInTile(data, above)) {
+                    drawSprite(canvas, above, palette, glyph, 
+                                row * data->tileHeight, col * data->tileWidth);
+                }
+            }
+        }
+    }
+
+    return nOverflow;
+}
+
+int renderMapRect(tileData_t * data, dispData_t * canvas, const map_t * map, int startRow, int startCol,
+                    int nRows, int nCols, bool doSprites) {
+    return renderTiles(data, NULL, canvas, map, startRow, startCol, nRows, nCols, doSprites);
+}
+
+//================================<Map View>==================================//
+/**
+ * Sizes the view's canvas to the area it is shown in and its tile record to the
+ * tiles in it (marking the view stale if any of these change, or the stamps it
+ * was drawn from have gone stale)
+ */
+static int layoutView(tileData_t * data, tileStamps_t * stamps, int nRows, int nCols, 
+                        int canvasRows, int canvasCols) {
+    mapView_t * view = &data->view;
+
+    if(view->stampGen != stamps->gen) {
+        view->stampGen = stamps->gen;
+        view->stale = true;
+    }
+
+    if(view->canvas.data == NULL || view->canvas.screenRows != canvasRows || 
+            view->canvas.screenCols != canvasCols) {
+        closeDisp(view->canvas);
+        memset(&view->canvas, 0, sizeof(dispData_t));
+        if(initDispBuffer(&view->canvas, canvasRows, canvasCols) < 0) {
+            memset(&view->canvas, 0, sizeof(dispData_t));
+            return -1;
         }
+        view->stale = true;
+    }
+
+    if(view->tiles == NULL || view->nRows != nRows || view->nCols != nCols) {
+        tile_t * tiles = realloc(view->tiles, nRows * nCols * sizeof(tile_t));
+        if(tiles == NULL) {
+            return -1;
+        }
+        view->tiles = tiles;
+        view->nRows = nRows;
+        view->nCols = nCols;
+        view->stale = true;
+    }
+
+    if(view->tileWidth != data->tileWidth || view->tileHeight != data->tileHeight) {
+        view->tileWidth = data->tileWidth;
+        view->tileHeight = data->tileHeight;
+        view->stale = true;
+    }
+
+    return 0;
+}
+
+/**
+ * Shifts the view's canvas and tile record by whole tiles (as the view moves 
+ * by dRows and dCols), leaving the tiles moved into view to be drawn
+ */
+static void scrollView(mapView_t * view, int dRows, int dCols) {
+    dispData_t * canvas = &view->canvas;
+
+    // Shift the canvas, working away from the rows being written to
+    int shiftRows = dRows * view->tileHeight, shiftCols = dCols * view->tileWidth;
+    int nRows = view->nRows * view->tileHeight - abs(shiftRows);
+    int nCols = view->nCols * view->tileWidth - abs(shiftCols);
+    for(int i = 0; i < nRows; i++) {
+        int row = (shiftRows > 0) ? i : nRows - 1 - i;
+        memmove(dispRow(canvas, row - min(shiftRows, 0)) + max(-shiftCols, 0), 
+                dispRow(canvas, row + max(shiftRows, 0)) + max(shiftCols, 0), 
+                nCols * sizeof(drawPair_t));
+    }
+
+    // Then the record of the tiles drawn there
+    nRows = view->nRows - abs(dRows);
+    nCols = view->nCols - abs(dCols);
+    for(int i = 0; i < nRows; i++) {
+        int row = (dRows > 0) ? i : nRows - 1 - i;
+        memmove(view->tiles + (row - min(dRows, 0)) * view->nCols + max(-dCols, 0),
+                view->tiles + (row + max(dRows, 0)) * view->nCols + max(dCols, 0),
+                nCols * sizeof(tile_t));
+    }
+}
+
+/**
+ * Redraws every tile in view onto a cleared canvas
+ */
+static int drawView(tileData_t * data, tileStamps_t * stamps, const map_t * map) {
+    mapView_t * view = &data->view;
+
+    for(int dRow = 0; dRow < view->nRows; dRow++) {
+        memcpy(view->tiles + dRow * view->nCols, map->data[dRow + view->scrY] + view->scrX,
+                view->nCols * sizeof(tile_t));
+    }
+
+    clearBuffer(&view->canvas);
+    int ret = renderTiles(data, stamps, &view->canvas, map, view->scrY, view->scrX, 
+                            view->nRows, view->nCols, true);
+    view->spilled = (ret > 0);
+    return (ret < 0) ? -1 : 0;
+}
+
+/**
+ * Brings the view up to date by drawing only the tiles which have scrolled into
+ * view or changed since the last draw
+ * 
+ * @return false if the view must be redrawn from scratch instead
+ */
+static bool updateView(tileData_t * data, tileStamps_t * stamps, const map_t * map, int scrX, int scrY) {
+    mapView_t * view = &data->view;
+
+    // Sprites spilling between tiles make tiles depend on their neighbours
+    int dRows = scrY - view->scrY, dCols = scrX - view->scrX;
+    if(view->stale || view->spilled || abs(dRows) >= view->nRows || abs(dCols) >= view->nCols) {
+        return false;
+    }
+
+    if(dRows != 0 || dCols != 0) {
+        scrollView(view, dRows, dCols);
+        view->scrX = scrX;
+        view->scrY = scrY;
+    }
+
+    for(int dRow = 0; dRow < view->nRows; dRow++) {
+        bool rowExposed = (dRow + dRows < 0 || dRow + dRows >= view->nRows);
+
+        for(int dCol = 0; dCol < view->nCols; dCol++) {
+            tile_t tile = map->data[dRow + scrY][dCol + scrX];
+            tile_t * drawn = &view->tiles[dRow * view->nCols + dCol];
+            if(!rowExposed && dCol + dCols >= 0 && dCol + dCols < view->nCols && 
+                    sameTile(*drawn, tile)) {
+                continue;
+            }
+
+            *drawn = tile;
+            if(!stampTile(data, stamps, &view->canvas, tile, dRow * data->tileHeight, 
+                    dCol * data->tileWidth)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void invalidateMapView(tileData_t * data) {
+    if(data == NULL) return;
+
+    // Every view drawn from the stamps goes stale with them
+    data->view.stale = true;
+    clearStamps(&data->stamps);
+    data->stamps.gen++;
+}
+
+//===============================<Map Display>================================//
+/**
+ * Draws the map into an area of the frame buffer, centered on the given tile (as
+ * far as the map allows), through a view which only draws the tiles changed or
+ * scrolled into view since it was last drawn
+ * 
+ * @param data The tiles to draw, and the view to draw them through
+ * @param stamps The composed tiles to draw from (and add to)
+ * @param disp The frame buffer to draw into
+ * @param top, left, rows, cols The area of the frame buffer to draw in
+ * 
+ * @return 0 on success, <0 on failure
+ */
+static int drawMapView(tileData_t * data, tileStamps_t * stamps, dispData_t * disp, const map_t * map, 
+                        int x, int y, int top, int left, int rows, int cols) {
+    // Width and height of the area in tiles
+    int width = cols / data->tileWidth, height = rows / data->tileHeight;
+
+    // X & Y coords of the top-left tile (try to center, but stop at map edge)
+    int scrX = max(min(x - width/2, map->nCols-width), 0);
+    int scrY = max(min(y - height/2, map->nRows-height), 0);
+
+    int nRows = min(height, map->nRows - scrY);
+    int nCols = min(width, map->nCols - scrX);
+    if(nRows <= 0 || nCols <= 0) {
+        return 0;
     }
 
-    // And then draw all of the walls
-    for(int dRow = 0; dRow < height && dRow + scrY < map.nRows; dRow++) {
-        int row = dRow + scrY;
-        for(int dCol = 0; dCol < width && dCol + scrX < map.nCols; dCol++) {
-            int col = dCol + scrX;
-            addTileWalls(data, map.data[row][col], scrX, scrY, col, row);
+    // Bring the view up to date, scrolling it if possible
+    mapView_t * view = &data->view;
+    if(layoutView(data, stamps, nRows, nCols, rows, cols) < 0) {
+        return -1;
+    }
+    if(!updateView(data, stamps, map, scrX, scrY)) {
+        view->scrX = scrX;
+        view->scrY = scrY;
+        if(drawView(data, stamps, map) < 0) {
+            view->stale = true;
+            return -1;
         }
     }
+    view->stale = false;
 
-    // Finally, draw all of the sprites
-    for(int dRow = 0; dRow < height && dRow + scrY < map.nRows; dRow++) {
-        int row = dRow + scrY;
-        for(int dCol = 0; dCol < width && dCol + scrX < map.nCols; dCol++) {
-            int col = dCol + scrX;
-            addTileSprite(data, map.data[row][col], scrX, scrY, col, row);
+    // And copy it into the frame buffer (taking along any sprites which 
+    // spilled off the tiles)
+    rows = min(rows, disp->screenRows - top);
+    cols = min(cols, disp->screenCols - left);
+    if(view->spilled) {
+        for(int row = 0; row < rows; row++) {
+            const drawPair_t * src = dispRow(&view->canvas, row);
+            drawPair_t * dst = dispRow(disp, top + row) + left;
+            for(int col = 0; col < cols; col++) {
+                if(src[col] != kEmptyCell) dst[col] = src[col];
+            }
+        }
+    } else {
+        for(int row = 0; row < min(rows, nRows * data->tileHeight); row++) {
+            memcpy(dispRow(disp, top + row) + left, dispRow(&view->canvas, row), 
+                    min(cols, nCols * data->tileWidth) * sizeof(drawPair_t));
         }
     }
 
     return 0;
 }
 
-void setCursor(tileData_t data, map_t map, int x, int y) {
-    // Determine the position of the screen
-    int width, height;  // Width and height of the screen in tiles
-    getScreenTileDim(data, &width, &height);
+/**
+ * Moves the cursor onto a tile of a map drawn by drawMapView
+ */
+static void moveMapCursor(const tileData_t * data, const map_t * map, int x, int y, int top, int left, 
+                            int rows, int cols) {
+    // Width and height of the area in tiles
+    int width = cols / data->tileWidth, height = rows / data->tileHeight;
 
     // X & Y coords of the top-left tile
-    int scrX = max(min(x - width/2, map.nCols-width), 0);
-    int scrY = max(min(y - height/2, map.nRows-height), 0);
+    int scrX = max(min(x - width/2, map->nCols-width), 0);
+    int scrY = max(min(y - height/2, map->nRows-height), 0);
 
-    // X and Y offsets of the selected tile from the top-left of the screen
+    // X and Y offsets of the selected tile from the top-left of the area
     int dX = x - scrX, dY = y-scrY;
     
     // Retarget the selected tile
-    move(dY * data.emptyBase.height + data.emptyBase.height/2, 
-            dX * data.emptyBase.width + data.emptyBase.width/2);
+    move(top + dY * data->tileHeight + data->tileHeight/2, 
+            left + dX * data->tileWidth + data->tileWidth/2);
 }
 
-//todo Consider replacing this with a general buffer to file function
+int addMap(tileData_t * data, const map_t * map, int x, int y) {
+    if(data == NULL || map == NULL) return -1;
+
+    return drawMapView(data, &data->stamps, &data->dispData, map, x, y, 0, 0, 
+                        data->dispData.screenRows, data->dispData.screenCols);
+}
 
-int mapSectionToFile(tileData_t data, map_t map, FILE* file, 
-        int startRow, int startCol, int endRow, int endCol, bool doSprites);
+void setCursor(const tileData_t * data, const map_t * map, int x, int y) {
+    if(data == NULL || map == NULL) return;
 
-int mapToFile(tileData_t data, map_t map, FILE* file) {
-    return mapSectionToFile(data, map, file, 0, 0, 0, 0, true);
+    moveMapCursor(data, map, x, y, 0, 0, data->dispData.screenRows, data->dispData.screenCols);
 }
 
-int mapToSections(tileData_t data, map_t map, FILE* file, int pgWidth, int pgHeight, bool doSprites) {
-    if(file == NULL) return -1;
+//=================================<Viewports>================================//
+int initViewport(viewport_t * port, int tileWidth, int tileHeight) {
+    if(port == NULL) return -1;
 
-    // Determine the number of rows and columns per page (and extra lines needed)
-    int pgRows = pgHeight/data.emptyBase.height;
-    if(pgRows == 0) return -2;
-    int pgCols = pgWidth/data.emptyBase.width;
-    if(pgCols == 0) return -2;
-    int pgExcess = pgHeight - pgRows*data.emptyBase.height;
-
-    // Iterate through all of the page groups
-    for(int pgRank = 0; pgRank * pgRows < map.nRows; pgRank++) {
-        for(int pgFile = 0; pgFile * pgCols < map.nCols; pgFile++) {
-            int ret = mapSectionToFile(data, map, file, 
-                    pgRank * pgRows, pgFile * pgCols,
-                    (pgRank+1) * pgRows, (pgFile+1) * pgCols, doSprites); 
-            if( ret < 0) {
-                return ret - 2;
-            }
-            for(int i = 0; i < pgExcess; i++) {
-                fprintf(file, "\n");
-            }
+    memset(port, 0, sizeof(viewport_t));
+    return loadTileDataDim(&port->tiles, tileWidth, tileHeight);
+}
+
+void rmViewport(viewport_t port) {
+    rmTileData(port.tiles);
+}
+
+void placeViewport(viewport_t * port, int top, int left, int rows, int cols) {
+    if(port == NULL) return;
+
+    port->top = top;
+    port->left = left;
+    port->rows = max(rows, 0);
+    port->cols = max(cols, 0);
+}
+
+int resizeViewport(viewport_t * port, int tileWidth, int tileHeight) {
+    if(port == NULL) return -1;
+
+    return resizeTileData(&port->tiles, tileWidth, tileHeight);
+}
+
+int addViewport(tileData_t * data, viewport_t * port, const map_t * map) {
+    if(data == NULL || port == NULL || map == NULL || port->top < 0 || port->left < 0) return -1;
+
+    // Borrow the sprites from the shared tile data for the draw
+    tileData_t * tiles = &port->tiles;
+    tiles->spriteList = data->spriteList;
+    tiles->spriteIndex = data->spriteIndex;
+
+    int ret = drawMapView(tiles, &data->stamps, &data->dispData, map, port->x, port->y, 
+                            port->top, port->left, port->rows, port->cols);
+
+    tiles->spriteList = NULL;
+    initSpriteIndex(&tiles->spriteIndex);
+    return ret;
+}
+
+void setViewportCursor(const viewport_t * port, const map_t * map) {
+    if(port == NULL || map == NULL) return;
+
+    moveMapCursor(&port->tiles, map, port->x, port->y, port->top, port->left, 
+                    port->rows, port->cols);
+}
+
+//===============================<File Display>===============================//
+// Rows of tiles rendered at a time when writing maps out to file
+#define kExportBandRows 16
+
+// Most bytes of output to render per band (images use narrower bands to fit)
+#define kExportBandBytes (8 << 20)
+
+// Bands rendered ahead of the writer, per worker thread
+#define kExportSlotsPerThread 2
+
+// Size of a cell of an image export (glyphs are drawn double height, to keep
+// the proportions of the terminal)
+#define kImageCellWidth kGlyphWidth
+#define kImageCellHeight (2 * kGlyphHeight)
+
+// The number of threads to render exports with (0 for one per processor)
+static unsigned exportThreads = 0;
+
+// The ways a rendered canvas can be written out
+typedef enum exportFormat_e {
+    kExportText,                // Plain text
+    kExportAnsi,                // Text coloured with ANSI escapes
+    kExportImage                // RGB scanlines of a raster image
+} exportFormat_t;
+
+// A band of tile rows of one section of an export
+typedef struct exportJob_s {
+    int startRow, endRow;       // The rows of tiles to write out
+    int sectStart, sectEnd;     // The rows of the section (which sprites may spill across)
+    int startCol, endCol;       // The columns of tiles to write out
+    int nBlank;                 // Blank lines to write after the band
+} exportJob_t;
+
+// The jobs of an export, and the text rendered for them
+typedef struct exportPool_s {
+    const tileData_t * data;
+    const map_t * map;
+    bool doSprites;
+    int spillRows;
+
+    exportFormat_t format;
+    raster_t * raster;          // The image being written (image exports only)
+    int cellWidth, cellHeight;  // Pixels per cell (image exports only)
+    bool glyphs;                // Draw glyphs into cells (not just their colours)
+    int bandRows;               // Most rows of tiles in a job
+
+    const exportJob_t * jobs;
+    int nJobs;
+    int maxCols;                // Widest job (in tiles)
+
+    // A slot of text for each job in flight (job i renders into slot i % nSlots)
+    int nSlots;
+    char ** text;
+    long * textLen;             // Length of the text in each slot (<0 until done)
+
+    // Progress (guarded by lock)
+    int nextJob;                // The next job to render
+    int nWritten;               // The number of jobs written out
+    bool failed;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} exportPool_t;
+
+/**
+ * Finds the number of rows of tiles by which any sprite on the map spills up or
+ * down out of its own tile (loading every sprite in use along the way, so that
+ * rendering never has to, even for sprites which failed to load)
+ */
+static int getSpillRows(const tileData_t * data, const map_t * map, bool doSprites) {
+    if(!doSprites) return 0;
+
+    int spillRows = 0;
+    for(int row = 0; row < map->nRows; row++) {
+        for(int col = 0; col < map->nCols; col++) {
+            if(map->data[row][col].sprite == kNoSprite) continue;
+
+            short palette;
+            char glyph;
+            const sprite_t * sprite = getTileSpriteLayer(data, map->data[row][col], &palette, &glyph);
+            if(sprite == NULL) continue;
+
+            int over = max(-sprite->yOff, sprite->yOff + sprite->height - data->tileHeight);
+            spillRows = max(spillRows, (over + data->tileHeight - 1) / data->tileHeight);
         }
     }
 
-    return 0;
+    return spillRows;
 }
 
-#define mapFileNextChar(file, ch) fprintf(file, "%c", ch)
-int mapSectionToFile(tileData_t data, map_t map, FILE* file, 
-        int startRow, int startCol, int endRow, int endCol, bool doSprites) {
-    if(file == NULL) return -1;
-    if(startRow > endRow || startCol > endCol) return -2;
-    if(startRow > map.nRows || startCol > map.nCols) return 1;
+/**
+ * Gets the most bytes a row of the canvas can take up when written out
+ */
+static size_t getExportLineLen(exportPool_t * pool, int nCols) {
+    switch(pool->format) {
+        case kExportAnsi:
+            // Any cell may need an escape before it, and the line one after it
+            return (size_t) nCols * (kAnsiPaletteLen + 1) + kAnsiPaletteLen + 1;
+        case kExportImage:
+            return (size_t) nCols * pool->cellWidth * pool->cellHeight * 3;
+        default:
+            return (size_t) nCols + 1;
+    }
+}
+
+/**
+ * Writes rows of a canvas out as lines of plain text
+ * 
+ * @return The number of chars written
+ */
+static long canvasToText(exportPool_t * pool, dispData_t * canvas, int startRow, int endRow, 
+                            int nCols, char * text) {
+    (void) pool;
+
+    char * line = text;
+    for(int row = startRow; row < endRow; row++) {
+        const drawPair_t * cells = dispRow(canvas, row);
+
+        memset(line, ' ', nCols);
+        for(int col = 0; col < nCols; col++) {
+            if(cells[col] != kEmptyCell) line[col] = drawPairCh(cells[col]);
+        }
+        line[nCols] = '\n';
+        line += nCols + 1;
+    }
+
+    return line - text;
+}
 
-    if(endRow == 0 || endRow > map.nRows) endRow = map.nRows;
-    if(endCol == 0 || endCol > map.nCols) endCol = map.nCols;
+/**
+ * Writes rows of a canvas out as lines of text coloured with ANSI escapes, 
+ * only changing attributes where the palette changes along a line (each line 
+ * starts and ends in the terminal's default colours)
+ * 
+ * @return The number of chars written
+ */
+static long canvasToAnsi(exportPool_t * pool, dispData_t * canvas, int startRow, int endRow, 
+                            int nCols, char * text) {
+    (void) pool;
 
+    char * out = text;
     for(int row = startRow; row < endRow; row++) {
-        for(int line = 0; line < data.emptyBase.height; line++) {
-            for(int col = startCol; col < endCol; col++) {
-                for(int i = 0; i < data.emptyBase.width; i++) {
-                    // First attempt to render the sprite layer
-                    if(doSprites && map.data[row][col].sprite != kNoSprite && (map.data[row][col].sprite < 0 || 
-                            (data.spriteList != NULL && (unsigned) map.data[row][col].sprite < listLen(data.spriteList)))) {
-                        // There is some sprite...
-
-                        int spriteNr = map.data[row][col].sprite;
-                        sprite_t * sprite = NULL;
-                        if(spriteNr < 0 && data.charSprite.data != NULL) {
-                            // Set the active sprite to the character sprite
-                            sprite = &data.charSprite;
-                            sprite->data[1][1] = getCharSpriteChar(spriteNr);
-                        } else {
-                            sprite = listGet(data.spriteList, spriteNr);
-                        }
-
-                        // If you got a sprite, try to print its next character
-                        if(sprite != NULL && line >= sprite->yOff && line < sprite->yOff + sprite->height &&
-                                i >= sprite->xOff && i < sprite->xOff + sprite->width) {
-                                int y = line-sprite->yOff, x = i-sprite->xOff;
-
-                                char ch = sprite->data[y][x];
-                                mapFileNextChar(file, (ch == 0) ? ' ' : ch);
-
-                                continue;
-                        }
-
-                    }
-
-                    // Next attempt to render the wall layer
-                    if(map.data[row][col].uWall == 1 && line < data.uWall.height && data.uWall.data[line][i]) {
-                        // Check for characters in the upper wall
-                        mapFileNextChar(file, data.uWall.data[line][i]);
-                        continue;
-                    } else if(map.data[row][col].uWall == 2 && line < data.uDoor.height && data.uDoor.data[line][i]) {
-                        // Check for characters in the upper door
-                        mapFileNextChar(file, data.uDoor.data[line][i]);
-                        continue;
-                    } else if(map.data[row][col].lWall == 1 && i < data.lWall.width && data.lWall.data[line][i]) {
-                        // Check for characters in the left wall
-                        mapFileNextChar(file, data.lWall.data[line][i]);
-                        continue;
-                    } else if(map.data[row][col].lWall == 2 && i < data.lDoor.width && data.lDoor.data[line][i]) {
-                        // Check for characters in the left door
-                        mapFileNextChar(file, data.lDoor.data[line][i]);
-                        continue;
-                    } else if(map.data[row][col].dWall == 1 && line >= data.emptyBase.height - data.dWall.height 
-                                && data.dWall.data[line - (data.emptyBase.height - data.dWall.height)][i]) {
-                        // Check for characters in the lower wall
-                        mapFileNextChar(file, data.dWall.data[line - (data.emptyBase.height - data.dWall.height)][i]);
-                        continue;
-                    } else if(map.data[row][col].dWall == 2 && line >= data.emptyBase.height - data.dDoor.height 
-                                && data.dDoor.data[line - (data.emptyBase.height - data.dDoor.height)][i]) {
-                        // Check for characters in the lower door
-                        mapFileNextChar(file, data.dDoor.data[line - (data.emptyBase.height - data.dDoor.height)][i]);
-                        continue;
-                    } else if(map.data[row][col].rWall == 1 && i >= data.emptyBase.width - data.rWall.width 
-                                && data.rWall.data[line][i - (data.emptyBase.width - data.rWall.width)]) {
-                        // Check for characters in the right wall
-                        mapFileNextChar(file, data.rWall.data[line][i - (data.emptyBase.width - data.rWall.width)]);
-                        continue;
-                    } else if(map.data[row][col].rWall == 2 && i >= data.emptyBase.width - data.rDoor.width 
-                                && data.rDoor.data[line][i - (data.emptyBase.width - data.rDoor.width)]) {
-                        // Check for characters in the right wall
-                        mapFileNextChar(file, data.rDoor.data[line][i - (data.emptyBase.width - data.rDoor.width)]);
-                        continue;
-                    } 
-                    
-                    // Finally, render the base layer
-                    if(!map.data[row][col].isEmpty && data.tileBase.data[line][i]) {
-                        // Check for characters in the base tile
-                        mapFileNextChar(file, data.tileBase.data[line][i]);
-                        continue;
-                    }
-                    
-                    // Output the proper character to file
-                    mapFileNextChar(file, ' ');
+        const drawPair_t * cells = dispRow(canvas, row);
+
+        short cur = 0;
+        for(int col = 0; col < nCols; col++) {
+            short palette = (cells[col] == kEmptyCell) ? 0 : drawPairPalette(cells[col]);
+            if(palette < 0 || palette > kMaxPalette) palette = kDefPalette;
 
+            if(palette != cur) {
+                const char * seq = getAnsiPalette(palette);
+                size_t len = strlen(seq);
+                memcpy(out, seq, len);
+                out += len;
+                cur = palette;
+            }
+            *out++ = (cells[col] == kEmptyCell) ? ' ' : drawPairCh(cells[col]);
+        }
+
+        if(cur != 0) {
+            const char * seq = getAnsiPalette(0);
+            size_t len = strlen(seq);
+            memcpy(out, seq, len);
+            out += len;
+        }
+        *out++ = '\n';
+    }
+
+    return out - text;
+}
+
+/**
+ * Writes rows of a canvas out as RGB scanlines, each cell either drawn with its
+ * glyph from the embedded font, or filled with the colour it shows most (its 
+ * foreground if it holds a visible glyph)
+ * 
+ * @return The number of bytes written
+ */
+static long canvasToPixels(exportPool_t * pool, dispData_t * canvas, int startRow, int endRow, 
+                            int nCols, char * text) {
+    uint8_t * out = (uint8_t *) text;
+    for(int row = startRow; row < endRow; row++) {
+        const drawPair_t * cells = dispRow(canvas, row);
+
+        for(int y = 0; y < pool->cellHeight; y++) {
+            int glyphRow = y * kGlyphHeight / pool->cellHeight;
+
+            // Colours of the last cell looked up (neighbouring cells mostly match)
+            drawPair_t last = kEmptyCell;
+            uint32_t fg, bg;
+            getPaletteRGB(0, &fg, &bg);
+
+            for(int col = 0; col < nCols; col++) {
+                drawPair_t pair = cells[col];
+                if(pair != last) {
+                    getPaletteRGB((pair == kEmptyCell) ? 0 : drawPairPalette(pair), &fg, &bg);
+                    last = pair;
+                }
+
+                char ch = (pair == kEmptyCell) ? ' ' : drawPairCh(pair);
+                uint8_t bits = pool->glyphs ? getGlyphRow(ch, glyphRow) : 
+                                    (ch == ' ') ? 0 : 0xFF;
+
+                for(int x = 0; x < pool->cellWidth; x++) {
+                    uint32_t rgb = ((bits >> (x * kGlyphWidth / pool->cellWidth)) & 1) ? fg : bg;
+                    out[0] = rgb >> 16;
+                    out[1] = rgb >> 8;
+                    out[2] = rgb;
+                    out += 3;
                 }
             }
-            fprintf(file, "\n");
         }
     }
 
-    return 0;
-}
\ No newline at end of file
+    return out - (uint8_t *) text;
+}
+
+/**
+ * Allocates a canvas large enough for any job of the export
+ */
+static int mkJobCanvas(exportPool_t * pool, dispData_t * canvas) {
+    return initDispBuffer(canvas, (pool->bandRows + 2 * pool->spillRows) * pool->data->tileHeight,
+                            pool->maxCols * pool->data->tileWidth);
+}
+
+/**
+ * Renders one job of an export to text
+ * 
+ * @return The number of chars of text (<0 on failure)
+ */
+static long renderJob(exportPool_t * pool, tileData_t * data, dispData_t * canvas, 
+                        const exportJob_t * job, char * text) {
+    // Render the rows around the band too, in case their sprites spill into it
+    int first = max(job->startRow - pool->spillRows, job->sectStart);
+    int last = min(job->endRow + pool->spillRows, job->sectEnd);
+
+    clearBuffer(canvas);
+    if(renderMapRect(data, canvas, pool->map, first, job->startCol, last - first, 
+            job->endCol - job->startCol, pool->doSprites) < 0) {
+        return -1;
+    }
+
+    long (*toText)(exportPool_t *, dispData_t *, int, int, int, char *) = 
+            (pool->format == kExportAnsi) ? canvasToAnsi : 
+            (pool->format == kExportImage) ? canvasToPixels : canvasToText;
+    long len = toText(pool, canvas, (job->startRow - first) * data->tileHeight, 
+                        (job->endRow - first) * data->tileHeight, 
+                        (job->endCol - job->startCol) * data->tileWidth, text);
+    memset(text + len, '\n', job->nBlank);
+    return len + job->nBlank;
+}
+
+/**
+ * Writes out the rendered text of a job
+ */
+static int writeJob(exportPool_t * pool, FILE* file, const char * text, long len) {
+    if(pool->format == kExportImage) {
+        return writeRaster(pool->raster, (const uint8_t *) text, len);
+    }
+    return (fwrite(text, sizeof(char), len, file) == (size_t) len) ? 0 : -1;
+}
+
+/**
+ * Renders jobs of the export for as long as there are any left
+ */
+static void * exportWorker(void * arg) {
+    exportPool_t * pool = arg;
+
+    // Each worker needs its own canvas and compositor scratch space (which must
+    // not be the caller's, as the tile data here is only a copy)
+    tileData_t data = *pool->data;
+    data.overflow = NULL;
+    data.overflowCap = 0;
+
+    dispData_t canvas;
+    bool ok = (mkJobCanvas(pool, &canvas) == 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while(true) {
+        // Wait for a free slot
+        while(!pool->failed && pool->nextJob < pool->nJobs && 
+                pool->nextJob >= pool->nWritten + pool->nSlots) {
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        }
+        if(!ok) pool->failed = true;
+        if(pool->failed || pool->nextJob >= pool->nJobs) break;
+
+        int job = pool->nextJob++;
+        int slot = job % pool->nSlots;
+        pthread_mutex_unlock(&pool->lock);
+
+        long len = renderJob(pool, &data, &canvas, &pool->jobs[job], pool->text[slot]);
+
+        pthread_mutex_lock(&pool->lock);
+        if(len < 0) {
+            pool->failed = true;
+        }
+        pool->textLen[slot] = len;
+        pthread_cond_broadcast(&pool->cond);
+    }
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    if(ok) closeDisp(canvas);
+    if(data.overflow != NULL) free(data.overflow);
+    return NULL;
+}
+
+/**
+ * Renders all the jobs of an export (across the worker threads), writing them 
+ * out to file in order
+ */
+static int runExport(exportPool_t * pool, const exportJob_t * jobs, int nJobs, FILE* file) {
+    pool->jobs = jobs;
+    pool->nJobs = nJobs;
+    for(int i = 0; i < nJobs; i++) {
+        pool->maxCols = max(pool->maxCols, jobs[i].endCol - jobs[i].startCol);
+    }
+
+    unsigned nThreads = exportThreads;
+    if(nThreads == 0) {
+        long nProcs = sysconf(_SC_NPROCESSORS_ONLN);
+        nThreads = (nProcs > 0) ? nProcs : 1;
+    }
+    nThreads = min(nThreads, (unsigned) pool->nJobs);
+
+    // Allocate a slot of text per job in flight
+    pool->nSlots = max(nThreads * kExportSlotsPerThread, 1);
+    size_t bandLen = (size_t) pool->bandRows * pool->data->tileHeight * 
+                        getExportLineLen(pool, pool->maxCols * pool->data->tileWidth);
+    size_t textCap = bandLen;
+    for(int i = 0; i < pool->nJobs; i++) {
+        textCap = max(textCap, bandLen + pool->jobs[i].nBlank);
+    }
+
+    int ret = -1;
+    pool->text = calloc(pool->nSlots, sizeof(char *));
+    pool->textLen = calloc(pool->nSlots, sizeof(long));
+    if(pool->text == NULL || pool->textLen == NULL) {
+        goto runExportCleanup;
+    }
+    for(int i = 0; i < pool->nSlots; i++) {
+        pool->text[i] = malloc(textCap);
+        pool->textLen[i] = -1;
+        if(pool->text[i] == NULL) {
+            goto runExportCleanup;
+        }
+    }
+
+    // With a single thread, just render each job in turn
+    if(nThreads <= 1) {
+        tileData_t data = *pool->data;
+        data.overflow = NULL;
+        data.overflowCap = 0;
+
+        dispData_t canvas;
+        if(mkJobCanvas(pool, &canvas) < 0) {
+            goto runExportCleanup;
+        }
+
+        ret = 0;
+        for(int i = 0; i < pool->nJobs && ret == 0; i++) {
+            long len = renderJob(pool, &data, &canvas, &pool->jobs[i], pool->text[0]);
+            if(len < 0 || writeJob(pool, file, pool->text[0], len) < 0) {
+                ret = -1;
+            }
+        }
+
+        closeDisp(canvas);
+        if(data.overflow != NULL) free(data.overflow);
+        goto runExportCleanup;
+    }
+
+    // Otherwise start up the workers, and write out each job as it is done
+    pthread_t * threads = calloc(nThreads, sizeof(pthread_t));
+    if(threads == NULL) {
+        goto runExportCleanup;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    pool->nextJob = pool->nWritten = 0;
+    pool->failed = false;
+
+    unsigned nStarted = 0;
+    while(nStarted < nThreads && 
+            pthread_create(&threads[nStarted], NULL, exportWorker, pool) == 0) {
+        ++nStarted;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if(nStarted == 0) pool->failed = true;
+    for(int i = 0; i < pool->nJobs && !pool->failed; i++) {
+        int slot = i % pool->nSlots;
+        while(!pool->failed && pool->textLen[slot] < 0) {
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        }
+        if(pool->failed) break;
+
+        // Write without holding the lock, so the workers can carry on
+        long len = pool->textLen[slot];
+        pthread_mutex_unlock(&pool->lock);
+        bool written = (writeJob(pool, file, pool->text[slot], len) == 0);
+        pthread_mutex_lock(&pool->lock);
+
+        if(!written) pool->failed = true;
+        pool->textLen[slot] = -1;
+        pool->nWritten++;
+        pthread_cond_broadcast(&pool->cond);
+    }
+    ret = pool->failed ? -1 : 0;
+    pool->failed = true;    // Stops any workers still waiting for a slot
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for(unsigned i = 0; i < nStarted; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->cond);
+
+runExportCleanup:
+    for(int i = 0; pool->text != NULL && i < pool->nSlots; i++) {
+        if(pool->text[i] != NULL) free(pool->text[i]);
+    }
+    if(pool->text != NULL) free(pool->text);
+    if(pool->textLen != NULL) free(pool->textLen);
+    return ret;
+}
+
+/**
+ * Sets up an export of the given format
+ */
+static void initExportPool(exportPool_t * pool, const tileData_t * data, const map_t * map, bool doSprites, 
+                            exportFormat_t format) {
+    memset(pool, 0, sizeof(exportPool_t));
+    pool->data = data;
+    pool->map = map;
+    pool->doSprites = doSprites;
+    pool->format = format;
+    pool->bandRows = kExportBandRows;
+
+    // Sprites are all loaded here, before any worker can need one
+    pool->spillRows = getSpillRows(data, map, doSprites);
+}
+
+/**
+ * Renders the whole map out to file, in bands of rows
+ */
+static int exportMap(exportPool_t * pool, FILE* file) {
+    const map_t * map = pool->map;
+
+    // Narrow the bands if the rows of the map write out large
+    size_t rowLen = (size_t) pool->data->tileHeight * 
+                        getExportLineLen(pool, map->nCols * pool->data->tileWidth);
+    pool->bandRows = max(min((size_t) kExportBandRows, kExportBandBytes / rowLen), (size_t) 1);
+
+    int nJobs = (map->nRows + pool->bandRows - 1) / pool->bandRows;
+    exportJob_t * jobs = calloc(nJobs, sizeof(exportJob_t));
+    if(jobs == NULL) {
+        return -1;
+    }
+    for(int i = 0; i < nJobs; i++) {
+        jobs[i] = (exportJob_t) {i * pool->bandRows, min((i+1) * pool->bandRows, map->nRows),
+                                    0, map->nRows, 0, map->nCols, 0};
+    }
+
+    int ret = runExport(pool, jobs, nJobs, file);
+
+    free(jobs);
+    return ret;
+}
+
+void setExportThreads(unsigned nThreads) {
+    exportThreads = nThreads;
+}
+
+int mapToFile(const tileData_t * data, const map_t * map, FILE* file) {
+    if(data == NULL || map == NULL || file == NULL) return -1;
+    if(map->nRows <= 0 || map->nCols <= 0) return 0;
+
+    exportPool_t pool;
+    initExportPool(&pool, data, map, true, kExportText);
+    return exportMap(&pool, file);
+}
+
+int mapToAnsiFile(const tileData_t * data, const map_t * map, FILE* file) {
+    if(data == NULL || map == NULL || file == NULL) return -1;
+    if(map->nRows <= 0 || map->nCols <= 0) return 0;
+
+    exportPool_t pool;
+    initExportPool(&pool, data, map, true, kExportAnsi);
+    return exportMap(&pool, file);
+}
+
+int mapToImage(const tileData_t * data, const map_t * map, FILE* file, rasterFormat_t format, bool glyphs) {
+    if(data == NULL || map == NULL || file == NULL || map->nRows <= 0 || map->nCols <= 0) return -1;
+
+    exportPool_t pool;
+    initExportPool(&pool, data, map, true, kExportImage);
+    pool.glyphs = glyphs;
+    pool.cellWidth = glyphs ? kImageCellWidth : 1;
+    pool.cellHeight = glyphs ? kImageCellHeight : 2;
+
+    // Image sizes are limited to 31 bits
+    long width = (long) map->nCols * data->tileWidth * pool.cellWidth;
+    long height = (long) map->nRows * data->tileHeight * pool.cellHeight;
+    if(width > INT32_MAX || height > INT32_MAX) {
+        return -2;
+    }
+
+    raster_t raster;
+    if(openRaster(&raster, file, format, width, height) < 0) {
+        return -1;
+    }
+    pool.raster = &raster;
+
+    int ret = exportMap(&pool, file);
+    if(closeRaster(&raster) < 0) {
+        ret = -1;
+    }
+    return ret;
+}
+
+int mapToSections(const tileData_t * data, const map_t * map, FILE* file, int pgWidth, int pgHeight, bool doSprites) {
+    if(data == NULL || map == NULL || file == NULL) return -1;
+
+    // Determine the number of rows and columns per page (and extra lines needed)
+    int pgRows = pgHeight/data->tileHeight;
+    if(pgRows == 0) return -2;
+    int pgCols = pgWidth/data->tileWidth;
+    if(pgCols == 0) return -2;
+    int pgExcess = pgHeight - pgRows*data->tileHeight;
+
+    if(map->nRows <= 0 || map->nCols <= 0) return 0;
+
+    // Split each page into bands of rows (pages are rendered independently)
+    int nRanks = (map->nRows + pgRows - 1) / pgRows;
+    int nFiles = (map->nCols + pgCols - 1) / pgCols;
+    int bandsPerPage = (pgRows + kExportBandRows - 1) / kExportBandRows;
+
+    exportJob_t * jobs = calloc((size_t) nRanks * nFiles * bandsPerPage, sizeof(exportJob_t));
+    if(jobs == NULL) {
+        return -3;
+    }
+
+    int nJobs = 0;
+    for(int pgRank = 0; pgRank < nRanks; pgRank++) {
+        int sectStart = pgRank * pgRows, sectEnd = min(sectStart + pgRows, map->nRows);
+
+        for(int pgFile = 0; pgFile < nFiles; pgFile++) {
+            int startCol = pgFile * pgCols, endCol = min(startCol + pgCols, map->nCols);
+
+            for(int band = sectStart; band < sectEnd; band += kExportBandRows) {
+                int bandEnd = min(band + kExportBandRows, sectEnd);
+                jobs[nJobs++] = (exportJob_t) {band, bandEnd, sectStart, sectEnd, 
+                                                startCol, endCol, 
+                                                (bandEnd == sectEnd) ? pgExcess : 0};
+            }
+        }
+    }
+
+    exportPool_t pool;
+    initExportPool(&pool, data, map, doSprites, kExportText);
+    int ret = runExport(&pool, jobs, nJobs, file);
+
+    free(jobs);
+    return (ret < 0) ? -3 : 0;
+}
@@ -6,6 +6,7 @@
 #include "sprite.h"
 #include "tile.h"
 #include "map.h"
+#include "raster.h"
 
 
 //==============================<Sprite Display>==============================//
@@ -18,7 +19,7 @@
  * @param screenRow The top row to draw in
  * @param screenCol The left column to draw in
  */
-void addSprite(dispData_t * data, sprite_t sprite, short palette, int screenRow, int screenCol);
+void addSprite(dispData_t * data, const sprite_t * sprite, short palette, int screenRow, int screenCol);
 
 //===============================<Tile Display>===============================//
 /**
@@ -64,12 +65,34 @@ void addTileSprite(tileData_t * data, tile_t tile, int scrX, int scrY, int x, in
  * @param width A return pointer for the width of the screen in tiles
  * @param height A return pointer for the height of the scren in tiles
  */
-void getScreenTileDim(tileData_t data, int * width, int * height);
+void getScreenTileDim(const tileData_t * data, int * width, int * height);
+
+//===============================<Map Rendering>==============================//
+/**
+ * Renders a rectangle of the map into a buffer (with its top-left tile at the 
+ * top-left of the buffer). The buffer may be of any size, and need not be on 
+ * screen (see initDispBuffer), so this works without curses running.
+ * 
+ * @param data The tile data to render with
+ * @param canvas The buffer to render into
+ * @param map The map to render
+ * @param startRow The first row of tiles to render
+ * @param startCol The first column of tiles to render
+ * @param nRows The number of rows of tiles to render
+ * @param nCols The number of columns of tiles to render
+ * @param doSprites Renders the sprite layer iff this is set true
+ * 
+ * @return The number of sprites which spilled out of their tiles (<0 on 
+ *         failure)
+ */
+int renderMapRect(tileData_t * data, dispData_t * canvas, const map_t * map, int startRow, int startCol,
+                    int nRows, int nCols, bool doSprites);
 
 //===============================<Map Display>================================//
 /**
  * Buffers the section of the map in view, with focus on the tile at position 
- * (x,y)
+ * (x,y). Tiles are kept from one call to the next, so only the tiles which have
+ * scrolled into view or changed since the last call are drawn afresh.
  * 
  * @param data The tile data struct to use for display
  * @param map The map to display
@@ -78,7 +101,16 @@ void getScreenTileDim(tileData_t data, int * width, int * height);
  * 
  * @return 0 on success, <0 on failure
  */
-int addMap(tileData_t * data, map_t map, int x, int y);
+int addMap(tileData_t * data, const map_t * map, int x, int y);
+
+/**
+ * Forces the next addMap (and addViewport) to redraw every tile in view (call 
+ * after changing the sprites in use, as addMap otherwise only redraws tiles 
+ * which have changed or scrolled into view, and reuses tiles composed before)
+ * 
+ * @param data The tile data struct used for display
+ */
+void invalidateMapView(tileData_t * data);
 
 /**
  * Sets cursor focus on the tile at position (x,y)
@@ -88,7 +120,90 @@ int addMap(tileData_t * data, map_t map, int x, int y);
  * @param x The x coordinate of the selected tile
  * @param y The y coordinate of the selected cell
  */
-void setCursor(tileData_t data, map_t map, int x, int y);
+void setCursor(const tileData_t * data, const map_t * map, int x, int y);
+
+//=================================<Viewports>================================//
+/*
+ * A viewport shows the map in an area of the screen, with its own focus and 
+ * tile size. Viewports draw with the sprites of a shared tileData_t, and from 
+ * its composed tiles, so a tile already drawn by addMap or another viewport of 
+ * the same tile size is copied rather than composed again.
+ */
+typedef struct viewport_s {
+    int top, left;          // Position of the viewport on screen
+    int rows, cols;         // Size of the viewport (in chars)
+    int x, y;               // The selected tile
+    tileData_t tiles;       // Tile size and view of the viewport (no sprites)
+} viewport_t;
+
+/**
+ * Initializes a viewport (with an empty area, see placeViewport)
+ * 
+ * @param port The viewport to initialize
+ * @param tileWidth The width of the viewport's tiles (in chars)
+ * @param tileHeight The height of the viewport's tiles (in chars)
+ * 
+ * @return 0 on success, <0 on failure
+ */
+int initViewport(viewport_t * port, int tileWidth, int tileHeight);
+
+/**
+ * Frees all data allocated by a viewport
+ * 
+ * @param port The viewport to free
+ */
+void rmViewport(viewport_t port);
+
+/**
+ * Moves a viewport to an area of the screen
+ * 
+ * @param port The viewport to move
+ * @param top The top row of the area
+ * @param left The left column of the area
+ * @param rows The height of the area
+ * @param cols The width of the area
+ */
+void placeViewport(viewport_t * port, int top, int left, int rows, int cols);
+
+/**
+ * Changes the size of a viewport's tiles
+ * 
+ * @param port The viewport to update
+ * @param tileWidth The new width of the tiles (in chars)
+ * @param tileHeight The new height of the tiles (in chars)
+ * 
+ * @return 0 on success, <0 on failure
+ */
+int resizeViewport(viewport_t * port, int tileWidth, int tileHeight);
+
+/**
+ * Buffers the section of the map in a viewport's area, with focus on its 
+ * selected tile (see addMap)
+ * 
+ * @param data The tile data struct to draw with (sprites, screen and composed
+ *             tiles)
+ * @param port The viewport to draw
+ * @param map The map to display
+ * 
+ * @return 0 on success, <0 on failure
+ */
+int addViewport(tileData_t * data, viewport_t * port, const map_t * map);
+
+/**
+ * Sets cursor focus on a viewport's selected tile
+ * 
+ * @param port The viewport to focus
+ * @param map The map displayed
+ */
+void setViewportCursor(const viewport_t * port, const map_t * map);
+
+/**
+ * Sets the number of threads that mapToFile and mapToSections render with
+ * (the output is the same for any number of threads)
+ * 
+ * @param nThreads The number of threads to use (0 for one per processor)
+ */
+void setExportThreads(unsigned nThreads);
 
 /**
  * Renders the map out to the specified file
@@ -99,7 +214,35 @@ void setCursor(tileData_t data, map_t map, int x, int y);
  * 
  * @return 0 on success, <0 on failure
  */
-int mapToFile(tileData_t data, map_t map, FILE* file);
+int mapToFile(const tileData_t * data, const map_t * map, FILE* file);
+
+/**
+ * Renders the map out to the specified file in colour, as text with ANSI escapes
+ * (for viewing with cat or less -R)
+ * 
+ * @param data The tile data to use in rendering
+ * @param map The map to render out
+ * @param file The file to write out to
+ * 
+ * @return 0 on success, <0 on failure
+ */
+int mapToAnsiFile(const tileData_t * data, const map_t * map, FILE* file);
+
+/**
+ * Renders the map out to the specified file as an image, in the colours of its
+ * palettes (a 1000x1000 tile map makes a 9000x10000 pixel image without glyphs,
+ * and 72000x80000 with them)
+ * 
+ * @param data The tile data to use in rendering
+ * @param map The map to render out
+ * @param file The file to write out to
+ * @param format The image format to write (PPM or PNG)
+ * @param glyphs Draws each cell's glyph with the embedded font if set, otherwise
+ *               just fills each cell (1x2 pixels) with the colour it shows
+ * 
+ * @return 0 on success, <0 on failure (-2 if the image would be too large)
+ */
+int mapToImage(const tileData_t * data, const map_t * map, FILE* file, rasterFormat_t format, bool glyphs);
 
 /**
  * Renders the map out to file in page sections (designed for good txt printout)
@@ -113,6 +256,6 @@ int mapToFile(tileData_t data, map_t map, FILE* file);
  * 
  * @return 0 on success, <0 on failure
  */
-int mapToSections(tileData_t data, map_t map, FILE* file, int pgWidth, int pgHeight, bool doSprites);
+int mapToSections(const tileData_t * data, const map_t * map, FILE* file, int pgWidth, int pgHeight, bool doSprites);
 
 #endif
\ No newline at end of file
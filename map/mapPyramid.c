@@ -0,0 +1,270 @@
+#include "mapPyramid.h"
+
+#include <string.h>
+#include <curses.h>
+
+#ifndef min
+#define min(a, b) ((a < b) ? a : b)
+#endif
+
+#ifndef max
+#define max(a, b) ((a > b) ? a : b)
+#endif
+
+//==================================<Helpers>=================================//
+/**
+ * Summarizes a single tile as a level 0 cell
+ */
+static mipCell_t summarizeTile(tile_t tile) {
+    mipCell_t cell;
+    memset(&cell, 0, sizeof(mipCell_t));
+    if(tile.isEmpty) {
+        return cell;
+    }
+
+    cell.nTiles = 1;
+    cell.nWalls = (tile.lWall || tile.rWall || tile.uWall || tile.dWall);
+    cell.nDoors = (tile.lWall > 1 || tile.rWall > 1 || tile.uWall > 1 || tile.dWall > 1);
+
+    cell.palette = (tile.bgOverride != 0) ? tile.bgOverride : tile.bgPalette;
+    if(cell.palette == 0) cell.palette = kDefPalette;
+
+    if(tile.sprite != kNoSprite) {
+        cell.nSprites = 1;
+
+        // Character sprites show their own character, all others a marker
+        cell.spriteGlyph = (tile.sprite < 0) ? getCharSpriteChar(tile.sprite) : kOverviewSprite;
+        if(cell.spriteGlyph == '\0' || cell.spriteGlyph == ' ') {
+            cell.spriteGlyph = kOverviewSprite;
+        }
+
+        cell.spritePalette = (tile.spriteOverride != 0) ? tile.spriteOverride : tile.spritePalette;
+        if(cell.spritePalette == 0) cell.spritePalette = kDefPalette;
+    }
+
+    return cell;
+}
+
+/**
+ * Gets a cell of the pyramid (level 0 cells are summarized from the map)
+ */
+static mipCell_t getMipCell(const mapPyramid_t * pyramid, const map_t * map, int level, int row, int col) {
+    if(level == 0) {
+        return summarizeTile(map->data[row][col]);
+    }
+    return pyramid->levels[level][row * pyramid->nCols[level] + col];
+}
+
+/**
+ * Recomputes a cell of the pyramid from the (up to) 2x2 cells beneath it
+ */
+static void mergeMipCell(mapPyramid_t * pyramid, const map_t * map, int level, int row, int col) {
+    mipCell_t children[4];
+    int nChildren = 0;
+    for(int dRow = 0; dRow < 2; dRow++) {
+        for(int dCol = 0; dCol < 2; dCol++) {
+            int childRow = 2 * row + dRow, childCol = 2 * col + dCol;
+            if(childRow < pyramid->nRows[level - 1] && childCol < pyramid->nCols[level - 1]) {
+                children[nChildren++] = getMipCell(pyramid, map, level - 1, childRow, childCol);
+            }
+        }
+    }
+
+    mipCell_t cell;
+    memset(&cell, 0, sizeof(mipCell_t));
+    uint32_t bestTiles = 0;
+    for(int i = 0; i < nChildren; i++) {
+        cell.nTiles += children[i].nTiles;
+        cell.nWalls += children[i].nWalls;
+        cell.nDoors += children[i].nDoors;
+        cell.nSprites += children[i].nSprites;
+
+        // Show the first sprite found
+        if(cell.spriteGlyph == '\0' && children[i].nSprites > 0) {
+            cell.spriteGlyph = children[i].spriteGlyph;
+            cell.spritePalette = children[i].spritePalette;
+        }
+
+        // Take the palette covering the most tiles of the children
+        uint32_t nTiles = 0;
+        for(int j = 0; j < nChildren; j++) {
+            if(children[j].palette == children[i].palette) nTiles += children[j].nTiles;
+        }
+        if(nTiles > bestTiles) {
+            bestTiles = nTiles;
+            cell.palette = children[i].palette;
+        }
+    }
+
+    pyramid->levels[level][row * pyramid->nCols[level] + col] = cell;
+}
+
+//=============================<Init and Cleanup>=============================//
+void initMapPyramid(mapPyramid_t * pyramid) {
+    if(pyramid == NULL) return;
+
+    memset(pyramid, 0, sizeof(mapPyramid_t));
+}
+
+int buildMapPyramid(mapPyramid_t * pyramid, const map_t * map) {
+    if(pyramid == NULL || map == NULL) {
+        return -1;
+    }
+
+    rmMapPyramid(*pyramid);
+    initMapPyramid(pyramid);
+    if(map->nRows <= 0 || map->nCols <= 0) {
+        return -1;
+    }
+
+    // Halve the map until it fits in a single cell
+    int nLevels = 1;
+    while((map->nRows - 1) >> (nLevels - 1) > 0 || (map->nCols - 1) >> (nLevels - 1) > 0) {
+        ++nLevels;
+    }
+
+    pyramid->nRows = calloc(nLevels, sizeof(int));
+    pyramid->nCols = calloc(nLevels, sizeof(int));
+    pyramid->levels = calloc(nLevels, sizeof(mipCell_t *));
+    if(pyramid->nRows == NULL || pyramid->nCols == NULL || pyramid->levels == NULL) {
+        goto buildMapPyramidFail;
+    }
+
+    for(int level = 0; level < nLevels; level++) {
+        pyramid->nRows[level] = ((map->nRows - 1) >> level) + 1;
+        pyramid->nCols[level] = ((map->nCols - 1) >> level) + 1;
+        if(level == 0) continue;
+
+        pyramid->levels[level] = calloc((size_t) pyramid->nRows[level] * pyramid->nCols[level],
+                                        sizeof(mipCell_t));
+        if(pyramid->levels[level] == NULL) {
+            goto buildMapPyramidFail;
+        }
+    }
+    pyramid->nLevels = nLevels;
+
+    updateMapPyramid(pyramid, map, 0, 0, map->nCols - 1, map->nRows - 1);
+    return 0;
+
+buildMapPyramidFail:
+    pyramid->nLevels = nLevels;
+    rmMapPyramid(*pyramid);
+    initMapPyramid(pyramid);
+    return -1;
+}
+
+void rmMapPyramid(mapPyramid_t pyramid) {
+    if(pyramid.levels != NULL) {
+        for(int level = 0; level < pyramid.nLevels; level++) {
+            if(pyramid.levels[level] != NULL) free(pyramid.levels[level]);
+        }
+        free(pyramid.levels);
+    }
+    if(pyramid.nRows != NULL) free(pyramid.nRows);
+    if(pyramid.nCols != NULL) free(pyramid.nCols);
+}
+
+void updateMapPyramid(mapPyramid_t * pyramid, const map_t * map, int x0, int y0, int x1, int y1) {
+    if(pyramid == NULL || map == NULL || pyramid->nLevels == 0) return;
+
+    x0 = max(x0, 0);
+    y0 = max(y0, 0);
+    x1 = min(x1, map->nCols - 1);
+    y1 = min(y1, map->nRows - 1);
+    if(x0 > x1 || y0 > y1) return;
+
+    // Each level only changes over the cells above the edited ones
+    for(int level = 1; level < pyramid->nLevels; level++) {
+        for(int row = y0 >> level; row <= y1 >> level; row++) {
+            for(int col = x0 >> level; col <= x1 >> level; col++) {
+                mergeMipCell(pyramid, map, level, row, col);
+            }
+        }
+    }
+}
+
+//=================================<Display>==================================//
+drawPair_t getOverviewCell(const mapPyramid_t * pyramid, const map_t * map, int level, int row, int col) {
+    mipCell_t cell = getMipCell(pyramid, map, level, row, col);
+    if(cell.nTiles == 0) {
+        return kEmptyCell;
+    }
+
+    // Sprites show wherever they make up a quarter of the tiles (so any sprite 
+    // shows at levels 0 and 1), and walls wherever they make up half
+    if(4 * cell.nSprites >= cell.nTiles) {
+        return mkDrawPair(cell.spritePalette, cell.spriteGlyph);
+    }
+    if(2 * cell.nWalls >= cell.nTiles) {
+        return mkDrawPair(cell.palette, (cell.nDoors > 0) ? kOverviewDoor : kOverviewWall);
+    }
+    return mkDrawPair(cell.palette, kOverviewFloor);
+}
+
+/**
+ * Finds the cell of a level at the top-left of the screen (centering the
+ * selected tile, but stopping at the edges of the map)
+ */
+static void getOverviewOrigin(dispData_t * data, const mapPyramid_t * pyramid, int level,
+                                int x, int y, int * scrRow, int * scrCol) {
+    *scrCol = max(min((x >> level) - data->screenCols/2, pyramid->nCols[level] - data->screenCols), 0);
+    *scrRow = max(min((y >> level) - data->screenRows/2, pyramid->nRows[level] - data->screenRows), 0);
+}
+
+int addMapOverview(dispData_t * data, const mapPyramid_t * pyramid, const map_t * map, int level,
+                    int x, int y) {
+    if(data == NULL || data->data == NULL || pyramid == NULL || map == NULL || level < 0 ||
+            level >= pyramid->nLevels) {
+        return -1;
+    }
+
+    int scrRow, scrCol;
+    getOverviewOrigin(data, pyramid, level, x, y, &scrRow, &scrCol);
+
+    int nRows = min(data->screenRows, pyramid->nRows[level] - scrRow);
+    int nCols = min(data->screenCols, pyramid->nCols[level] - scrCol);
+    for(int row = 0; row < nRows; row++) {
+        drawPair_t * cells = dispRow(data, row);
+        for(int col = 0; col < nCols; col++) {
+            cells[col] = getOverviewCell(pyramid, map, level, scrRow + row, scrCol + col);
+        }
+    }
+
+    return 0;
+}
+
+void setOverviewCursor(dispData_t * data, const mapPyramid_t * pyramid, int level, int x, int y) {
+    if(data == NULL || pyramid == NULL || level < 0 || level >= pyramid->nLevels) return;
+
+    int scrRow, scrCol;
+    getOverviewOrigin(data, pyramid, level, x, y, &scrRow, &scrCol);
+    move((y >> level) - scrRow, (x >> level) - scrCol);
+}
+
+int overviewToFile(const mapPyramid_t * pyramid, const map_t * map, int level, FILE* file) {
+    if(pyramid == NULL || map == NULL || file == NULL || level < 0 || level >= pyramid->nLevels) {
+        return -1;
+    }
+
+    int nCols = pyramid->nCols[level];
+    char * line = malloc(nCols + 1);
+    if(line == NULL) {
+        return -1;
+    }
+
+    int ret = 0;
+    for(int row = 0; row < pyramid->nRows[level] && ret == 0; row++) {
+        for(int col = 0; col < nCols; col++) {
+            drawPair_t pair = getOverviewCell(pyramid, map, level, row, col);
+            line[col] = (pair == kEmptyCell) ? ' ' : drawPairCh(pair);
+        }
+        line[nCols] = '\n';
+
+        if(fwrite(line, sizeof(char), nCols + 1, file) != (size_t) nCols + 1) {
+            ret = -1;
+        }
+    }
+
+    free(line);
+    return ret;
+}
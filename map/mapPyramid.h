@@ -0,0 +1,136 @@
+#ifndef _MAP_PYRAMID_H_
+#define _MAP_PYRAMID_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../common/dispBase.h"
+
+#include "tile.h"
+#include "map.h"
+
+/*
+ * A map pyramid holds zoomed out views of a map, for overviews of maps too big
+ * to see at full size. Level 0 shows each tile as a single char, and each level
+ * above it shows 2x2 cells of the level below as one (so level n shows 2^n x 2^n
+ * tiles per char). Level 0 is read straight from the map's tiles; the levels
+ * above it are kept summarized, and are updated as the map is edited.
+ */
+
+// Glyphs of overview cells
+#define kOverviewFloor  '.'
+#define kOverviewWall   '#'
+#define kOverviewDoor   '+'
+#define kOverviewSprite '*'     // Sprites other than character sprites
+
+// A summary of the tiles under a cell of the pyramid
+typedef struct mipCell_s {
+    uint32_t nTiles;            // Tiles which aren't empty
+    uint32_t nWalls;            // Tiles with walls (or doors)
+    uint32_t nDoors;            // Tiles with doors
+    uint32_t nSprites;          // Tiles with sprites
+    short palette;              // The most common floor palette
+    short spritePalette;        // Palette of the sprite shown
+    char spriteGlyph;           // Glyph of the sprite shown (the first found)
+} mipCell_t;
+
+typedef struct mapPyramid_s {
+    int nLevels;                // Number of levels (0 if none are built)
+    int * nRows, * nCols;       // Size of each level (in cells)
+    mipCell_t ** levels;        // Cells of each level above 0 (row major)
+} mapPyramid_t;
+
+//=============================<Init and Cleanup>=============================//
+/**
+ * Initializes an empty map pyramid
+ *
+ * @param pyramid The pyramid to initialize
+ */
+void initMapPyramid(mapPyramid_t * pyramid);
+
+/**
+ * (Re)builds every level of a pyramid over a map (call after loading a new map)
+ *
+ * @param pyramid The pyramid to build
+ * @param map The map to summarize
+ *
+ * @return 0 on success, <0 on failure (leaving the pyramid empty)
+ */
+int buildMapPyramid(mapPyramid_t * pyramid, const map_t * map);
+
+/**
+ * Frees all data allocated by a map pyramid
+ *
+ * @param pyramid The pyramid to free
+ */
+void rmMapPyramid(mapPyramid_t pyramid);
+
+/**
+ * Updates the cells of every level over the given tiles (call after editing
+ * them)
+ *
+ * @param pyramid The pyramid to update
+ * @param map The edited map
+ * @param x0 The left-most column of tiles edited
+ * @param y0 The upper-most row of tiles edited
+ * @param x1 The right-most column of tiles edited
+ * @param y1 The lowest row of tiles edited
+ */
+void updateMapPyramid(mapPyramid_t * pyramid, const map_t * map, int x0, int y0, int x1, int y1);
+
+//=================================<Display>==================================//
+/**
+ * Gets the char and palette a cell of the pyramid is shown with
+ *
+ * @param pyramid The pyramid to look in
+ * @param map The map the pyramid was built over
+ * @param level The level of the cell
+ * @param row The row of the cell (in the level)
+ * @param col The column of the cell (in the level)
+ *
+ * @return The cell's char and palette (kEmptyCell if it holds no tiles)
+ */
+drawPair_t getOverviewCell(const mapPyramid_t * pyramid, const map_t * map, int level, int row, int col);
+
+/**
+ * Buffers a level of the pyramid, centered on the given tile (as far as the
+ * edges of the map allow)
+ *
+ * @param data The display data struct
+ * @param pyramid The pyramid to draw from
+ * @param map The map the pyramid was built over
+ * @param level The level to draw
+ * @param x The x coordinate of the selected tile
+ * @param y The y coordinate of the selected tile
+ *
+ * @return 0 on success, <0 on failure
+ */
+int addMapOverview(dispData_t * data, const mapPyramid_t * pyramid, const map_t * map, int level,
+                    int x, int y);
+
+/**
+ * Sets cursor focus on the cell of an overview holding the given tile
+ *
+ * @param data The display data struct
+ * @param pyramid The pyramid being drawn
+ * @param level The level being drawn
+ * @param x The x coordinate of the selected tile
+ * @param y The y coordinate of the selected tile
+ */
+void setOverviewCursor(dispData_t * data, const mapPyramid_t * pyramid, int level, int x, int y);
+
+/**
+ * Writes a whole level of the pyramid out to file as plain text
+ *
+ * @param pyramid The pyramid to write from
+ * @param map The map the pyramid was built over
+ * @param level The level to write
+ * @param file The file to write out to
+ *
+ * @return 0 on success, <0 on failure
+ */
+int overviewToFile(const mapPyramid_t * pyramid, const map_t * map, int level, FILE* file);
+
+#endif
@@ -0,0 +1,371 @@
+#include "raster.h"
+
+#include <string.h>
+
+// Largest stored deflate block
+#define kMaxBlockLen 65535
+
+// First and last characters of the embedded font
+#define kFirstGlyph ' '
+#define kLastGlyph '~'
+
+// Basic 8x8 font (public domain, after the IBM PC BIOS font)
+static const uint8_t kFont[kLastGlyph - kFirstGlyph + 1][kGlyphHeight] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},   // ' '
+    {0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00},   // '!'
+    {0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},   // '"'
+    {0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00},   // '#'
+    {0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00},   // '$'
+    {0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00},   // '%'
+    {0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00},   // '&'
+    {0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00},   // '''
+    {0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00},   // '('
+    {0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00},   // ')'
+    {0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00},   // '*'
+    {0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00},   // '+'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06},   // ','
+    {0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00},   // '-'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00},   // '.'
+    {0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00},   // '/'
+    {0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00},   // '0'
+    {0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00},   // '1'
+    {0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00},   // '2'
+    {0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00},   // '3'
+    {0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00},   // '4'
+    {0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00},   // '5'
+    {0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00},   // '6'
+    {0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00},   // '7'
+    {0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00},   // '8'
+    {0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00},   // '9'
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00},   // ':'
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06},   // ';'
+    {0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00},   // '<'
+    {0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00},   // '='
+    {0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00},   // '>'
+    {0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00},   // '?'
+    {0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00},   // '@'
+    {0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00},   // 'A'
+    {0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00},   // 'B'
+    {0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00},   // 'C'
+    {0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00},   // 'D'
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00},   // 'E'
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00},   // 'F'
+    {0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00},   // 'G'
+    {0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00},   // 'H'
+    {0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00},   // 'I'
+    {0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00},   // 'J'
+    {0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00},   // 'K'
+    {0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00},   // 'L'
+    {0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00},   // 'M'
+    {0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00},   // 'N'
+    {0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00},   // 'O'
+    {0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00},   // 'P'
+    {0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00},   // 'Q'
+    {0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00},   // 'R'
+    {0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00},   // 'S'
+    {0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00},   // 'T'
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00},   // 'U'
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00},   // 'V'
+    {0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00},   // 'W'
+    {0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00},   // 'X'
+    {0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00},   // 'Y'
+    {0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00},   // 'Z'
+    {0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00},   // '['
+    {0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00},   // '\'
+    {0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00},   // ']'
+    {0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00},   // '^'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF},   // '_'
+    {0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00},   // '`'
+    {0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00},   // 'a'
+    {0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00},   // 'b'
+    {0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00},   // 'c'
+    {0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00},   // 'd'
+    {0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00},   // 'e'
+    {0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00},   // 'f'
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F},   // 'g'
+    {0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00},   // 'h'
+    {0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00},   // 'i'
+    {0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E},   // 'j'
+    {0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00},   // 'k'
+    {0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00},   // 'l'
+    {0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00},   // 'm'
+    {0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00},   // 'n'
+    {0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00},   // 'o'
+    {0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F},   // 'p'
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78},   // 'q'
+    {0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00},   // 'r'
+    {0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00},   // 's'
+    {0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00},   // 't'
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00},   // 'u'
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00},   // 'v'
+    {0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00},   // 'w'
+    {0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00},   // 'x'
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F},   // 'y'
+    {0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00},   // 'z'
+    {0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00},   // '{'
+    {0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00},   // '|'
+    {0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00},   // '}'
+    {0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}    // '~'
+};
+
+// Colours of the palettes, as the ansi display backend shows them
+#define kRGBBlack   0x000000
+#define kRGBWhite   0xE5E5E5
+#define kRGBRed     0xCD0000
+#define kRGBGreen   0x00CD00
+#define kRGBBlue    0x0000EE
+#define kRGBYellow  0xCDCD00
+#define kRGBMagenta 0xCD00CD
+#define kRGBCyan    0x00CDCD
+
+static const uint32_t kPaletteRGB[kMaxPalette + 1][2] = {
+    {kRGBWhite, kRGBBlack},     // Empty cells
+    {kRGBWhite, kRGBBlack},     // kBlackPalette
+    {kRGBBlack, kRGBWhite},     // kWhitePalette
+    {kRGBBlack, kRGBRed},       // kRedPalette
+    {kRGBBlack, kRGBGreen},     // kGreenPalette
+    {kRGBBlack, kRGBBlue},      // kBluePalette
+    {kRGBBlack, kRGBYellow},    // kYellowPalette
+    {kRGBBlack, kRGBMagenta},   // kMagentaPalette
+    {kRGBBlack, kRGBCyan}       // kCyanPalette
+};
+
+static const uint8_t kPNGSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+//==================================<Helpers>=================================//
+static void putBE32(uint8_t * buf, uint32_t val) {
+    buf[0] = val >> 24;
+    buf[1] = val >> 16;
+    buf[2] = val >> 8;
+    buf[3] = val;
+}
+
+/**
+ * Continues a PNG (zlib) CRC-32 over the given bytes
+ */
+static uint32_t crc32(uint32_t crc, const uint8_t * buf, size_t len) {
+    static uint32_t table[256];
+    static bool tableReady = false;
+
+    if(!tableReady) {
+        for(uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for(int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        tableReady = true;
+    }
+
+    crc = ~crc;
+    for(size_t i = 0; i < len; ++i) {
+        crc = table[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * Continues an Adler-32 checksum over the given bytes
+ */
+static uint32_t adler32(uint32_t adler, const uint8_t * buf, size_t len) {
+    uint32_t a = adler & 0xFFFF, b = adler >> 16;
+
+    // Sums can go 5552 bytes before they need reducing
+    while(len > 0) {
+        size_t n = (len < 5552) ? len : 5552;
+        len -= n;
+        while(n-- > 0) {
+            a += *buf++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+
+    return (b << 16) | a;
+}
+
+/**
+ * Writes out a PNG chunk, made up of the given pieces of data
+ */
+static int writeChunk(FILE* file, const char * type, const uint8_t ** parts,
+                        const size_t * lens, int nParts) {
+    size_t len = 0;
+    for(int i = 0; i < nParts; ++i) {
+        len += lens[i];
+    }
+
+    uint8_t head[8];
+    putBE32(head, len);
+    memcpy(head + 4, type, 4);
+    uint32_t crc = crc32(0, head + 4, 4);
+    if(fwrite(head, 1, 8, file) != 8) {
+        return -1;
+    }
+
+    for(int i = 0; i < nParts; ++i) {
+        crc = crc32(crc, parts[i], lens[i]);
+        if(lens[i] > 0 && fwrite(parts[i], 1, lens[i], file) != lens[i]) {
+            return -1;
+        }
+    }
+
+    uint8_t tail[4];
+    putBE32(tail, crc);
+    return (fwrite(tail, 1, 4, file) == 4) ? 0 : -1;
+}
+
+/**
+ * Writes the pending deflate block out in its own IDAT chunk (with the zlib
+ * header before the first block, and the checksum after the last)
+ */
+static int flushBlock(raster_t * raster, bool last) {
+    const uint8_t zlibHead[2] = {0x78, 0x01};
+    uint8_t blockHead[5] = {last ? 1 : 0, raster->blockLen, raster->blockLen >> 8,
+                            ~raster->blockLen, ~raster->blockLen >> 8};
+    uint8_t zlibTail[4];
+    putBE32(zlibTail, raster->adler);
+
+    const uint8_t * parts[] = {zlibHead, blockHead, raster->block, zlibTail};
+    size_t lens[] = {raster->started ? 0 : 2, 5, raster->blockLen, last ? 4 : 0};
+
+    raster->started = true;
+    raster->blockLen = 0;
+    return writeChunk(raster->file, "IDAT", parts, lens, 4);
+}
+
+/**
+ * Adds bytes to the uncompressed PNG stream
+ */
+static int addStream(raster_t * raster, const uint8_t * buf, size_t len) {
+    raster->adler = adler32(raster->adler, buf, len);
+
+    while(len > 0) {
+        size_t n = kMaxBlockLen - raster->blockLen;
+        if(n > len) n = len;
+
+        memcpy(raster->block + raster->blockLen, buf, n);
+        raster->blockLen += n;
+        buf += n;
+        len -= n;
+
+        if(raster->blockLen == kMaxBlockLen && flushBlock(raster, false) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+//================================<Rasterizing>===============================//
+uint8_t getGlyphRow(char ch, int row) {
+    if(ch < kFirstGlyph || ch > kLastGlyph || row < 0 || row >= kGlyphHeight) {
+        return 0;
+    }
+    return kFont[ch - kFirstGlyph][row];
+}
+
+void getPaletteRGB(short palette, uint32_t * fg, uint32_t * bg) {
+    if(palette < 0 || palette > kMaxPalette) palette = kDefPalette;
+
+    if(fg != NULL) *fg = kPaletteRGB[palette][0];
+    if(bg != NULL) *bg = kPaletteRGB[palette][1];
+}
+
+//================================<Image Files>===============================//
+int openRaster(raster_t * raster, FILE* file, rasterFormat_t format, int width, int height) {
+    if(raster == NULL || file == NULL || width <= 0 || height <= 0) {
+        return -1;
+    }
+
+    memset(raster, 0, sizeof(raster_t));
+    raster->file = file;
+    raster->format = format;
+    raster->width = width;
+    raster->height = height;
+    raster->rowBytes = (long) width * 3;
+
+    if(format == kRasterPPM) {
+        return (fprintf(file, "P6\n%d %d\n255\n", width, height) < 0) ? -1 : 0;
+    }
+
+    raster->adler = 1;
+    raster->block = malloc(kMaxBlockLen);
+    if(raster->block == NULL) {
+        return -1;
+    }
+
+    // 8 bit RGB, no interlacing
+    uint8_t ihdr[13] = {0, 0, 0, 0, 0, 0, 0, 0, 8, 2, 0, 0, 0};
+    putBE32(ihdr, width);
+    putBE32(ihdr + 4, height);
+
+    const uint8_t * parts[] = {ihdr};
+    size_t lens[] = {sizeof(ihdr)};
+    if(fwrite(kPNGSignature, 1, sizeof(kPNGSignature), file) != sizeof(kPNGSignature) ||
+            writeChunk(file, "IHDR", parts, lens, 1) < 0) {
+        free(raster->block);
+        raster->block = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+int writeRaster(raster_t * raster, const uint8_t * rgb, size_t len) {
+    if(raster == NULL || (rgb == NULL && len > 0)) {
+        return -1;
+    }
+
+    while(len > 0) {
+        if(raster->nRows >= raster->height) {
+            return -1;
+        }
+
+        // Each PNG scanline starts with its filter type (none)
+        const uint8_t filter = 0;
+        if(raster->format == kRasterPNG && raster->rowPos == 0 &&
+                addStream(raster, &filter, 1) < 0) {
+            return -1;
+        }
+
+        size_t n = raster->rowBytes - raster->rowPos;
+        if(n > len) n = len;
+
+        if(raster->format == kRasterPNG) {
+            if(addStream(raster, rgb, n) < 0) return -1;
+        } else if(fwrite(rgb, 1, n, raster->file) != n) {
+            return -1;
+        }
+
+        rgb += n;
+        len -= n;
+        raster->rowPos += n;
+        if(raster->rowPos == raster->rowBytes) {
+            raster->rowPos = 0;
+            raster->nRows++;
+        }
+    }
+
+    return 0;
+}
+
+int closeRaster(raster_t * raster) {
+    if(raster == NULL) {
+        return -1;
+    }
+
+    int ret = (raster->nRows == raster->height) ? 0 : -1;
+    if(raster->format == kRasterPNG) {
+        if(ret == 0 && (flushBlock(raster, true) < 0 ||
+                writeChunk(raster->file, "IEND", NULL, NULL, 0) < 0)) {
+            ret = -1;
+        }
+
+        free(raster->block);
+        raster->block = NULL;
+    }
+
+    return ret;
+}
@@ -0,0 +1,100 @@
+#ifndef _RASTER_H_
+#define _RASTER_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../common/dispBase.h"
+
+/*
+ * Raster images are streamed out a scanline at a time as 24 bit RGB, either as
+ * binary PPM or as PNG. PNGs are written with stored (uncompressed) deflate
+ * blocks, so no compression library is needed and the encoder never has to hold
+ * more than one block of the image.
+ */
+
+// Size of the embedded font's glyphs (in pixels)
+#define kGlyphWidth 8
+#define kGlyphHeight 8
+
+typedef enum rasterFormat_e {
+    kRasterPPM,
+    kRasterPNG
+} rasterFormat_t;
+
+typedef struct raster_s {
+    FILE* file;
+    rasterFormat_t format;
+    int width, height;          // Size of the image (in pixels)
+
+    long rowBytes;              // Bytes of RGB in a scanline
+    long rowPos;                // Bytes written of the current scanline
+    int nRows;                  // Scanlines completed
+
+    // PNG encoder state
+    uint32_t adler;             // Checksum of the uncompressed stream
+    uint8_t * block;            // The deflate block being filled
+    size_t blockLen;
+    bool started;               // Set once the zlib header has been written
+} raster_t;
+
+//================================<Rasterizing>===============================//
+/**
+ * Gets one row of a glyph of the embedded font (bit 0 is the left-most pixel,
+ * glyphs not in the font are blank)
+ *
+ * @param ch The character to look up
+ * @param row The row of the glyph (0 at the top)
+ * @return The row's pixels
+ */
+uint8_t getGlyphRow(char ch, int row);
+
+/**
+ * Gets the foreground and background colours of a palette, as packed RGB
+ * (palette 0 gives the colours of empty cells)
+ *
+ * @param palette The palette to look up
+ * @param fg A return pointer for the foreground colour
+ * @param bg A return pointer for the background colour
+ */
+void getPaletteRGB(short palette, uint32_t * fg, uint32_t * bg);
+
+//================================<Image Files>===============================//
+/**
+ * Starts an image file, writing out its header
+ *
+ * @param raster A return pointer for the image being written
+ * @param file The file to write to
+ * @param format The image format to write
+ * @param width The width of the image (in pixels)
+ * @param height The height of the image (in pixels)
+ *
+ * @return 0 on success, <0 on failure
+ */
+int openRaster(raster_t * raster, FILE* file, rasterFormat_t format, int width, int height);
+
+/**
+ * Writes pixels out to the image, continuing on from the last pixel written
+ * (scanlines need not be written in one go)
+ *
+ * @param raster The image being written
+ * @param rgb The pixels to write (3 bytes per pixel)
+ * @param len The number of bytes to write
+ *
+ * @return 0 on success, <0 on failure (or if it would overrun the image)
+ */
+int writeRaster(raster_t * raster, const uint8_t * rgb, size_t len);
+
+/**
+ * Finishes an image file (once every scanline is written) and frees the
+ * encoder
+ *
+ * @param raster The image being written
+ *
+ * @return 0 on success, <0 on failure (or if the image is incomplete)
+ */
+int closeRaster(raster_t * raster);
+
+#endif
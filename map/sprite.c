@@ -1,5 +1,43 @@
 #include "sprite.h"
 
+#include <ctype.h>
+
+#define kMaxLabelLen 256
+
+//===========================<Sprite Entry Storage>===========================//
+// Heap sprites (list entries) carry a reference count and their intern state
+typedef struct spriteEntry_s {
+    sprite_t sprite;                // Must stay first (entries are sprite_t *)
+
+    unsigned refs;                  // Number of lists/holders of this entry
+    int id;                         // Intern id (<0 if the entry is private)
+    unsigned long hash;             // Content hash (valid iff interned)
+    struct spriteEntry_s * next;    // Next entry in the intern bucket
+
+    // Lazy entries borrow their sprite from a shared entry loaded on first use
+    const spriteSource_t * source;  // Where to load from (NULL if not lazy)
+    void * src;                     // The object to load from
+    unsigned srcIdx;                // The index to load from src
+    struct spriteEntry_s * target;  // The loaded entry (NULL until first use)
+    bool loadFailed;                // The load was tried and failed (so isn't retried)
+} spriteEntry_t;
+
+#define kInitInternBuckets 64
+
+// The process-wide intern table
+static struct {
+    spriteEntry_t ** buckets;       // Hash buckets (chained through next)
+    unsigned nBuckets;              // Number of buckets (power of 2)
+
+    spriteEntry_t ** byId;          // Interned entries by intern id
+    unsigned nIds, capIds;          // Ids issued and id table capacity
+
+    unsigned nEntries;              // Number of live interned entries
+} internTable;
+
+static spriteEntry_t * mkEntry(sprite_t sprite);
+static void unlinkEntry(spriteEntry_t * entry);
+
 
 /**
  * Allocates data for a sprite with the specified dimensions
@@ -16,6 +54,8 @@ sprite_t mkSprite(short palette, unsigned char width, unsigned char height, unsi
     sprite.height = height;
     sprite.xOff = xOff;
     sprite.yOff = yOff;
+    sprite.name = NULL;
+    sprite.tags = NULL;
 
     sprite.data = calloc(height, sizeof(char *));
     
@@ -68,6 +108,10 @@ sprite_t mkBlankTile(short palette, unsigned char width, unsigned char height) {
  * @param sprite The sprite to free
  */
 void rmSprite(sprite_t sprite) {
+    // Free the sprite's labels
+    if(sprite.name != NULL) free(sprite.name);
+    if(sprite.tags != NULL) free(sprite.tags);
+
     // Free all character data
     if(sprite.data == NULL) return;
 
@@ -80,6 +124,89 @@ void rmSprite(sprite_t sprite) {
     free(sprite.data);
 }
 
+/**
+ * Copies a label string onto the heap (or replaces it with NULL if empty)
+ * 
+ * @param dst The label to replace
+ * @param src The string to copy in
+ * @return 0 on success, <0 on failure
+ */
+static int setLabel(char ** dst, const char * src, size_t len) {
+    char * label = NULL;
+    if(src != NULL && len > 0) {
+        label = calloc(len + 1, sizeof(char));
+        if(label == NULL) {
+            return -1;
+        }
+        memcpy(label, src, len);
+    }
+
+    if(*dst != NULL) free(*dst);
+    *dst = label;
+    return 0;
+}
+
+int setSpriteName(sprite_t * sprite, const char * name) {
+    if(sprite == NULL) return -1;
+
+    // Names are single words (anything after whitespace is dropped)
+    size_t len = 0;
+    if(name != NULL) {
+        while(isspace(*name)) ++name;
+        while(name[len] != '\0' && !isspace(name[len])) ++len;
+    }
+
+    return setLabel(&sprite->name, name, len);
+}
+
+int setSpriteTags(sprite_t * sprite, const char * tags) {
+    if(sprite == NULL) return -1;
+
+    // Trim the tag string down to the words it holds
+    size_t len = 0;
+    if(tags != NULL) {
+        while(isspace(*tags)) ++tags;
+        len = strlen(tags);
+        while(len > 0 && isspace(tags[len - 1])) --len;
+    }
+
+    return setLabel(&sprite->tags, tags, len);
+}
+
+int parseSpriteLabel(const char * line, char ** name, char ** tags) {
+    if(line == NULL || name == NULL || tags == NULL) return -1;
+
+    sprite_t label = kEmptySprite;
+    if(setSpriteName(&label, line) < 0) {
+        return -1;
+    }
+
+    // Skip over the name to get at the tags
+    while(isspace(*line)) ++line;
+    while(*line != '\0' && !isspace(*line)) ++line;
+    if(setSpriteTags(&label, line) < 0) {
+        rmSprite(label);
+        return -1;
+    }
+
+    // A name of "-" is a placeholder for unnamed (but tagged) sprites
+    if(label.name != NULL && strcmp(label.name, "-") == 0) {
+        setSpriteName(&label, NULL);
+    }
+
+    *name = label.name;
+    *tags = label.tags;
+    return 0;
+}
+
+void writeSpriteLabel(FILE* file, const char * name, const char * tags) {
+    fprintf(file, "%s", (name == NULL) ? "-" : name);
+    if(tags != NULL) {
+        fprintf(file, " %s", tags);
+    }
+    fprintf(file, "\n");
+}
+
 /**
  * Reads a sprite from file
  * 
@@ -92,16 +219,38 @@ sprite_t readSprite(FILE* file) {
     unsigned char width, height;
     unsigned char xOff, yOff;
 
+    char * name = NULL, * tags = NULL;
     int ret;
 
+    // Check for a label line ahead of the sprite
+    int next;
+    while((next = fgetc(file)) != EOF && isspace(next));
+    if(next == '$') {
+        char line[kMaxLabelLen];
+        if(fgets(line, sizeof(line), file) == NULL || 
+                parseSpriteLabel(line, &name, &tags) < 0) {
+            return kEmptySprite;
+        }
+    } else if(next != EOF) {
+        ungetc(next, file);
+    }
+
     // Get the components from the line
     ret = fscanf(file, "%hd %hhu %hhu %hhu %hhu |", &palette, &width, &height, &xOff, &yOff);
     if(ret != 5) {
+        if(name != NULL) free(name);
+        if(tags != NULL) free(tags);
         return kEmptySprite;
     }
 
     // Create the basic struct
     sprite_t sprite = mkSprite(palette, width, height, xOff, yOff);
+    sprite.name = name;
+    sprite.tags = tags;
+    if(sprite.data == NULL) {
+        rmSprite(sprite);
+        return kEmptySprite;
+    }
 
     //Read in the data from file
     for(int row = 0; row < sprite.height; row++) {
@@ -149,6 +298,11 @@ sprite_t readSprite(FILE* file) {
 int writeSprite(FILE* file, sprite_t sprite) {
     if(file == NULL || sprite.data == NULL) return -1;
 
+    if(sprite.name != NULL || sprite.tags != NULL) {
+        fprintf(file, "$");
+        writeSpriteLabel(file, sprite.name, sprite.tags);
+    }
+
     fprintf(file, "%hd %hhu %hhu %hhu %hhu |", sprite.defPalette, sprite.width,
                 sprite.height, sprite.xOff, sprite.yOff);
     
@@ -183,8 +337,8 @@ int loadSpriteList(FILE* file, list_t * list) {
     // While valid sprites are being returned from the file...
     while((sprite = readSprite(file)).data != NULL) {
         ret = -1;
-        // Turn the sprite into an entry
-        entry = mkSpriteEntry(sprite);
+        // Turn the sprite into a (shared) entry
+        entry = internSprite(sprite);
         if(entry == NULL) {
             break;
         }
@@ -213,7 +367,7 @@ int saveSpriteList(FILE* file, list_t list) {
     int len = listLen(list), ret = 0, nWritten = 0;
 
     for(int i = 0; i < len; ++i) {
-        sprite_t * entry = listGet(list, i);
+        sprite_t * entry = getListSprite(list, i);
         if(entry == NULL) {
             continue;
         }
@@ -228,18 +382,332 @@ int saveSpriteList(FILE* file, list_t list) {
 }
 
 sprite_t * mkSpriteEntry(sprite_t sprite) {
-    sprite_t * ptr = calloc(1, sizeof(sprite_t));
-    if(ptr == NULL) {
+    spriteEntry_t * entry = mkEntry(sprite);
+    if(entry == NULL) {
         return NULL;
     }
-    *ptr = sprite;
-    return ptr;
+    return &entry->sprite;
 }
 
 void freeSpriteEntry(void * entry) {
     if(entry == NULL) {
         return;
     }
-    rmSprite(*(sprite_t *) entry);
-    free(entry);
-}
\ No newline at end of file
+
+    spriteEntry_t * ent = entry;
+    if(ent->refs > 1) {
+        ent->refs -= 1;
+        return;
+    }
+
+    // Lazy entries only hold references to their source and loaded sprite
+    if(ent->source != NULL) {
+        freeSpriteEntry(ent->target);
+        if(ent->source->release != NULL) {
+            ent->source->release(ent->src);
+        }
+        free(ent);
+        return;
+    }
+
+    unlinkEntry(ent);
+    rmSprite(ent->sprite);
+    free(ent);
+}
+
+sprite_t * mkLazySpriteEntry(const spriteSource_t * source, void * src, unsigned idx) {
+    if(source == NULL || source->load == NULL) {
+        return NULL;
+    }
+
+    spriteEntry_t * entry = mkEntry(kEmptySprite);
+    if(entry == NULL) {
+        return NULL;
+    }
+
+    entry->source = source;
+    entry->src = src;
+    entry->srcIdx = idx;
+    return &entry->sprite;
+}
+
+sprite_t * resolveSpriteEntry(sprite_t * entry) {
+    if(entry == NULL) {
+        return NULL;
+    }
+
+    spriteEntry_t * ent = (spriteEntry_t *) entry;
+    if(ent->source == NULL || ent->target != NULL) {
+        return entry;
+    } else if(ent->loadFailed) {
+        return NULL;
+    }
+
+    sprite_t * target = ent->source->load(ent->src, ent->srcIdx);
+    if(target == NULL) {
+        ent->loadFailed = true;
+        return NULL;
+    }
+
+    ent->target = (spriteEntry_t *) target;
+    ent->sprite = *target;      // Borrow the loaded sprite's data
+    return entry;
+}
+
+const spriteSource_t * getSpriteEntrySource(const sprite_t * entry, void ** src, unsigned * idx) {
+    if(entry == NULL) {
+        return NULL;
+    }
+
+    const spriteEntry_t * ent = (const spriteEntry_t *) entry;
+    if(src != NULL) *src = ent->src;
+    if(idx != NULL) *idx = ent->srcIdx;
+    return ent->source;
+}
+
+sprite_t * getListSprite(list_t list, unsigned idx) {
+    sprite_t * entry = resolveSpriteEntry(listGet(list, idx));
+    if(entry == NULL || entry->data == NULL) {
+        return NULL;
+    }
+    return entry;
+}
+
+//=============================<Sprite Interning>=============================//
+static spriteEntry_t * mkEntry(sprite_t sprite) {
+    spriteEntry_t * entry = calloc(1, sizeof(spriteEntry_t));
+    if(entry == NULL) {
+        return NULL;
+    }
+
+    entry->sprite = sprite;
+    entry->refs = 1;
+    entry->id = -1;
+    return entry;
+}
+
+/**
+ * Removes an entry from the intern table (if it is interned)
+ * 
+ * @param entry The entry to remove
+ */
+static void unlinkEntry(spriteEntry_t * entry) {
+    if(entry->id < 0) {
+        return;
+    }
+
+    spriteEntry_t ** link = &internTable.buckets[entry->hash & (internTable.nBuckets - 1)];
+    while(*link != NULL && *link != entry) {
+        link = &(*link)->next;
+    }
+    if(*link != NULL) {
+        *link = entry->next;
+    }
+
+    internTable.byId[entry->id] = NULL;
+    internTable.nEntries -= 1;
+
+    entry->id = -1;
+    entry->next = NULL;
+}
+
+/**
+ * Doubles the number of intern buckets and rehashes all interned entries
+ * 
+ * @return 0 on success, <0 on failure
+ */
+static int growBuckets() {
+    unsigned nBuckets = (internTable.nBuckets == 0) ? kInitInternBuckets : 
+                            internTable.nBuckets * 2;
+    spriteEntry_t ** buckets = calloc(nBuckets, sizeof(spriteEntry_t *));
+    if(buckets == NULL) {
+        return -1;
+    }
+
+    for(unsigned i = 0; i < internTable.nBuckets; ++i) {
+        spriteEntry_t * entry = internTable.buckets[i];
+        while(entry != NULL) {
+            spriteEntry_t * next = entry->next;
+            entry->next = buckets[entry->hash & (nBuckets - 1)];
+            buckets[entry->hash & (nBuckets - 1)] = entry;
+            entry = next;
+        }
+    }
+
+    free(internTable.buckets);
+    internTable.buckets = buckets;
+    internTable.nBuckets = nBuckets;
+    return 0;
+}
+
+unsigned long hashSprite(sprite_t sprite) {
+    // 64 bit FNV-1a over the header fields and then the character data
+    unsigned long hash = 14695981039346656037UL;
+#define hashByte(b) hash = (hash ^ (unsigned char) (b)) * 1099511628211UL
+
+    hashByte(sprite.defPalette);
+    hashByte(sprite.defPalette >> 8);
+    hashByte(sprite.width);
+    hashByte(sprite.height);
+    hashByte(sprite.xOff);
+    hashByte(sprite.yOff);
+
+    for(int row = 0; sprite.data != NULL && row < sprite.height; ++row) {
+        for(int col = 0; col < sprite.width; ++col) {
+            hashByte(sprite.data[row][col]);
+        }
+    }
+
+    // Labels are separated from the data (and each other) by a null byte
+    for(const char * ch = sprite.name; ch != NULL && *ch; ++ch) hashByte(*ch);
+    hashByte(0);
+    for(const char * ch = sprite.tags; ch != NULL && *ch; ++ch) hashByte(*ch);
+
+#undef hashByte
+    return hash;
+}
+
+bool spritesEqual(sprite_t a, sprite_t b) {
+    if(a.defPalette != b.defPalette || a.width != b.width || 
+            a.height != b.height || a.xOff != b.xOff || a.yOff != b.yOff) {
+        return false;
+    }
+
+    if((a.name == NULL) != (b.name == NULL) || (a.tags == NULL) != (b.tags == NULL) ||
+            (a.name != NULL && strcmp(a.name, b.name) != 0) || 
+            (a.tags != NULL && strcmp(a.tags, b.tags) != 0)) {
+        return false;
+    }
+
+    if(a.data == NULL || b.data == NULL) {
+        return a.data == b.data;
+    }
+
+    for(int row = 0; row < a.height; ++row) {
+        if(memcmp(a.data[row], b.data[row], a.width) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+sprite_t * internSprite(sprite_t sprite) {
+    if(sprite.data == NULL) {
+        return NULL;
+    }
+
+    // Look for an existing copy of this sprite
+    unsigned long hash = hashSprite(sprite);
+    if(internTable.nBuckets != 0) {
+        spriteEntry_t * entry = internTable.buckets[hash & (internTable.nBuckets - 1)];
+        for(; entry != NULL; entry = entry->next) {
+            if(entry->hash == hash && spritesEqual(entry->sprite, sprite)) {
+                rmSprite(sprite);
+                entry->refs += 1;
+                return &entry->sprite;
+            }
+        }
+    }
+
+    // Make room in the table for a new entry
+    if(internTable.nEntries >= internTable.nBuckets && growBuckets() < 0) {
+        rmSprite(sprite);
+        return NULL;
+    }
+
+    if(internTable.nIds >= internTable.capIds) {
+        unsigned capIds = (internTable.capIds == 0) ? kInitInternBuckets : 
+                            internTable.capIds * 2;
+        spriteEntry_t ** byId = realloc(internTable.byId, capIds * sizeof(spriteEntry_t *));
+        if(byId == NULL) {
+            rmSprite(sprite);
+            return NULL;
+        }
+        internTable.byId = byId;
+        internTable.capIds = capIds;
+    }
+
+    // Create the new entry and link it into the table
+    spriteEntry_t * entry = mkEntry(sprite);
+    if(entry == NULL) {
+        rmSprite(sprite);
+        return NULL;
+    }
+
+    entry->hash = hash;
+    entry->id = internTable.nIds++;
+    entry->next = internTable.buckets[hash & (internTable.nBuckets - 1)];
+    internTable.buckets[hash & (internTable.nBuckets - 1)] = entry;
+    internTable.byId[entry->id] = entry;
+    internTable.nEntries += 1;
+
+    return &entry->sprite;
+}
+
+sprite_t * retainSpriteEntry(sprite_t * entry) {
+    if(entry != NULL) {
+        ((spriteEntry_t *) entry)->refs += 1;
+    }
+    return entry;
+}
+
+int getSpriteId(const sprite_t * entry) {
+    if(entry == NULL) {
+        return -1;
+    }
+
+    const spriteEntry_t * ent = (const spriteEntry_t *) entry;
+    if(ent->source != NULL) {
+        return (ent->target == NULL) ? -1 : ent->target->id;
+    }
+    return ent->id;
+}
+
+sprite_t * getInternedSprite(int id) {
+    if(id < 0 || (unsigned) id >= internTable.nIds || internTable.byId[id] == NULL) {
+        return NULL;
+    }
+    return &internTable.byId[id]->sprite;
+}
+
+sprite_t * unshareSpriteEntry(list_t list, unsigned idx) {
+    spriteEntry_t * entry = (spriteEntry_t *) getListSprite(list, idx);
+    if(entry == NULL) {
+        return NULL;
+    }
+
+    // A sole owner can simply take the entry back out of the table
+    if(entry->refs == 1 && entry->source == NULL) {
+        unlinkEntry(entry);
+        return &entry->sprite;
+    }
+
+    // Otherwise, copy the shared sprite into a private entry
+    sprite_t src = entry->sprite;
+    sprite_t copy = mkSprite(src.defPalette, src.width, src.height, src.xOff, src.yOff);
+    if(copy.data == NULL) {
+        return NULL;
+    }
+    for(int row = 0; row < src.height; ++row) {
+        memcpy(copy.data[row], src.data[row], src.width);
+    }
+    if(setSpriteName(&copy, src.name) < 0 || setSpriteTags(&copy, src.tags) < 0) {
+        rmSprite(copy);
+        return NULL;
+    }
+
+    sprite_t * priv = mkSpriteEntry(copy);
+    if(priv == NULL) {
+        rmSprite(copy);
+        return NULL;
+    }
+
+    listPut(list, idx, priv);
+    freeSpriteEntry(entry);
+    return priv;
+}
+
+unsigned nInternedSprites() {
+    return internTable.nEntries;
+}
@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdbool.h>
 
 #include "../common/dispBase.h"
 #include "../common/list.h"
@@ -14,9 +15,17 @@ typedef struct sprite_s {
     char xOff, yOff;                // X and Y offsets from top left of tile
     char** data;                    // The actual characters to display as text
 
+    char * name;                    // The sprite's name (NULL if unnamed)
+    char * tags;                    // Space separated tags (NULL if untagged)
 } sprite_t;
 
-#define kEmptySprite (sprite_t) {0, 0, 0, 0, 0, NULL}
+#define kEmptySprite (sprite_t) {0, 0, 0, 0, 0, NULL, NULL, NULL}
+
+// Describes where lazily loaded sprite entries get their sprites from
+typedef struct spriteSource_s {
+    sprite_t * (*load)(void * src, unsigned idx);   // Returns a new reference
+    void (*release)(void * src);                    // Drops a reference to src
+} spriteSource_t;
 
 /**
  * Allocates data for a sprite with the specified dimensions
@@ -51,7 +60,49 @@ sprite_t mkBlankTile(short palette, unsigned char width, unsigned char height);
 void rmSprite(sprite_t sprite);
 
 /**
- * Reads a sprite from file
+ * Sets the name of a sprite (replacing any existing name)
+ * 
+ * @param sprite The sprite to name
+ * @param name The new name (NULL or empty to remove the name)
+ * 
+ * @return 0 on success, <0 on failure
+ */
+int setSpriteName(sprite_t * sprite, const char * name);
+
+/**
+ * Sets the tags of a sprite (replacing any existing tags)
+ * 
+ * @param sprite The sprite to tag
+ * @param tags The new space separated tags (NULL or empty to remove all tags)
+ * 
+ * @return 0 on success, <0 on failure
+ */
+int setSpriteTags(sprite_t * sprite, const char * tags);
+
+/**
+ * Parses a sprite label line ("<name> <tags...>", with a name of "-" for 
+ * unnamed sprites) into a newly allocated name and tag string
+ * 
+ * @param line The label line to parse
+ * @param name A return pointer for the name (NULL if unnamed)
+ * @param tags A return pointer for the tags (NULL if untagged)
+ * 
+ * @return 0 on success, <0 on failure
+ */
+int parseSpriteLabel(const char * line, char ** name, char ** tags);
+
+/**
+ * Writes a sprite label line (the inverse of parseSpriteLabel)
+ * 
+ * @param file The file to write to
+ * @param name The name to write (may be NULL)
+ * @param tags The tags to write (may be NULL)
+ */
+void writeSpriteLabel(FILE* file, const char * name, const char * tags);
+
+/**
+ * Reads a sprite from file (along with its "$<name> <tags...>" label line if 
+ * one precedes the sprite)
  * 
  * @param file The file to read from
  * 
@@ -60,7 +111,8 @@ void rmSprite(sprite_t sprite);
 sprite_t readSprite(FILE* file);
 
 /**
- * Writes a sprite out to the file
+ * Writes a sprite out to the file (preceded by a label line if it is named or 
+ * tagged)
  * 
  * @param file The file to write to
  * @param sprite The sprite to write out
@@ -71,6 +123,7 @@ int writeSprite(FILE* file, sprite_t sprite);
 
 /**
  * Loads all sprites from the provided file and appends them to the provided list
+ * (sprites are interned, so identical sprites share a single copy)
  * 
  * @param file The file to load sprites from
  * @param list The sprite list to load into
@@ -98,10 +151,119 @@ int saveSpriteList(FILE* file, list_t list);
 sprite_t * mkSpriteEntry(sprite_t sprite);
 
 /**
- * Free function for sprite list entries
+ * Free function for sprite list entries (drops one reference to shared entries)
  * 
  * @param entry The sprite list entry to free
  */
 void freeSpriteEntry(void * entry);
 
+/**
+ * Makes a list entry which loads its sprite from the source on first use. The 
+ * entry takes over the caller's reference to src
+ * 
+ * @param source The functions used to load from (and release) src
+ * @param src The object to load the sprite from
+ * @param idx The index of the sprite within src
+ * @return The new (unloaded) entry
+ */
+sprite_t * mkLazySpriteEntry(const spriteSource_t * source, void * src, unsigned idx);
+
+/**
+ * Loads the sprite behind a lazy entry (a no-op for loaded entries). A failed
+ * load is remembered and never retried, so once every entry in use has been 
+ * resolved, resolving them again is read-only (and safe across threads)
+ * 
+ * @param entry The entry to load
+ * @return The entry with its sprite data loaded (NULL on failure)
+ */
+sprite_t * resolveSpriteEntry(sprite_t * entry);
+
+/**
+ * Gets the source a lazy entry loads from
+ * 
+ * @param entry The entry to check
+ * @param src A return pointer for the source object (may be NULL)
+ * @param idx A return pointer for the index in the source (may be NULL)
+ * @return The entry's source functions (NULL if it is not a lazy entry)
+ */
+const spriteSource_t * getSpriteEntrySource(const sprite_t * entry, void ** src, unsigned * idx);
+
+/**
+ * Gets a sprite from a sprite list, loading it first if needed
+ * 
+ * @param list The sprite list to read from
+ * @param idx The index of the sprite in the list
+ * @return The loaded sprite (NULL on invalid index or failure to load)
+ */
+sprite_t * getListSprite(list_t list, unsigned idx);
+
+//=============================<Sprite Interning>=============================//
+/**
+ * Hashes a sprite's palette, dimensions, offsets, character data and labels
+ * 
+ * @param sprite The sprite to hash
+ * @return The content hash of the sprite
+ */
+unsigned long hashSprite(sprite_t sprite);
+
+/**
+ * Checks two sprites for identical palette, dimensions, offsets, data and labels
+ * 
+ * @param a The first sprite to compare
+ * @param b The second sprite to compare
+ * @return true iff the sprites have identical contents
+ */
+bool spritesEqual(sprite_t a, sprite_t b);
+
+/**
+ * Interns a sprite, returning the shared entry for its contents. The sprite 
+ * passed in is owned by the intern table afterwards (and freed if it is a 
+ * duplicate of an already interned sprite, or if interning it fails)
+ * 
+ * @param sprite The sprite to intern
+ * @return A new reference to the shared entry (NULL on failure)
+ */
+sprite_t * internSprite(sprite_t sprite);
+
+/**
+ * Adds a reference to a sprite entry (for sharing it between lists)
+ * 
+ * @param entry The entry to reference
+ * @return The entry passed in
+ */
+sprite_t * retainSpriteEntry(sprite_t * entry);
+
+/**
+ * Returns the intern id of a sprite entry
+ * 
+ * @param entry The entry to check
+ * @return The entry's intern id (<0 if it is not interned)
+ */
+int getSpriteId(const sprite_t * entry);
+
+/**
+ * Looks up an interned sprite by its intern id
+ * 
+ * @param id The intern id to look up
+ * @return The interned entry (NULL if there is none)
+ */
+sprite_t * getInternedSprite(int id);
+
+/**
+ * Replaces the list entry at idx with a private copy that is safe to modify in 
+ * place (a no-op for entries which are already private)
+ * 
+ * @param list The list holding the entry
+ * @param idx The index of the entry in the list
+ * @return The private entry now stored at idx (NULL on failure)
+ */
+sprite_t * unshareSpriteEntry(list_t list, unsigned idx);
+
+/**
+ * Returns the number of unique sprites currently interned
+ * 
+ * @return The number of interned sprites
+ */
+unsigned nInternedSprites();
+
 #endif
\ No newline at end of file
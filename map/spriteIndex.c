@@ -0,0 +1,291 @@
+#include "spriteIndex.h"
+
+#include <string.h>
+#include <ctype.h>
+
+#include "spriteLib.h"
+
+#define kInitIndexCap 16
+
+//==================================<Helpers>=================================//
+/**
+ * Hashes a string (or the first len characters of it) with 64 bit FNV-1a
+ */
+static unsigned long hashStr(const char * str, size_t len) {
+    unsigned long hash = 14695981039346656037UL;
+    for(size_t i = 0; i < len && str[i]; ++i) {
+        hash = (hash ^ (unsigned char) str[i]) * 1099511628211UL;
+    }
+    return hash;
+}
+
+static char * copyStr(const char * str, size_t len) {
+    char * copy = calloc(len + 1, sizeof(char));
+    if(copy != NULL) {
+        memcpy(copy, str, len);
+    }
+    return copy;
+}
+
+/**
+ * Finds the name slot holding (or that would hold) the name
+ */
+static unsigned findNameSlot(const spriteIndex_t * index, const char * name) {
+    unsigned mask = index->nNameSlots - 1;
+    unsigned slot = hashStr(name, strlen(name)) & mask;
+    while(index->nameSlots[slot] >= 0 &&
+            strcmp(index->names[index->nameSlots[slot]], name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/**
+ * Finds the tag slot holding (or that would hold) the first len chars of tag
+ */
+static unsigned findTagSlot(const tagPosting_t * slots, unsigned nSlots, const char * tag, size_t len) {
+    unsigned mask = nSlots - 1;
+    unsigned slot = hashStr(tag, len) & mask;
+    while(slots[slot].tag != NULL && (strncmp(slots[slot].tag, tag, len) != 0 ||
+            slots[slot].tag[len] != '\0')) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/**
+ * Doubles the size of the name hash table (keeping it at most half full)
+ */
+static int growNameSlots(spriteIndex_t * index) {
+    unsigned nSlots = (index->nNameSlots == 0) ? kInitIndexCap * 2 : index->nNameSlots * 2;
+    int * slots = malloc(nSlots * sizeof(int));
+    if(slots == NULL) {
+        return -1;
+    }
+    for(unsigned i = 0; i < nSlots; ++i) {
+        slots[i] = -1;
+    }
+
+    int * oldSlots = index->nameSlots;
+    unsigned nOldSlots = index->nNameSlots;
+    index->nameSlots = slots;
+    index->nNameSlots = nSlots;
+
+    for(unsigned i = 0; i < nOldSlots; ++i) {
+        if(oldSlots[i] >= 0) {
+            slots[findNameSlot(index, index->names[oldSlots[i]])] = oldSlots[i];
+        }
+    }
+
+    free(oldSlots);
+    return 0;
+}
+
+/**
+ * Doubles the size of the tag hash table (keeping it at most half full)
+ */
+static int growTagSlots(spriteIndex_t * index) {
+    unsigned nSlots = (index->nTagSlots == 0) ? kInitIndexCap : index->nTagSlots * 2;
+    tagPosting_t * slots = calloc(nSlots, sizeof(tagPosting_t));
+    if(slots == NULL) {
+        return -1;
+    }
+
+    for(unsigned i = 0; i < index->nTagSlots; ++i) {
+        tagPosting_t * posting = &index->tagSlots[i];
+        if(posting->tag != NULL) {
+            slots[findTagSlot(slots, nSlots, posting->tag, strlen(posting->tag))] = *posting;
+        }
+    }
+
+    free(index->tagSlots);
+    index->tagSlots = slots;
+    index->nTagSlots = nSlots;
+    return 0;
+}
+
+/**
+ * Adds a sprite to the posting list of one tag
+ */
+static int postTag(spriteIndex_t * index, const char * tag, size_t len, unsigned idx) {
+    if(2 * (index->nTags + 1) > index->nTagSlots && growTagSlots(index) < 0) {
+        return -1;
+    }
+
+    tagPosting_t * posting = &index->tagSlots[findTagSlot(index->tagSlots,
+                                index->nTagSlots, tag, len)];
+    if(posting->tag == NULL) {
+        posting->tag = copyStr(tag, len);
+        if(posting->tag == NULL) {
+            return -1;
+        }
+        index->nTags += 1;
+    }
+
+    // Sprites are added in order, so only a repeated tag can duplicate the last
+    if(posting->nSprites > 0 && posting->sprites[posting->nSprites - 1] == idx) {
+        return 0;
+    }
+
+    if(posting->nSprites >= posting->cap) {
+        unsigned cap = (posting->cap == 0) ? 4 : posting->cap * 2;
+        unsigned * sprites = realloc(posting->sprites, cap * sizeof(unsigned));
+        if(sprites == NULL) {
+            return -1;
+        }
+        posting->sprites = sprites;
+        posting->cap = cap;
+    }
+
+    posting->sprites[posting->nSprites++] = idx;
+    return 0;
+}
+
+//=============================<Index Management>=============================//
+void initSpriteIndex(spriteIndex_t * index) {
+    if(index == NULL) return;
+
+    memset(index, 0, sizeof(spriteIndex_t));
+}
+
+void rmSpriteIndex(spriteIndex_t index) {
+    for(unsigned i = 0; i < index.nSprites; ++i) {
+        if(index.names[i] != NULL) free(index.names[i]);
+        if(index.tags[i] != NULL) free(index.tags[i]);
+    }
+    if(index.sprites != NULL) free(index.sprites);
+    if(index.names != NULL) free(index.names);
+    if(index.tags != NULL) free(index.tags);
+    if(index.nameSlots != NULL) free(index.nameSlots);
+
+    for(unsigned i = 0; i < index.nTagSlots; ++i) {
+        if(index.tagSlots[i].tag != NULL) {
+            free(index.tagSlots[i].tag);
+            free(index.tagSlots[i].sprites);
+        }
+    }
+    if(index.tagSlots != NULL) free(index.tagSlots);
+}
+
+int buildSpriteIndex(spriteIndex_t * index, list_t list) {
+    if(index == NULL) return -1;
+
+    rmSpriteIndex(*index);
+    initSpriteIndex(index);
+    index->list = list;
+
+    unsigned len = listLen(list);
+    if(len == 0) {
+        return 0;
+    }
+
+    sprite_t ** entries = calloc(len, sizeof(sprite_t *));
+    if(entries == NULL) {
+        return -1;
+    }
+    listCopyOut(list, (void **) entries);
+
+    int ret = 0;
+    for(unsigned i = 0; i < len && ret >= 0; ++i) {
+        // Unloaded library sprites take their labels from the library itself
+        void * src;
+        unsigned srcIdx;
+        const char * name = entries[i]->name, * tags = entries[i]->tags;
+        if(entries[i]->data == NULL &&
+                getSpriteEntrySource(entries[i], &src, &srcIdx) == &kLibSpriteSource) {
+            getLibSpriteLabel(src, srcIdx, &name, &tags);
+        }
+
+        ret = addIndexedSprite(index, entries[i], name, tags);
+    }
+
+    free(entries);
+    return (ret < 0) ? -1 : 0;
+}
+
+int addIndexedSprite(spriteIndex_t * index, sprite_t * entry, const char * name, const char * tags) {
+    if(index == NULL) return -1;
+
+    // Make room for the sprite
+    if(index->nSprites >= index->cap) {
+        unsigned cap = (index->cap == 0) ? kInitIndexCap : index->cap * 2;
+        sprite_t ** sprites = realloc(index->sprites, cap * sizeof(sprite_t *));
+        if(sprites == NULL) return -1;
+        index->sprites = sprites;
+
+        char ** names = realloc(index->names, cap * sizeof(char *));
+        if(names == NULL) return -1;
+        index->names = names;
+
+        char ** tagStrs = realloc(index->tags, cap * sizeof(char *));
+        if(tagStrs == NULL) return -1;
+        index->tags = tagStrs;
+
+        index->cap = cap;
+    }
+    if(2 * (index->nSprites + 1) > index->nNameSlots && growNameSlots(index) < 0) {
+        return -1;
+    }
+
+    unsigned idx = index->nSprites;
+    index->sprites[idx] = entry;
+    index->names[idx] = (name == NULL) ? NULL : copyStr(name, strlen(name));
+    index->tags[idx] = (tags == NULL) ? NULL : copyStr(tags, strlen(tags));
+    index->nSprites += 1;
+
+    // Index the name (keeping the first sprite to claim it)
+    if(index->names[idx] != NULL) {
+        unsigned slot = findNameSlot(index, index->names[idx]);
+        if(index->nameSlots[slot] < 0) {
+            index->nameSlots[slot] = idx;
+        }
+    }
+
+    // Post the sprite under each of its tags
+    for(const char * tag = tags; tag != NULL && *tag; ) {
+        while(isspace(*tag)) ++tag;
+
+        size_t len = 0;
+        while(tag[len] != '\0' && !isspace(tag[len])) ++len;
+        if(len > 0 && postTag(index, tag, len, idx) < 0) {
+            return -1;
+        }
+        tag += len;
+    }
+
+    return idx;
+}
+
+//===============================<Index Lookup>===============================//
+sprite_t * getIndexedSprite(const spriteIndex_t * index, unsigned idx) {
+    if(index == NULL || idx >= index->nSprites) {
+        return NULL;
+    }
+
+    sprite_t * entry = resolveSpriteEntry(index->sprites[idx]);
+    if(entry == NULL || entry->data == NULL) {
+        return NULL;
+    }
+    return entry;
+}
+
+int findSpriteByName(const spriteIndex_t * index, const char * name) {
+    if(index == NULL || name == NULL || index->nNameSlots == 0) {
+        return -1;
+    }
+
+    return index->nameSlots[findNameSlot(index, name)];
+}
+
+unsigned findSpritesByTag(const spriteIndex_t * index, const char * tag, const unsigned ** sprites) {
+    if(index == NULL || tag == NULL || index->nTagSlots == 0) {
+        return 0;
+    }
+
+    const tagPosting_t * posting = &index->tagSlots[findTagSlot(index->tagSlots,
+                                        index->nTagSlots, tag, strlen(tag))];
+    if(sprites != NULL) {
+        *sprites = posting->sprites;
+    }
+    return (posting->tag == NULL) ? 0 : posting->nSprites;
+}
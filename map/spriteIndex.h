@@ -0,0 +1,103 @@
+#ifndef _SPRITE_INDEX_H_
+#define _SPRITE_INDEX_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "sprite.h"
+#include "../common/list.h"
+
+// The sprites carrying a single tag
+typedef struct tagPosting_s {
+    char * tag;                 // The tag (NULL for an empty slot)
+    unsigned nSprites, cap;     // Number of tagged sprites and array capacity
+    unsigned * sprites;         // Indices of the tagged sprites (ascending)
+} tagPosting_t;
+
+typedef struct spriteIndex_s {
+    list_t list;                // The list this index was built from (if any)
+
+    unsigned nSprites, cap;     // Number of indexed sprites and capacity
+    sprite_t ** sprites;        // Indexed entries (NULL where only labels known)
+    char ** names;              // Sprite names (NULL where unnamed)
+    char ** tags;               // Sprite tag strings (NULL where untagged)
+
+    unsigned nNameSlots;        // Size of the name hash table (power of 2)
+    int * nameSlots;            // Sprite index in each name slot (<0 if empty)
+
+    unsigned nTags, nTagSlots;  // Distinct tags and size of the tag table
+    tagPosting_t * tagSlots;    // Tag posting lists (hashed by tag)
+} spriteIndex_t;
+
+//=============================<Index Management>=============================//
+/**
+ * Initializes an empty sprite index
+ *
+ * @param index The index to initialize
+ */
+void initSpriteIndex(spriteIndex_t * index);
+
+/**
+ * Frees all data allocated by a sprite index
+ *
+ * @param index The index to free
+ */
+void rmSpriteIndex(spriteIndex_t index);
+
+/**
+ * Rebuilds an index over every sprite in a list (library sprites that have not
+ * been loaded are indexed by the labels stored in their library)
+ *
+ * @param index The index to rebuild
+ * @param list The sprite list to index
+ *
+ * @return 0 on success, <0 on failure
+ */
+int buildSpriteIndex(spriteIndex_t * index, list_t list);
+
+/**
+ * Adds a sprite to the end of the index
+ *
+ * @param index The index to add to
+ * @param entry The sprite entry (may be NULL if only its labels are known)
+ * @param name The sprite's name (may be NULL)
+ * @param tags The sprite's space separated tags (may be NULL)
+ *
+ * @return The index of the new sprite (<0 on failure)
+ */
+int addIndexedSprite(spriteIndex_t * index, sprite_t * entry, const char * name, const char * tags);
+
+//===============================<Index Lookup>===============================//
+/**
+ * Gets an indexed sprite (in constant time), loading it first if needed
+ *
+ * @param index The index to read from
+ * @param idx The index of the sprite
+ *
+ * @return The loaded sprite (NULL on invalid index or failure to load)
+ */
+sprite_t * getIndexedSprite(const spriteIndex_t * index, unsigned idx);
+
+/**
+ * Finds a sprite by name
+ *
+ * @param index The index to search
+ * @param name The name to look up
+ *
+ * @return The index of the first sprite with that name (<0 if there is none)
+ */
+int findSpriteByName(const spriteIndex_t * index, const char * name);
+
+/**
+ * Finds all sprites carrying a tag
+ *
+ * @param index The index to search
+ * @param tag The tag to look up
+ * @param sprites A return pointer for the (ascending) indices of the sprites
+ *
+ * @return The number of sprites carrying the tag
+ */
+unsigned findSpritesByTag(const spriteIndex_t * index, const char * tag, const unsigned ** sprites);
+
+#endif
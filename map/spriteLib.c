@@ -0,0 +1,331 @@
+#include "spriteLib.h"
+
+#include <string.h>
+
+#define kLibMagic "SPRLIB"
+#define kLibIndexWidth 11       // Width of an index line (10 digits + newline)
+#define kMaxLabelLen 256
+
+struct spriteLib_s {
+    char * path;                // The path the library was opened from
+    FILE * fp;                  // The open library file
+    unsigned refs;              // Number of holders of this library
+
+    unsigned long hash;         // Content hash from the header
+    unsigned nSprites;          // Number of sprites in the library
+    long indexStart;            // File offset of the first index line
+    long labelStart;            // File offset of the label section
+
+    sprite_t ** loaded;         // Sprites loaded so far (NULL until first use)
+
+    bool indexed;               // Set once the label section has been read
+    spriteIndex_t index;        // Name and tag index over the library
+
+    struct spriteLib_s * next;  // Next open library
+};
+
+// All currently open libraries (so maps sharing a library share its sprites)
+static spriteLib_t openLibs = NULL;
+
+static sprite_t * libSourceLoad(void * src, unsigned idx) {
+    return loadLibSprite(src, idx);
+}
+
+static void libSourceRelease(void * src) {
+    closeSpriteLib(src);
+}
+
+const spriteSource_t kLibSpriteSource = {libSourceLoad, libSourceRelease};
+
+//==============================<Library Files>===============================//
+/**
+ * Writes the library header and index (offsets may be NULL for placeholders)
+ */
+static void writeLibHeader(FILE* file, unsigned long hash, unsigned n, long labelStart, 
+                            long * offsets) {
+    fprintf(file, "%s %016lx %010u %010ld\n", kLibMagic, hash, n, labelStart);
+    for(unsigned i = 0; i < n; ++i) {
+        fprintf(file, "%010ld\n", (offsets == NULL) ? 0 : offsets[i]);
+    }
+}
+
+int writeSpriteLib(FILE* file, list_t list) {
+    if(file == NULL || list == NULL) {
+        return -1;
+    }
+
+    unsigned len = listLen(list);
+    long * offsets = calloc(len + 1, sizeof(long));
+    if(offsets == NULL) {
+        return -1;
+    }
+
+    // Reserve space for the header and index, then write out the records
+    long start = ftell(file);
+    writeLibHeader(file, 0, len, 0, NULL);
+
+    sprite_t ** entries = calloc(len + 1, sizeof(sprite_t *));
+    if(entries == NULL) {
+        free(offsets);
+        return -1;
+    }
+    listCopyOut(list, (void **) entries);
+
+    unsigned long hash = 14695981039346656037UL;
+    unsigned nWritten = 0;
+    for(unsigned i = 0; i < len; ++i) {
+        sprite_t * entry = resolveSpriteEntry(entries[i]);
+        if(entry == NULL || entry->data == NULL) {
+            continue;
+        }
+
+        offsets[nWritten] = ftell(file);
+        if(writeSprite(file, *entry) < 0) {
+            continue;
+        }
+
+        // The library hash folds together the hashes of its sprites
+        hash = (hash ^ hashSprite(*entry)) * 1099511628211UL;
+        entries[nWritten++] = entry;
+    }
+
+    // Write out the labels of all named and tagged sprites
+    long labelStart = ftell(file);
+    for(unsigned i = 0; i < nWritten; ++i) {
+        if(entries[i]->name != NULL || entries[i]->tags != NULL) {
+            fprintf(file, "%u ", i);
+            writeSpriteLabel(file, entries[i]->name, entries[i]->tags);
+        }
+    }
+    free(entries);
+
+    // Go back and fill in the real header and index
+    long end = ftell(file);
+    if(start < 0 || end < 0 || fseek(file, start, SEEK_SET) != 0) {
+        free(offsets);
+        return -1;
+    }
+    writeLibHeader(file, hash, nWritten, labelStart, offsets);
+
+    // Pad out the index lines reserved for any sprites that failed to write
+    for(unsigned i = nWritten; i < len; ++i) {
+        fprintf(file, "%010d\n", 0);
+    }
+    fseek(file, end, SEEK_SET);
+
+    free(offsets);
+    return nWritten;
+}
+
+spriteLib_t openSpriteLib(const char * path) {
+    if(path == NULL) {
+        return NULL;
+    }
+
+    // Share the library if it is already open
+    for(spriteLib_t lib = openLibs; lib != NULL; lib = lib->next) {
+        if(strcmp(lib->path, path) == 0) {
+            return retainSpriteLib(lib);
+        }
+    }
+
+    spriteLib_t lib = calloc(1, sizeof(struct spriteLib_s));
+    if(lib == NULL) {
+        return NULL;
+    }
+
+    lib->path = calloc(strlen(path) + 1, sizeof(char));
+    if(lib->path == NULL) {
+        goto openSpriteLibFail;
+    }
+    strcpy(lib->path, path);
+
+    lib->fp = fopen(path, "r");
+    if(lib->fp == NULL) {
+        goto openSpriteLibFail;
+    }
+
+    // Read the header, but leave the index and sprites for later
+    char magic[8];
+    if(fscanf(lib->fp, "%7s %lx %u %ld", magic, &lib->hash, &lib->nSprites, 
+                &lib->labelStart) != 4 ||
+            strcmp(magic, kLibMagic) != 0 || fgetc(lib->fp) != '\n') {
+        goto openSpriteLibFail;
+    }
+    lib->indexStart = ftell(lib->fp);
+
+    lib->loaded = calloc(lib->nSprites + 1, sizeof(sprite_t *));
+    if(lib->loaded == NULL) {
+        goto openSpriteLibFail;
+    }
+
+    lib->refs = 1;
+    lib->next = openLibs;
+    openLibs = lib;
+    return lib;
+
+openSpriteLibFail:
+    if(lib->fp != NULL) fclose(lib->fp);
+    if(lib->path != NULL) free(lib->path);
+    free(lib);
+    return NULL;
+}
+
+spriteLib_t retainSpriteLib(spriteLib_t lib) {
+    if(lib != NULL) {
+        lib->refs += 1;
+    }
+    return lib;
+}
+
+void closeSpriteLib(spriteLib_t lib) {
+    if(lib == NULL) {
+        return;
+    }
+
+    if(lib->refs > 1) {
+        lib->refs -= 1;
+        return;
+    }
+
+    // Unlink the library from the open list
+    spriteLib_t * link = &openLibs;
+    while(*link != NULL && *link != lib) {
+        link = &(*link)->next;
+    }
+    if(*link != NULL) {
+        *link = lib->next;
+    }
+
+    for(unsigned i = 0; i < lib->nSprites; ++i) {
+        freeSpriteEntry(lib->loaded[i]);
+    }
+    free(lib->loaded);
+    rmSpriteIndex(lib->index);
+
+    fclose(lib->fp);
+    free(lib->path);
+    free(lib);
+}
+
+//=============================<Library Access>===============================//
+const char * getSpriteLibPath(spriteLib_t lib) {
+    return (lib == NULL) ? NULL : lib->path;
+}
+
+unsigned long getSpriteLibHash(spriteLib_t lib) {
+    return (lib == NULL) ? 0 : lib->hash;
+}
+
+unsigned spriteLibLen(spriteLib_t lib) {
+    return (lib == NULL) ? 0 : lib->nSprites;
+}
+
+sprite_t * loadLibSprite(spriteLib_t lib, unsigned idx) {
+    if(lib == NULL || idx >= lib->nSprites) {
+        return NULL;
+    }
+
+    if(lib->loaded[idx] == NULL) {
+        // Look up the sprite's offset in the index and read just that record
+        long offset;
+        if(fseek(lib->fp, lib->indexStart + (long) idx * kLibIndexWidth, SEEK_SET) != 0 ||
+                fscanf(lib->fp, "%ld", &offset) != 1 || offset <= 0 ||
+                fseek(lib->fp, offset, SEEK_SET) != 0) {
+            return NULL;
+        }
+
+        sprite_t sprite = readSprite(lib->fp);
+        if(sprite.data == NULL) {
+            return NULL;
+        }
+
+        lib->loaded[idx] = internSprite(sprite);
+        if(lib->loaded[idx] == NULL) {
+            return NULL;
+        }
+    }
+
+    return retainSpriteEntry(lib->loaded[idx]);
+}
+
+const spriteIndex_t * getSpriteLibIndex(spriteLib_t lib) {
+    if(lib == NULL) {
+        return NULL;
+    }
+    if(lib->indexed) {
+        return &lib->index;
+    }
+
+    initSpriteIndex(&lib->index);
+    if(fseek(lib->fp, lib->labelStart, SEEK_SET) != 0) {
+        return NULL;
+    }
+
+    // Read each label line, filling in unlabeled sprites along the way
+    char line[kMaxLabelLen];
+    unsigned idx;
+    while(fscanf(lib->fp, "%u", &idx) == 1 && idx < lib->nSprites && 
+            fgets(line, sizeof(line), lib->fp) != NULL) {
+        char * name, * tags;
+        if(parseSpriteLabel(line, &name, &tags) < 0) {
+            break;
+        }
+
+        while(lib->index.nSprites < idx && 
+                addIndexedSprite(&lib->index, NULL, NULL, NULL) >= 0);
+        int ret = addIndexedSprite(&lib->index, NULL, name, tags);
+
+        if(name != NULL) free(name);
+        if(tags != NULL) free(tags);
+        if(ret < 0) {
+            break;
+        }
+    }
+    while(lib->index.nSprites < lib->nSprites && 
+            addIndexedSprite(&lib->index, NULL, NULL, NULL) >= 0);
+
+    if(lib->index.nSprites != lib->nSprites) {
+        rmSpriteIndex(lib->index);
+        initSpriteIndex(&lib->index);
+        return NULL;
+    }
+
+    lib->indexed = true;
+    return &lib->index;
+}
+
+int getLibSpriteLabel(spriteLib_t lib, unsigned idx, const char ** name, const char ** tags) {
+    const spriteIndex_t * index = getSpriteLibIndex(lib);
+    if(index == NULL || idx >= index->nSprites) {
+        return -1;
+    }
+
+    if(name != NULL) *name = index->names[idx];
+    if(tags != NULL) *tags = index->tags[idx];
+    return 0;
+}
+
+int linkSpriteLib(spriteLib_t lib, list_t list) {
+    if(lib == NULL || list == NULL) {
+        return -1;
+    }
+
+    int nLinked = 0;
+    for(unsigned i = 0; i < lib->nSprites; ++i) {
+        // Each entry holds its own reference to the library
+        sprite_t * entry = mkLazySpriteEntry(&kLibSpriteSource, retainSpriteLib(lib), i);
+        if(entry == NULL) {
+            closeSpriteLib(lib);
+            return (nLinked == 0) ? -1 : nLinked;
+        }
+
+        if(listAppend(list, entry) < 0) {
+            freeSpriteEntry(entry);
+            return (nLinked == 0) ? -1 : nLinked;
+        }
+        ++nLinked;
+    }
+
+    return nLinked;
+}
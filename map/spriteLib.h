@@ -0,0 +1,136 @@
+#ifndef _SPRITE_LIB_H_
+#define _SPRITE_LIB_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "sprite.h"
+#include "spriteIndex.h"
+#include "../common/list.h"
+
+/*
+ * Sprite library files hold a header, a fixed width index of sprite offsets, 
+ * the sprite records themselves and finally the labels of all named or tagged
+ * sprites:
+ *
+ *      SPRLIB <content hash (16 hex)> <sprite count (10)> <label offset (10)>
+ *      <offset of sprite 0 (10 digits)>
+ *      ...
+ *      <sprite records, as written by writeSprite>
+ *      <sprite index> <name> <tags...>
+ *      ...
+ *
+ * so that any one sprite can be read without parsing the rest of the library, 
+ * and sprites can be looked up by name or tag without reading any of them.
+ */
+
+typedef struct spriteLib_s * spriteLib_t;
+
+// Source functions for lazy list entries backed by a sprite library
+extern const spriteSource_t kLibSpriteSource;
+
+//==============================<Library Files>===============================//
+/**
+ * Writes all sprites in the given list out as a sprite library
+ *
+ * @param file The (seekable) file to write the library to
+ * @param list The sprite list to save from
+ *
+ * @return The number of sprites saved (<0 on failure)
+ */
+int writeSpriteLib(FILE* file, list_t list);
+
+/**
+ * Opens the sprite library at the given path (libraries are shared, so opening
+ * an already open library just adds a reference to it)
+ *
+ * @param path The path of the library file
+ *
+ * @return A reference to the library (NULL on failure)
+ */
+spriteLib_t openSpriteLib(const char * path);
+
+/**
+ * Adds a reference to an open sprite library
+ *
+ * @param lib The library to reference
+ * @return The library passed in
+ */
+spriteLib_t retainSpriteLib(spriteLib_t lib);
+
+/**
+ * Drops a reference to a sprite library (closing it with the last reference)
+ *
+ * @param lib The library to release
+ */
+void closeSpriteLib(spriteLib_t lib);
+
+//=============================<Library Access>===============================//
+/**
+ * Returns the path a library was opened from
+ *
+ * @param lib The library to query
+ * @return The library's path
+ */
+const char * getSpriteLibPath(spriteLib_t lib);
+
+/**
+ * Returns the content hash stored in a library's header
+ *
+ * @param lib The library to query
+ * @return The library's content hash
+ */
+unsigned long getSpriteLibHash(spriteLib_t lib);
+
+/**
+ * Returns the number of sprites in a library
+ *
+ * @param lib The library to query
+ * @return The number of sprites in the library
+ */
+unsigned spriteLibLen(spriteLib_t lib);
+
+/**
+ * Loads a single sprite from the library (reading only that sprite's record)
+ *
+ * @param lib The library to load from
+ * @param idx The index of the sprite in the library
+ *
+ * @return A new reference to the (interned) sprite, NULL on failure
+ */
+sprite_t * loadLibSprite(spriteLib_t lib, unsigned idx);
+
+/**
+ * Gets the labels of a library sprite (without loading the sprite)
+ *
+ * @param lib The library to read from
+ * @param idx The index of the sprite in the library
+ * @param name A return pointer for the sprite's name (NULL if unnamed)
+ * @param tags A return pointer for the sprite's tags (NULL if untagged)
+ *
+ * @return 0 on success, <0 on failure
+ */
+int getLibSpriteLabel(spriteLib_t lib, unsigned idx, const char ** name, const char ** tags);
+
+/**
+ * Gets the name and tag index of a library (read from the library's label 
+ * section on first use)
+ *
+ * @param lib The library to index
+ *
+ * @return The library's index (NULL on failure)
+ */
+const spriteIndex_t * getSpriteLibIndex(spriteLib_t lib);
+
+/**
+ * Appends a lazy entry for each sprite in the library to the provided list
+ *
+ * @param lib The library to reference
+ * @param list The sprite list to append to
+ *
+ * @return The number of entries appended (<0 on failure)
+ */
+int linkSpriteLib(spriteLib_t lib, list_t list);
+
+#endif
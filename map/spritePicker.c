@@ -0,0 +1,263 @@
+#include "spritePicker.h"
+
+#include <string.h>
+#include <curses.h>
+
+#ifndef min
+#define min(a, b) ((a < b) ? a : b)
+#endif
+
+#ifndef max
+#define max(a, b) ((a > b) ? a : b)
+#endif
+
+#define kThumbSize (kThumbHeight * kThumbWidth)
+
+#define kPickerPrompt "Arrows and PgUp/PgDn to browse, enter to pick, '/' to find by name"
+
+//==================================<Helpers>=================================//
+/**
+ * Sizes the grid to the screen, reallocating the thumbnail cache to match
+ */
+static int layoutPicker(dispData_t * data, spritePicker_t * picker) {
+    // Leave a row at the top for the prompt and one at the bottom for status
+    picker->gridCols = max(data->screenCols / kThumbCellCols, 1);
+    picker->gridRows = max((data->screenRows - 2) / kThumbCellRows, 1);
+
+    unsigned nSlots = kPickerCachePages * picker->gridRows * picker->gridCols;
+    if(nSlots == picker->nSlots) {
+        return 0;
+    }
+
+    rmSpritePicker(*picker);
+    picker->nSlots = 0;
+    picker->slotSprites = calloc(nSlots, sizeof(int));
+    picker->slotEntries = calloc(nSlots, sizeof(sprite_t *));
+    picker->atlas = calloc(nSlots * kThumbSize, sizeof(drawPair_t));
+    if(picker->slotSprites == NULL || picker->slotEntries == NULL || picker->atlas == NULL) {
+        rmSpritePicker(*picker);
+        picker->slotSprites = NULL;
+        picker->slotEntries = NULL;
+        picker->atlas = NULL;
+        return -1;
+    }
+
+    picker->nSlots = nSlots;
+    clearPickerCache(picker);
+    return 0;
+}
+
+/**
+ * Renders a sprite's thumbnail into the given cache slot
+ */
+static void renderThumb(spritePicker_t * picker, unsigned slot, const spriteIndex_t * index, int idx) {
+    drawPair_t * thumb = picker->atlas + slot * kThumbSize;
+    memset(thumb, 0, kThumbSize * sizeof(drawPair_t));
+
+    picker->slotSprites[slot] = idx;
+    picker->slotEntries[slot] = index->sprites[idx];
+
+    // Mark sprites that fail to load rather than leaving them blank
+    sprite_t * sprite = getIndexedSprite(index, idx);
+    if(sprite == NULL) {
+        thumb[(kThumbHeight / 2) * kThumbWidth + kThumbWidth / 2] = mkDrawPair(kRedPalette, '?');
+        return;
+    }
+
+    // Place the sprite as it would sit in a tile, clipped to the thumbnail
+    for(int dRow = 0; dRow < sprite->height; ++dRow) {
+        int row = sprite->yOff + dRow;
+        if(row < 0 || row >= kThumbHeight) continue;
+
+        for(int dCol = 0; dCol < sprite->width; ++dCol) {
+            int col = sprite->xOff + dCol;
+            if(col < 0 || col >= kThumbWidth || sprite->data[dRow][dCol] == '\0') continue;
+
+            thumb[row * kThumbWidth + col] = mkDrawPair(sprite->defPalette,
+                                                sprite->data[dRow][dCol]);
+        }
+    }
+}
+
+/**
+ * Buffers one grid cell (thumbnail and label) of the picker
+ */
+static void addThumb(dispData_t * data, spritePicker_t * picker, const spriteIndex_t * index,
+                        int idx, int screenRow, int screenCol) {
+    // Re-render the thumbnail if its slot holds a different sprite
+    unsigned slot = idx % picker->nSlots;
+    if(picker->slotSprites[slot] != idx || picker->slotEntries[slot] != index->sprites[idx]) {
+        renderThumb(picker, slot, index, idx);
+    }
+
+    bool selected = (idx == picker->sel);
+    short bgPalette = selected ? kYellowPalette : kBlackPalette;
+    const drawPair_t * thumb = picker->atlas + slot * kThumbSize;
+
+    for(int dRow = 0; dRow < kThumbHeight; ++dRow) {
+        int row = screenRow + dRow;
+        if(row >= data->screenRows - 1) break;
+
+        drawPair_t * cells = dispRow(data, row);
+        for(int dCol = 0; dCol < kThumbWidth; ++dCol) {
+            int col = screenCol + dCol;
+            if(col >= data->screenCols) break;
+
+            drawPair_t pair = thumb[dRow * kThumbWidth + dCol];
+            cells[col] = (pair == kEmptyCell) ? mkDrawPair(bgPalette, ' ') : pair;
+        }
+    }
+
+    // Label the thumbnail with the sprite's name (or its number if unnamed)
+    char label[kThumbWidth + 16];
+    if(index->names[idx] != NULL) {
+        snprintf(label, sizeof(label), "%s", index->names[idx]);
+    } else {
+        snprintf(label, sizeof(label), "#%d", idx + 1);
+    }
+    label[kThumbWidth] = '\0';
+
+    if(screenRow + kThumbHeight < data->screenRows - 1) {
+        addText(data, selected ? kWhitePalette : kBlackPalette, label,
+                    screenRow + kThumbHeight, screenCol);
+    }
+}
+
+//=============================<Init and Cleanup>=============================//
+void initSpritePicker(spritePicker_t * picker) {
+    if(picker == NULL) return;
+
+    memset(picker, 0, sizeof(spritePicker_t));
+}
+
+void rmSpritePicker(spritePicker_t picker) {
+    if(picker.slotSprites != NULL) free(picker.slotSprites);
+    if(picker.slotEntries != NULL) free(picker.slotEntries);
+    if(picker.atlas != NULL) free(picker.atlas);
+}
+
+void clearPickerCache(spritePicker_t * picker) {
+    if(picker == NULL) return;
+
+    for(unsigned i = 0; i < picker->nSlots; ++i) {
+        picker->slotSprites[i] = -1;
+        picker->slotEntries[i] = NULL;
+    }
+}
+
+//=================================<Display>==================================//
+int addSpritePicker(dispData_t * data, spritePicker_t * picker, const spriteIndex_t * index) {
+    if(data == NULL || data->data == NULL || picker == NULL || index == NULL) {
+        return -1;
+    }
+
+    if(layoutPicker(data, picker) < 0) {
+        return -1;
+    }
+
+    addText(data, kBlackPalette, kPickerPrompt, 0, 0);
+
+    int nSprites = index->nSprites;
+    if(nSprites == 0) {
+        addText(data, kBlackPalette, "No sprites loaded", 2, 0);
+        return 0;
+    }
+    movePickerSel(picker, index, 0);
+
+    // Scroll just far enough to keep the selection in view
+    int selRow = picker->sel / picker->gridCols;
+    if(selRow < picker->top) {
+        picker->top = selRow;
+    } else if(selRow >= picker->top + picker->gridRows) {
+        picker->top = selRow - picker->gridRows + 1;
+    }
+
+    // Only the visible page is ever rendered
+    int first = picker->top * picker->gridCols;
+    int last = min(first + picker->gridRows * picker->gridCols, nSprites);
+    for(int idx = first; idx < last; ++idx) {
+        int cell = idx - first;
+        addThumb(data, picker, index, idx, 1 + (cell / picker->gridCols) * kThumbCellRows,
+                    (cell % picker->gridCols) * kThumbCellCols);
+    }
+
+    // Show the full labels of the selected sprite on the status line
+    char status[128];
+    snprintf(status, sizeof(status), "%d/%d %s %s", picker->sel + 1, nSprites,
+                (index->names[picker->sel] == NULL) ? "" : index->names[picker->sel],
+                (index->tags[picker->sel] == NULL) ? "" : index->tags[picker->sel]);
+    addText(data, kBlackPalette, status, data->screenRows - 1, 0);
+
+    return 0;
+}
+
+void movePickerSel(spritePicker_t * picker, const spriteIndex_t * index, int dSel) {
+    if(picker == NULL || index == NULL) return;
+
+    picker->sel = max(min(picker->sel + dSel, (int) index->nSprites - 1), 0);
+}
+
+int pickSprite(dispData_t * data, spritePicker_t * picker, const spriteIndex_t * index) {
+    if(data == NULL || picker == NULL || index == NULL || index->nSprites == 0) {
+        return -1;
+    }
+
+    char buf[80];
+    while(true) {
+        // Draw the picker (once any waiting keys are applied)
+        if(shouldRender(data)) {
+            clearBuffer(data);
+            if(addSpritePicker(data, picker, index) < 0) {
+                return -1;
+            }
+            printBuffer(data);
+            curs_set(0);
+        }
+
+        int page = picker->gridRows * picker->gridCols;
+        int ch = getKey();
+        switch(ch) {
+            // Navigation
+            case KEY_LEFT:
+                movePickerSel(picker, index, -1);
+                break;
+            case KEY_RIGHT:
+                movePickerSel(picker, index, 1);
+                break;
+            case KEY_UP:
+                movePickerSel(picker, index, -picker->gridCols);
+                break;
+            case KEY_DOWN:
+                movePickerSel(picker, index, picker->gridCols);
+                break;
+            case KEY_PPAGE:
+                movePickerSel(picker, index, -page);
+                break;
+            case KEY_NPAGE:
+                movePickerSel(picker, index, page);
+                break;
+
+            // Jump to a sprite by name
+            case '/':
+                clear();
+                printText(kBlackPalette, "Enter the sprite name", 0, 0);
+                getText(2, 0, buf, sizeof(buf));
+
+                int idx = findSpriteByName(index, buf);
+                if(idx >= 0) {
+                    picker->sel = idx;
+                }
+                break;
+
+            // Selection
+            case KEY_ENTER:
+            case '\n':
+                return picker->sel;
+
+            case KEY_HOME:
+            case '`':
+            case '~':
+                return -1;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef _SPRITE_PICKER_H_
+#define _SPRITE_PICKER_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "../common/dispBase.h"
+
+#include "sprite.h"
+#include "spriteIndex.h"
+#include "wallSprites.h"
+
+// Each thumbnail is a tile sized view of its sprite with a label row beneath
+#define kThumbHeight    kTileHeight
+#define kThumbWidth     kTileWidth
+#define kThumbCellRows  (kThumbHeight + 1)
+#define kThumbCellCols  (kThumbWidth + 1)
+
+// Number of pages of thumbnails kept in the cache
+#define kPickerCachePages 4
+
+typedef struct spritePicker_s {
+    int sel;                    // The selected sprite
+    int top;                    // The first grid row in view
+
+    int gridRows, gridCols;     // Size of the visible grid (in thumbnails)
+
+    unsigned nSlots;            // Number of thumbnail slots in the cache
+    int * slotSprites;          // Sprite rendered into each slot (<0 if none)
+    const sprite_t ** slotEntries;  // Entry each slot was rendered from
+    drawPair_t * atlas;         // Cached thumbnails (one per slot, row major)
+} spritePicker_t;
+
+//=============================<Init and Cleanup>=============================//
+/**
+ * Initializes an empty sprite picker
+ *
+ * @param picker The picker to initialize
+ */
+void initSpritePicker(spritePicker_t * picker);
+
+/**
+ * Frees all data allocated by a sprite picker
+ *
+ * @param picker The picker to free
+ */
+void rmSpritePicker(spritePicker_t picker);
+
+/**
+ * Drops all cached thumbnails (call after editing a sprite in place)
+ *
+ * @param picker The picker to clear
+ */
+void clearPickerCache(spritePicker_t * picker);
+
+//=================================<Display>==================================//
+/**
+ * Buffers the visible page of the picker, rendering only those thumbnails
+ * which are not already cached
+ *
+ * @param data The display data struct
+ * @param picker The picker to draw
+ * @param index The index of the sprites to pick from
+ *
+ * @return 0 on success, <0 on failure
+ */
+int addSpritePicker(dispData_t * data, spritePicker_t * picker, const spriteIndex_t * index);
+
+/**
+ * Moves the picker's selection (clamped to the sprites available)
+ *
+ * @param picker The picker to update
+ * @param index The index of the sprites to pick from
+ * @param dSel The number of sprites to move the selection by
+ */
+void movePickerSel(spritePicker_t * picker, const spriteIndex_t * index, int dSel);
+
+/**
+ * Runs the picker until a sprite is chosen or the picker is cancelled,
+ * starting from the picker's current selection
+ *
+ * @param data The display data struct
+ * @param picker The picker to run
+ * @param index The index of the sprites to pick from
+ *
+ * @return The index of the chosen sprite (<0 if cancelled)
+ */
+int pickSprite(dispData_t * data, spritePicker_t * picker, const spriteIndex_t * index);
+
+#endif
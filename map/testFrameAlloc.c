@@ -0,0 +1,152 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "mapDisp.h"
+#include "mapPyramid.h"
+
+#include "tile.h"
+#include "map.h"
+
+#define kMapFile "maps/FirstDungeon_1.out"
+
+#define kScreenRows 50
+#define kScreenCols 160
+
+#define kNumFrames 1000     // Frames rendered (and counted) after the warm up
+#define kPathLen 100        // Frames before the cursor's path repeats
+
+//===========================<Allocation Counting>============================//
+// Linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc, so that every
+// allocation made by the code under test comes through here
+
+void * __real_malloc(size_t size);
+void * __real_calloc(size_t nmemb, size_t size);
+void * __real_realloc(void * ptr, size_t size);
+
+static bool counting = false;
+static unsigned long nAllocs = 0;
+
+void * __wrap_malloc(size_t size) {
+    if(counting) ++nAllocs;
+    return __real_malloc(size);
+}
+
+void * __wrap_calloc(size_t nmemb, size_t size) {
+    if(counting) ++nAllocs;
+    return __real_calloc(nmemb, size);
+}
+
+void * __wrap_realloc(void * ptr, size_t size) {
+    if(counting) ++nAllocs;
+    return __real_realloc(ptr, size);
+}
+
+//=================================<Frames>===================================//
+/**
+ * Renders a frame the way makeMap's edit screen does, with the cursor partway
+ * along its path (cycling through the full view, the overview, a split screen
+ * and the profile overlay)
+ */
+void renderFrame(tileData_t * data, viewport_t * ports, mapPyramid_t * pyramid, map_t * map,
+                    int step, frameStats_t * stats) {
+    // Walk the cursor round the map, editing a tile along the way
+    int x = (step * 3) % map->nCols, y = (step * 7) % map->nRows;
+    tile_t * tile = &map->data[y][x];
+    tile->bgPalette = (step % 2 == 0) ? kRedPalette : kBluePalette;
+    updateMapPyramid(pyramid, map, x, y, x, y);
+
+    if(!shouldRender(&data->dispData)) return;
+
+    beginFrame();
+    beginStage(kStageFill);
+    clearBuffer(&data->dispData);
+    endStage(kStageFill);
+
+    beginStage(kStageCompose);
+    switch(step % 4) {
+        case 0:
+        case 3:
+            addMap(data, map, x, y);
+            break;
+        case 1:
+            addMapOverview(&data->dispData, pyramid, map, step % pyramid->nLevels, x, y);
+            break;
+        case 2:
+            for(int i = 0; i < 2; i++) {
+                ports[i].x = (i == 0) ? x : map->nCols - 1 - x;
+                ports[i].y = y;
+                addViewport(data, &ports[i], map);
+            }
+            break;
+    }
+    endStage(kStageCompose);
+
+    if(step % 4 == 3) {
+        addFrameStats(&data->dispData, stats, kScreenRows - 1);
+    }
+
+    printBuffer(&data->dispData);
+    *stats = endFrame();
+}
+
+//==================================<Main>====================================//
+int main() {
+    tileData_t data;
+    if(loadTileData(&data) < 0 || initDispBuffer(&data.dispData, kScreenRows, kScreenCols) < 0) {
+        fprintf(stderr, "*ERROR* in main: failed to set up the display\n");
+        return EXIT_FAILURE;
+    }
+
+    FILE* fp = fopen(kMapFile, "r");
+    map_t map;
+    if(fp == NULL || loadMap(&map, &data.spriteList, fp) < 0) {
+        fprintf(stderr, "*ERROR* in main: failed to load \"%s\"\n", kMapFile);
+        return EXIT_FAILURE;
+    }
+    fclose(fp);
+    refreshSpriteIndex(&data);
+    invalidateMapView(&data);
+
+    mapPyramid_t pyramid;
+    initMapPyramid(&pyramid);
+    viewport_t ports[2];
+    if(buildMapPyramid(&pyramid, &map) < 0 ||
+            initViewport(&ports[0], kTileWidth, kTileHeight) < 0 ||
+            initViewport(&ports[1], kCompactTileWidth, kCompactTileHeight) < 0) {
+        fprintf(stderr, "*ERROR* in main: failed to set up the views\n");
+        return EXIT_FAILURE;
+    }
+    placeViewport(&ports[0], 0, 0, kScreenRows, kScreenCols / 2);
+    placeViewport(&ports[1], 0, kScreenCols / 2 + 1, kScreenRows, kScreenCols / 2 - 1);
+
+    // Warm up over one pass of the path (filling the caches), then count the
+    // allocations made while rendering the rest
+    frameStats_t stats;
+    memset(&stats, 0, sizeof(frameStats_t));
+    printf("Warming up over %d frames\n", kPathLen);
+    for(int step = 0; step < kPathLen; step++) {
+        renderFrame(&data, ports, &pyramid, &map, step, &stats);
+    }
+
+    printf("Rendering %d frames\n", kNumFrames);
+    counting = true;
+    for(int step = 0; step < kNumFrames; step++) {
+        renderFrame(&data, ports, &pyramid, &map, step % kPathLen, &stats);
+    }
+    counting = false;
+
+    printf("%lu allocations made over %d frames\n", nAllocs, kNumFrames);
+
+    rmViewport(ports[0]);
+    rmViewport(ports[1]);
+    rmMapPyramid(pyramid);
+    rmMap(map);
+    rmTileData(data);
+
+    if(nAllocs != 0) {
+        fprintf(stderr, "*ERROR* in main: the frame loop allocated\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
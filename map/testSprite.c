@@ -2,8 +2,10 @@
 #include <stdio.h>
 
 #include "sprite.h"
+#include "spriteLib.h"
 
 #define kOutFile "out.o"
+#define kLibFile "lib.o"
 
 void printSprite(sprite_t sprite) {
     for(int row = 0; row < sprite.height; row++) {
@@ -51,6 +53,7 @@ int main() {
     writeSprite(fp, tile);
     rmSprite(tile);
 
+    setSpriteTags(&sprite, "wall");
     writeSprite(fp, sprite);
 
     printf("First sprite written: \n\n");
@@ -58,6 +61,8 @@ int main() {
     printf("\n");
 
     sprite.data[0][2] = '/';
+    setSpriteName(&sprite, "corner");
+    setSpriteTags(&sprite, "wall test");
     writeSprite(fp, sprite);
 
     printf("Second sprite written: \n\n");
@@ -80,6 +85,64 @@ int main() {
     }
     printf("Read %d sprites total\n", i);
 
+    // Test that loading the same sprites twice shares a single copy of each
+    list_t first = mkList(), second = mkList();
+    rewind(fp);
+    loadSpriteList(fp, &first);
+    rewind(fp);
+    loadSpriteList(fp, &second);
+
+    printf("Loaded %u + %u sprites, %u unique copies interned\n", 
+                listLen(first), listLen(second), nInternedSprites());
+    if(nInternedSprites() != (unsigned) i || listGet(first, 0) != listGet(second, 0)) {
+        fprintf(stderr, "*ERROR* in main: identical sprites were not shared\n");
+        return EXIT_FAILURE;
+    }
+
+    // Test that a library only loads the sprites that are actually used
+    FILE* libFp = fopen(kLibFile, "w");
+    if(libFp == NULL || writeSpriteLib(libFp, first) != i) {
+        fprintf(stderr, "*ERROR* in main: failed to write sprite library\n");
+        return EXIT_FAILURE;
+    }
+    fclose(libFp);
+
+    rmList(first, freeSpriteEntry);
+    rmList(second, freeSpriteEntry);
+    printf("%u sprites interned after freeing both lists\n", nInternedSprites());
+
+    spriteLib_t lib = openSpriteLib(kLibFile);
+    list_t linked = mkList();
+    if(lib == NULL || linkSpriteLib(lib, linked) != i) {
+        fprintf(stderr, "*ERROR* in main: failed to link sprite library\n");
+        return EXIT_FAILURE;
+    }
+    closeSpriteLib(lib);
+
+    // Test that library sprites can be found by name and tag without loading them
+    spriteIndex_t index;
+    initSpriteIndex(&index);
+    const unsigned * tagged;
+    if(buildSpriteIndex(&index, linked) < 0 || findSpriteByName(&index, "corner") != i - 1 ||
+            findSpritesByTag(&index, "wall", &tagged) != 2 || tagged[1] != (unsigned) i - 1 ||
+            findSpritesByTag(&index, "door", NULL) != 0 || nInternedSprites() != 0) {
+        fprintf(stderr, "*ERROR* in main: library sprites were not indexed by label\n");
+        return EXIT_FAILURE;
+    }
+    printf("Found sprite \"corner\" and %u sprites tagged \"wall\"\n", 
+                findSpritesByTag(&index, "wall", NULL));
+
+    sprite_t * last = getListSprite(linked, i - 1);
+    printf("Linked %u library sprites, %u loaded after using the last one:\n\n", 
+                listLen(linked), nInternedSprites());
+    if(last == NULL || nInternedSprites() != 1) {
+        fprintf(stderr, "*ERROR* in main: library sprites were not loaded lazily\n");
+        return EXIT_FAILURE;
+    }
+    printSprite(*last);
+    rmSpriteIndex(index);
+    rmList(linked, freeSpriteEntry);
+
     //Cleanup and exit
     fclose(fp);
     return EXIT_SUCCESS;
@@ -29,38 +29,59 @@ tile_t mkEmptyTile() {
 }
 
 
+//==============================<Tile Sprites>================================//
 /**
- * Loads a tile data struct's sprites from file
- * 
- * @param fileName The sprite file to load tiles from
- * @param data A return pointer for the tile data struct
- * @return 0 on success, <0 on failure
+ * Frees the base, wall and character sprites of a tile data struct
  */
-int loadTileData(tileData_t * data) {
-    data->spriteList = NULL;
+static void rmTileSprites(tileData_t data) {
+    rmSprite(data.emptyBase);
+    rmSprite(data.tileBase);
+    rmSprite(data.lWall);
+    rmSprite(data.rWall);
+    rmSprite(data.uWall);
+    rmSprite(data.dWall);
+    rmSprite(data.lDoor);
+    rmSprite(data.rDoor);
+    rmSprite(data.uDoor);
+    rmSprite(data.dDoor);
+
+    rmSprite(data.charSprite);
+}
+
+/**
+ * Builds the base, wall and character sprites for tiles of the given size
+ */
+static int mkTileSprites(tileData_t * data, int width, int height) {
+    data->emptyBase = data->tileBase = kEmptySprite;
+    data->lWall = data->rWall = data->uWall = data->dWall = kEmptySprite;
+    data->lDoor = data->rDoor = data->uDoor = data->dDoor = kEmptySprite;
+    data->charSprite = kEmptySprite;
+
+    data->tileWidth = width;
+    data->tileHeight = height;
 
     // Construct the cells from the given dimensional data
-    data->emptyBase = mkSprite(kEmptyPalette, kTileWidth, kTileHeight, 0, 0);
-    data->tileBase = mkSprite(kBasePalette, kTileWidth, kTileHeight, 0, 0);
+    data->emptyBase = mkSprite(kEmptyPalette, width, height, 0, 0);
+    data->tileBase = mkSprite(kBasePalette, width, height, 0, 0);
     if(data->emptyBase.data == NULL || data->tileBase.data == NULL) {
-        goto loadTileDataFail;
+        goto mkTileSpritesFail;
     }
-    for(int row = 0; row < kTileHeight; ++row) {
-        for(int col = 0; col < kTileWidth; ++col) {
+    for(int row = 0; row < height; ++row) {
+        for(int col = 0; col < width; ++col) {
             data->emptyBase.data[row][col] = ' ';
             data->tileBase.data[row][col] = ' ';
         }
     }
 
-    data->lWall = mkSprite(kWallPalette, 1, kTileHeight, 0, 0);
-    data->rWall = mkSprite(kWallPalette, 1, kTileHeight, kTileWidth-1, 0);
-    data->lDoor = mkSprite(kDoorPalette, 1, kTileHeight, 0, 0);
-    data->rDoor = mkSprite(kDoorPalette, 1, kTileHeight, kTileWidth-1, 0);
+    data->lWall = mkSprite(kWallPalette, 1, height, 0, 0);
+    data->rWall = mkSprite(kWallPalette, 1, height, width-1, 0);
+    data->lDoor = mkSprite(kDoorPalette, 1, height, 0, 0);
+    data->rDoor = mkSprite(kDoorPalette, 1, height, width-1, 0);
     if(data->lWall.data == NULL || data->lDoor.data == NULL || 
         data->rWall.data == NULL || data->rDoor.data == NULL) {
-        goto loadTileDataFail;
+        goto mkTileSpritesFail;
     }
-    for(int row = 0; row < kTileHeight; ++row) {
+    for(int row = 0; row < height; ++row) {
         data->lWall.data[row][0] = kWallChar;
         data->rWall.data[row][0] = kWallChar;
         data->lDoor.data[row][0] = kDoorChar;
@@ -69,15 +90,15 @@ int loadTileData(tileData_t * data) {
     }
 
 
-    data->uWall = mkSprite(kWallPalette, kTileWidth, 1, 0, 0);
-    data->dWall = mkSprite(kWallPalette, kTileWidth, 1, 0, kTileHeight-1);
-    data->uDoor = mkSprite(kDoorPalette, kTileWidth, 1, 0, 0);
-    data->dDoor = mkSprite(kDoorPalette, kTileWidth, 1, 0, kTileHeight-1);
+    data->uWall = mkSprite(kWallPalette, width, 1, 0, 0);
+    data->dWall = mkSprite(kWallPalette, width, 1, 0, height-1);
+    data->uDoor = mkSprite(kDoorPalette, width, 1, 0, 0);
+    data->dDoor = mkSprite(kDoorPalette, width, 1, 0, height-1);
     if(data->uWall.data == NULL || data->uDoor.data == NULL || 
         data->dWall.data == NULL || data->dDoor.data == NULL) {
-        goto loadTileDataFail;
+        goto mkTileSpritesFail;
     }
-    for(int col = 0; col < kTileWidth; ++col) {
+    for(int col = 0; col < width; ++col) {
         data->uWall.data[0][col] = kWallChar;
         data->dWall.data[0][col] = kWallChar;
         data->uDoor.data[0][col] = kDoorChar;
@@ -87,13 +108,23 @@ int loadTileData(tileData_t * data) {
 
     data->tileBase.data[0][0] = kCellCornerChar;
 
+    // Tiles too small to box the character inside their walls get it bare
+    if(width < 5 || height < 5) {
+        data->charSprite = mkBlankTile(kWhitePalette, 1, 1);
+        if(data->charSprite.data == NULL) goto mkTileSpritesFail;
+
+        data->charSprite.xOff = width/2;
+        data->charSprite.yOff = height/2;
+        return 0;
+    }
+
     // Allocate the character sprite
     data->charSprite = mkBlankTile(kWhitePalette, 3, 3);
-    if(data->charSprite.data == NULL) goto loadTileDataFail;
+    if(data->charSprite.data == NULL) goto mkTileSpritesFail;
 
     // Set the offsets on the char sprite to the middle
-    data->charSprite.xOff = (data->emptyBase.width/2 - 1);
-    data->charSprite.yOff = (data->emptyBase.height/2 - 1);
+    data->charSprite.xOff = (width/2 - 1);
+    data->charSprite.yOff = (height/2 - 1);
 
     // Set the border of the sprite
     data->charSprite.data[0][0] = '+';
@@ -108,31 +139,96 @@ int loadTileData(tileData_t * data) {
 
     return 0;
 
-loadTileDataFail:
-    rmTileData(*data);
+mkTileSpritesFail:
+    rmTileSprites(*data);
     return -1;
 }
 
+/**
+ * Loads a tile data struct's sprites from file
+ * 
+ * @param fileName The sprite file to load tiles from
+ * @param data A return pointer for the tile data struct
+ * @return 0 on success, <0 on failure
+ */
+int loadTileData(tileData_t * data) {
+    return loadTileDataDim(data, kTileWidth, kTileHeight);
+}
+
+/**
+ * Loads a tile data struct with tiles of the given size
+ * 
+ * @param data A return pointer for the tile data struct
+ * @param width The width of a tile in characters
+ * @param height The height of a tile in characters
+ * 
+ * @return 0 on success, <0 on failure
+ */
+int loadTileDataDim(tileData_t * data, int width, int height) {
+    if(data == NULL || width < kMinTileWidth || width > kMaxTileWidth || 
+            height < kMinTileHeight) {
+        return -1;
+    }
+
+    data->spriteList = NULL;
+    initSpriteIndex(&data->spriteIndex);
+    data->overflow = NULL;
+    data->overflowCap = 0;
+    memset(&data->view, 0, sizeof(mapView_t));
+    data->view.stale = true;
+    memset(&data->stamps, 0, sizeof(tileStamps_t));
+
+    return mkTileSprites(data, width, height);
+}
+
+/**
+ * Changes the size of the tiles, keeping the loaded sprite list
+ * 
+ * @param data The tile data struct to resize
+ * @param width The new width of a tile in characters
+ * @param height The new height of a tile in characters
+ * 
+ * @return 0 on success, <0 on failure (leaving the tiles unchanged)
+ */
+int resizeTileData(tileData_t * data, int width, int height) {
+    if(data == NULL || width < kMinTileWidth || width > kMaxTileWidth || 
+            height < kMinTileHeight) {
+        return -1;
+    }
+
+    // Build the new sprites off to the side, so failure leaves the old ones
+    tileData_t resized = *data;
+    if(mkTileSprites(&resized, width, height) < 0) {
+        return -1;
+    }
+
+    rmTileSprites(*data);
+    *data = resized;
+    return 0;
+}
+
+/**
+ * Frees a table of tile stamps
+ */
+static void rmTileStamps(tileStamps_t stamps) {
+    if(stamps.slots != NULL) free(stamps.slots);
+    if(stamps.cells != NULL) free(stamps.cells);
+}
+
 /**
  * Frees all of the allocated data from the tileData struct
  * 
  * @param tileData The tileData struct to free from
  */
 void rmTileData(tileData_t data) {
-    rmSprite(data.emptyBase);
-    rmSprite(data.tileBase);
-    rmSprite(data.lWall);
-    rmSprite(data.rWall);
-    rmSprite(data.uWall);
-    rmSprite(data.dWall);
-    rmSprite(data.lDoor);
-    rmSprite(data.rDoor);
-    rmSprite(data.uDoor);
-    rmSprite(data.dDoor);
+    rmTileSprites(data);
 
     rmList(data.spriteList, freeSpriteEntry);
-
-    rmSprite(data.charSprite);
+    rmSpriteIndex(data.spriteIndex);
+    if(data.overflow != NULL) free(data.overflow);
+    if(data.view.tiles != NULL) free(data.view.tiles);
+    closeDisp(data.view.canvas);
+    rmTileStamps(data.stamps);
 }
 
 /**
@@ -211,9 +307,9 @@ int getSpriteIdx(tile_t tile) {
  * 
  * @return 0 on success, < 0 on failure
  */
-int setSpriteIdx(tileData_t data, tile_t* tile, int idx) {
-    if(data.spriteList == NULL || idx < 0 || 
-            (unsigned) idx >= listLen(data.spriteList)) {
+int setSpriteIdx(const tileData_t * data, tile_t* tile, int idx) {
+    if(data == NULL || data->spriteList == NULL || idx < 0 || 
+            (unsigned) idx >= listLen(data->spriteList)) {
         return -1;
     }
 
@@ -221,6 +317,40 @@ int setSpriteIdx(tileData_t data, tile_t* tile, int idx) {
     return 0;
 }
 
+/**
+ * Rebuilds the tile data's sprite index (call whenever spriteList changes)
+ * 
+ * @param data The tile data struct to re-index
+ * 
+ * @return 0 on success, < 0 on failure
+ */
+int refreshSpriteIndex(tileData_t * data) {
+    if(data == NULL) return -1;
+
+    return buildSpriteIndex(&data->spriteIndex, data->spriteList);
+}
+
+/**
+ * Gets a sprite from the tile data's sprite list by index (in constant time 
+ * while the sprite index is up to date)
+ * 
+ * @param data The tile data struct to read from
+ * @param idx The index of the sprite
+ * 
+ * @return The loaded sprite (NULL on invalid index or failure to load)
+ */
+sprite_t * getTileSprite(const tileData_t * data, int idx) {
+    if(data == NULL || idx < 0) return NULL;
+
+    // Fall back on walking the list if the index is out of date
+    if(data->spriteIndex.list != data->spriteList || 
+            data->spriteIndex.nSprites != listLen(data->spriteList)) {
+        return getListSprite(data->spriteList, idx);
+    }
+
+    return getIndexedSprite(&data->spriteIndex, idx);
+}
+
 /**
  * Removes any sprite from the provided tile
  * 
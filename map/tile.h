@@ -3,12 +3,16 @@
 
 #include "wallSprites.h"
 #include "sprite.h"
+#include "spriteIndex.h"
 #include "../common/dispBase.h"
 #include "../common/list.h"
 
 #define kNoSprite -1
 #define writeCharSprite(palette, ch) (-1 * (palette << 8 | ch))
 
+// The cell of the character sprite which holds the character itself
+#define charSpriteGlyph(sprite) ((sprite).data[(sprite).height/2][(sprite).width/2])
+
 typedef struct tile_s {
     int sprite;             // The index of the sprite used on this tile
     short bgPalette;        // Background palette for this tile
@@ -26,8 +30,45 @@ typedef struct tile_s {
     signed char isEmpty;
 } tile_t;
 
+// The tiles last drawn by addMap, kept so that scrolling only draws the tiles 
+// which come into view (see mapDisp.c)
+typedef struct mapView_s {
+    dispData_t canvas;      // The drawn tiles (a headless buffer)
+    tile_t * tiles;         // The tile drawn at each position in view
+    int scrX, scrY;         // Map coordinates of the top-left tile in view
+    int nRows, nCols;       // Number of tiles in view
+    int tileWidth, tileHeight;  // Size the tiles were drawn at
+    bool spilled;           // Set if a drawn sprite spilled out of its tile
+    bool stale;             // Set if the canvas must be redrawn from scratch
+    unsigned stampGen;      // Generation of the tile stamps when last drawn
+} mapView_t;
+
+// A composed tile, kept so that drawing the same tile again (in any view) is a
+// copy rather than a composite
+typedef struct tileStamp_s {
+    tile_t tile;            // The tile composed
+    int tileWidth, tileHeight;  // Size the tile was composed at (0 if unused)
+} tileStamp_t;
+
+// Number of slots in a tileStamps_t table (a power of two)
+#define kTileStampSlots 1024
+
+// The tiles composed for map views, shared between all views of the same 
+// sprites (see mapDisp.c)
+typedef struct tileStamps_s {
+    tileStamp_t * slots;    // Hash table of stamps (NULL until first used)
+    drawPair_t * cells;     // The composed tile of each slot (row major, in
+                            // one block, so stamping never allocates)
+    unsigned slotCells;     // Cells set aside for each slot
+    unsigned nUsed;         // Number of slots in use
+    unsigned gen;           // Bumped whenever the cached stamps go stale
+} tileStamps_t;
+
 typedef struct tileData_s {
     dispData_t dispData;    // The underlying dispBase data store
+
+    int tileWidth;          // Width of a tile in characters
+    int tileHeight;         // Height of a tile in characters
     
     // Base Layer Definitions
     sprite_t emptyBase;     // The empty tile background sprite
@@ -46,7 +87,14 @@ typedef struct tileData_s {
 
     // Sprite Layer definitions
     list_t spriteList;      // The list of sprites to use
+    spriteIndex_t spriteIndex;  // Index over spriteList (see refreshSpriteIndex)
     sprite_t charSprite;    // The basic character sprite
+
+    // Scratch space for addMap
+    mapView_t view;         // The tiles last drawn
+    tileStamps_t stamps;    // Tiles composed for the view (and any viewports)
+    int * overflow;         // Visible tiles whose sprites spill out of the tile
+    unsigned overflowCap;   // Allocated length of overflow
 } tileData_t;
 
 //=============================<Data Allocation>==============================//
@@ -72,6 +120,28 @@ tile_t mkEmptyTile();
  */
 int loadTileData(tileData_t * data);
 
+/**
+ * Loads a tile data struct with tiles of the given size
+ * 
+ * @param data A return pointer for the tile data struct
+ * @param width The width of a tile in characters
+ * @param height The height of a tile in characters
+ * 
+ * @return 0 on success, <0 on failure
+ */
+int loadTileDataDim(tileData_t * data, int width, int height);
+
+/**
+ * Changes the size of the tiles, keeping the loaded sprite list
+ * 
+ * @param data The tile data struct to resize
+ * @param width The new width of a tile in characters
+ * @param height The new height of a tile in characters
+ * 
+ * @return 0 on success, <0 on failure (leaving the tiles unchanged)
+ */
+int resizeTileData(tileData_t * data, int width, int height);
+
 /**
  * Frees all of the allocated data from the tileData struct
  * 
@@ -120,7 +190,27 @@ int getSpriteIdx(tile_t tile);
  * 
  * @return 0 on success, < 0 on failure
  */
-int setSpriteIdx(tileData_t data, tile_t* tile, int idx);
+int setSpriteIdx(const tileData_t * data, tile_t* tile, int idx);
+
+/**
+ * Rebuilds the tile data's sprite index (call whenever spriteList changes)
+ * 
+ * @param data The tile data struct to re-index
+ * 
+ * @return 0 on success, < 0 on failure
+ */
+int refreshSpriteIndex(tileData_t * data);
+
+/**
+ * Gets a sprite from the tile data's sprite list by index (in constant time 
+ * while the sprite index is up to date)
+ * 
+ * @param data The tile data struct to read from
+ * @param idx The index of the sprite
+ * 
+ * @return The loaded sprite (NULL on invalid index or failure to load)
+ */
+sprite_t * getTileSprite(const tileData_t * data, int idx);
 
 /**
  * Removes any sprite from the provided tile
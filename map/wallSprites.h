@@ -4,6 +4,16 @@
 #define kTileHeight 5
 #define kTileWidth  9
 
+// Alternate tile sizes (tiles may be resized at runtime)
+#define kCompactTileHeight  2
+#define kCompactTileWidth   3
+#define kLargeTileHeight    7
+#define kLargeTileWidth     15
+
+#define kMinTileHeight      2
+#define kMinTileWidth       2
+#define kMaxTileWidth       64  // One bit per column in the compositor's masks
+
 #define kEmptyPalette   1
 #define kBasePalette    2
 #define kWallPalette    1